@@ -85,6 +85,8 @@ QcMapItem::QcMapItem(QQuickItem * parent)
     m_plugin_layers.insert(plugin_name, make_plugin_layers(plugin_name));
 
   connect(m_map_view, &QcMapView::scene_graph_changed, this, &QQuickItem::update);
+  // Schedule a frame, the viewport changes are flushed in afterAnimating
+  connect(m_viewport, &QcViewport::frame_requested, this, &QQuickItem::update);
   connect(location_circle_data(), &QcLocationCircleData::bearing_changed, this, &QQuickItem::update);
 
   // Fixme: remove
@@ -439,6 +441,16 @@ QcMapItem::set_zoom_level(unsigned int new_zoom_level)
   emit zoom_levelChanged(new_zoom_level);
 }
 
+void
+QcMapItem::set_zoom_settle_interval(int interval)
+{
+  if (interval == zoom_settle_interval())
+    return;
+
+  m_map_view->set_zoom_settle_interval(interval);
+  emit zoom_settle_intervalChanged(zoom_settle_interval());
+}
+
 void
 QcMapItem::set_center_qt(const QGeoCoordinate & coordinate)
 {
@@ -518,6 +530,25 @@ QcMapItem::geometryChanged(const QRectF & new_geometry, const QRectF & old_geome
   m_viewport->set_viewport_size(viewport_size, window()->devicePixelRatio());
 }
 
+/* Deliver the viewport changes once per frame.
+ *
+ * afterAnimating is emitted on the GUI thread after the animations were advanced and before the
+ * synchronisation, thus the pan of a touch move and of a flick are merged in one scene update.
+ */
+void
+QcMapItem::itemChange(ItemChange change, const ItemChangeData & value)
+{
+  if (change == ItemSceneChange) {
+    disconnect(m_frame_connection);
+    if (value.window)
+      m_frame_connection = connect(value.window, &QQuickWindow::afterAnimating,
+                                   m_viewport, &QcViewport::flush_changes);
+    m_viewport->set_frame_driven(value.window != nullptr);
+  }
+
+  QQuickItem::itemChange(change, value);
+}
+
 QSGNode *
 QcMapItem::updatePaintNode(QSGNode * old_node, UpdatePaintNodeData *)
 {
@@ -541,6 +572,10 @@ QcMapItem::updatePaintNode(QSGNode * old_node, UpdatePaintNodeData *)
   if (content and root->childCount() == 0)
     root->appendChildNode(content);
 
+  // Schedule a new frame to upload the textures left over by the budget
+  if (m_map_view->has_pending_uploads())
+    QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+
   return root;
 }
 
@@ -69,6 +69,8 @@ class QcMapItem : public QQuickItem
   Q_PROPERTY(QStringList projections READ projections CONSTANT)
   Q_PROPERTY(QcMapEventRouter * event_router READ event_router CONSTANT)
   Q_PROPERTY(QcMapPathEditor * path_editor READ path_editor CONSTANT)
+  Q_PROPERTY(QcFrameStatistics * frame_statistics READ frame_statistics CONSTANT)
+  Q_PROPERTY(int zoom_settle_interval READ zoom_settle_interval WRITE set_zoom_settle_interval NOTIFY zoom_settle_intervalChanged)
 
 public:
   Q_INVOKABLE static QcWgsCoordinate cast_QGeoCoordinate(const QGeoCoordinate & coordinate) {
@@ -106,6 +108,11 @@ public:
 
   QcLocationCircleData * location_circle_data();
   QcMapPathEditor * path_editor() { return m_path_editor; }
+  QcFrameStatistics * frame_statistics() { return m_map_view->frame_statistics(); }
+
+  // Delay of the tile fetches after a pinch or wheel zoom step [ms], 0 disables it
+  int zoom_settle_interval() const { return m_map_view->zoom_settle_interval(); }
+  void set_zoom_settle_interval(int interval);
 
   Q_INVOKABLE QcMapScale make_scale(unsigned int max_length_px) const;
 
@@ -147,6 +154,7 @@ signals:
   void zoom_levelChanged(int zoom_level);
   void centerChanged(const QcWgsCoordinate & coordinate);
   void bearingChanged(double bearing);
+  void zoom_settle_intervalChanged(int interval);
   void gps_horizontal_precisionChanged(double horizontal_precision);
 
 protected:
@@ -163,6 +171,7 @@ protected:
 
   void componentComplete() Q_DECL_OVERRIDE ;
   void geometryChanged(const QRectF & new_geometry, const QRectF & old_geometry) Q_DECL_OVERRIDE ;
+  void itemChange(ItemChange change, const ItemChangeData & value) Q_DECL_OVERRIDE ;
   QSGNode * updatePaintNode(QSGNode * old_node, UpdatePaintNodeData *) Q_DECL_OVERRIDE ;
 
 private slots:
@@ -183,6 +192,7 @@ private:
   QcMapEventRouter m_event_router;
   QcMapView * m_map_view;
   QcViewport * m_viewport; // ???
+  QMetaObject::Connection m_frame_connection; // flush the viewport changes after the animations
   QHash<QString, QVariantList> m_plugin_layers;
 };
 
@@ -41,6 +41,7 @@
 #include "map/map_event_router.h"
 #include "map/map_path_editor.h"
 #include "map/path_property.h"
+#include "tools/frame_statistics.h"
 
 // QC_BEGIN_NAMESPACE
 
@@ -86,6 +87,9 @@ class QtCartoDeclarativeModule : public QQmlExtensionPlugin
       qmlRegisterUncreatableType<QcPathProperty>(uri, major, minor, "QcPathProperty",
                                                   QStringLiteral("QcPathProperty is not intended instantiable by developer."));
 
+      qmlRegisterUncreatableType<QcFrameStatistics>(uri, major, minor, "QcFrameStatistics",
+                                                    QStringLiteral("QcFrameStatistics is not intended instantiable by developer."));
+
       // QDeclarativeGeoMap
       qmlRegisterType<QcMapItem>(uri, major, minor, "QcMapItem");
 
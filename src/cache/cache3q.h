@@ -172,6 +172,11 @@ public:
   bool insert(const Key & key, QSharedPointer<T> object, int cost = 1);
   QSharedPointer<T> object(const Key & key) const;
   QSharedPointer<T> operator[](const Key & key) const;
+  // Unlike object, it doesn't change the popularity
+  inline bool contains(const Key & key) const {
+    Node * node = m_lookup.value(key, nullptr);
+    return node and node->queue != m_q1_evicted;
+  }
 
   void remove(const Key & key);
 
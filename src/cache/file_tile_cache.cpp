@@ -63,6 +63,8 @@
 /**************************************************************************************************/
 
 #include "file_tile_cache.h"
+#include "qoi_image.h"
+#include "tile_buffer_pool.h"
 #include "tile_image.h"
 
 #include <QDebug>
@@ -70,6 +72,7 @@
 #include <QMetaType>
 #include <QPixmap>
 #include <QStandardPaths>
+#include <QThreadPool>
 
 // Q_DECLARE_METATYPE(QList<QcTileSpec>)
 // Q_DECLARE_METATYPE(QcTileSpecSet)
@@ -91,6 +94,8 @@ public:
   ~QcCachedTileMemory() {
     if (cache)
       cache->evict_from_memory_cache(this);
+    // recycled if nobody else holds it
+    QcTileBufferPool::instance().release(bytes);
   }
 
   QcTileSpec tile_spec;
@@ -127,6 +132,31 @@ QcCachedTileDisk::~QcCachedTileDisk()
 
 /**************************************************************************************************/
 
+QcTileTranscoder::QcTileTranscoder(const QcTileSpec & tile_spec, const QByteArray & bytes, const QString & filename)
+  : QObject(),
+    QRunnable(),
+    m_tile_spec(tile_spec),
+    m_bytes(bytes),
+    m_filename(filename)
+{
+  setAutoDelete(false); // deleted by the cache
+}
+
+void
+QcTileTranscoder::run()
+{
+  // Decode at full depth, the 16-bit mode is applied when the transcoded tile is read
+  QImage image;
+  if (image.loadFromData(m_bytes)) {
+    m_transcoded_bytes = encode_qoi_image(image);
+    write_tile_image(m_filename, m_transcoded_bytes);
+  }
+  m_bytes.clear();
+  emit finished();
+}
+
+/**************************************************************************************************/
+
 // Fixme: export
 constexpr int KILO = 1000;
 constexpr int KILO2 = 1024;
@@ -134,6 +164,8 @@ constexpr int MEGA = KILO * KILO;
 constexpr int MEGA2 = KILO2 * KILO2;
 
 constexpr int MAX_DISK_USAGE = 512 * MEGA2;
+// A quarter of the disk usage is given to the transcoded files
+constexpr int TRANSCODED_DISK_USAGE_DIVISOR = 4;
 constexpr int MAX_MEMORY_USAGE = 128 * MEGA2;
 constexpr int EXTRA_TEXTURE_USAGE = 16 * MEGA2;
 
@@ -144,7 +176,9 @@ constexpr int NUMBER_OF_QUEUES = 4;
 QcFileTileCache::QcFileTileCache(const QString & directory)
   : QObject(),
     m_offline_cache(nullptr),
-    m_directory(directory), m_min_texture_usage(0), m_extra_texture_usage(0)
+    m_directory(directory), m_min_texture_usage(0), m_extra_texture_usage(0),
+    m_16_bit_textures(false),
+    m_transcoding_format(NoTranscoding)
 {
   const QString base_path = base_cache_directory();
 
@@ -196,6 +230,17 @@ QcFileTileCache::~QcFileTileCache()
   delete m_offline_cache;
 }
 
+QString
+QcFileTileCache::transcoding_suffix(TranscodingFormat format)
+{
+  switch (format) {
+  case QoiTranscoding:
+    return QStringLiteral("qoi");
+  default:
+    return QString();
+  }
+}
+
 QString
 QcFileTileCache::base_cache_directory()
 {
@@ -251,9 +296,12 @@ QcFileTileCache::clear_all()
   m_texture_cache.clear();
   m_memory_cache.clear();
   m_disk_cache.clear();
+  m_transcoded_cache.clear();
+  m_decode_counts.clear();
+  m_pending_transcodings.clear(); // pending transcoded files are removed when they are written
 
   QStringList string_list;
-  string_list << QLatin1Literal("*-*-*-*.*"); // tile pattern
+  string_list << QLatin1Literal("*-*-*-*.*"); // tile pattern, original and transcoded files
   string_list << QLatin1Literal("queue?");
   QDir directory(m_directory);
   directory.setNameFilters(string_list);
@@ -313,12 +361,17 @@ QcFileTileCache::load_tiles()
   // this is a backup, in case the queue manifest files get deleted or out of sync due to
   // the application not closing down properly
   // Fixme: or for off-line cache
+  // Transcoded files are not serialized, their disk usage is bounded again on load
+  const QString qoi_suffix = transcoding_suffix(QoiTranscoding);
   for (const auto & relative_filename : files) {
     QcTileSpec tile_spec = filename_to_tile_spec(relative_filename);
     if (tile_spec.level() == -1)
       continue;
     QString filename = directory.filePath(relative_filename);
-    add_to_disk_cache(tile_spec, filename);
+    if (QFileInfo(relative_filename).suffix() == qoi_suffix)
+      add_to_transcoded_cache(tile_spec, filename);
+    else
+      add_to_disk_cache(tile_spec, filename);
   }
 }
 
@@ -339,19 +392,21 @@ QcFileTileCache::handle_error(const QcTileSpec & tile_spec, const QString & erro
 void
 QcFileTileCache::set_max_disk_usage(int disk_usage)
 {
-  m_disk_cache.set_max_cost(disk_usage);
+  int transcoded_disk_usage = disk_usage / TRANSCODED_DISK_USAGE_DIVISOR;
+  m_disk_cache.set_max_cost(disk_usage - transcoded_disk_usage);
+  m_transcoded_cache.set_max_cost(transcoded_disk_usage);
 }
 
 int
 QcFileTileCache::max_disk_usage() const
 {
-  return m_disk_cache.max_cost();
+  return m_disk_cache.max_cost() + m_transcoded_cache.max_cost();
 }
 
 int
 QcFileTileCache::disk_usage() const
 {
-  return m_disk_cache.total_cost();
+  return m_disk_cache.total_cost() + m_transcoded_cache.total_cost();
 }
 
 void
@@ -404,6 +459,33 @@ QcFileTileCache::texture_usage() const
   return m_texture_cache.total_cost();
 }
 
+QSharedPointer<QcTileTexture>
+QcFileTileCache::get_from_memory(const QcTileSpec & tile_spec)
+{
+  // Try texture cache
+  QSharedPointer<QcTileTexture> tile_texture = m_texture_cache.object(tile_spec);
+  if (tile_texture)
+    return tile_texture;
+
+  // Try memory cache
+  QSharedPointer<QcCachedTileMemory> tile_memory = m_memory_cache.object(tile_spec);
+  if (tile_memory)
+    return load_from_memory(tile_memory);
+
+  // else
+  return QSharedPointer<QcTileTexture>();
+}
+
+QByteArray
+QcFileTileCache::memory_bytes(const QcTileSpec & tile_spec) const
+{
+  QSharedPointer<QcCachedTileMemory> tile_memory = m_memory_cache.object(tile_spec);
+  if (tile_memory)
+    return tile_memory->bytes;
+  else
+    return QByteArray();
+}
+
 QSharedPointer<QcTileTexture>
 QcFileTileCache::get(const QcTileSpec & tile_spec)
 {
@@ -412,6 +494,15 @@ QcFileTileCache::get(const QcTileSpec & tile_spec)
   if (tile_texture)
     return tile_texture;
 
+  // Try the fast-decode form of a hot tile before its original bytes held by the memory tier
+  QSharedPointer<QcCachedTileDisk> transcoded_file = m_transcoded_cache.object(tile_spec);
+  if (transcoded_file) {
+    tile_texture = load_from_disk(tile_spec, transcoded_file->filename);
+    if (tile_texture)
+      return tile_texture;
+    m_transcoded_cache.remove(tile_spec); // removed or corrupted
+  }
+
   // Try memory cache
   QSharedPointer<QcCachedTileMemory> tile_memory = m_memory_cache.object(tile_spec);
   if (tile_memory)
@@ -446,10 +537,13 @@ QcFileTileCache::load_from_disk(const QcTileSpec & tile_spec, const QString & fi
   QByteArray bytes = read_tile_image(filename);
 
   // Load PNG, JPEG from bytes
-  QImage image;
-  if (image.loadFromData(bytes)) {
+  QImage image = decode_image(bytes, m_16_bit_textures);
+  if (!image.isNull()) {
     const QString format = QFileInfo(filename).suffix();
-    add_to_memory_cache(tile_spec, bytes, format);
+    // The memory tier holds the compact original bytes, a transcoded file is read on each texture miss
+    if (format != transcoding_suffix(QoiTranscoding))
+      add_to_memory_cache(tile_spec, bytes, format);
+    count_decode(tile_spec, bytes, format);
 
     QSharedPointer<QcTileTexture> tile_texture = add_to_texture_cache(tile_spec, image);
     if (tile_texture) // Fixme: when ? memory overflow ?
@@ -467,8 +561,9 @@ QcFileTileCache::load_from_memory(const QSharedPointer<QcCachedTileMemory> & til
   const QcTileSpec & tile_spec = tile_memory->tile_spec;
 
   // Fixme: duplicated code, excepted add_to_memory_cache
-  QImage image;
-  if (image.loadFromData(tile_memory->bytes)) {
+  QImage image = decode_image(tile_memory->bytes, m_16_bit_textures);
+  if (!image.isNull()) {
+    count_decode(tile_spec, tile_memory->bytes, tile_memory->format);
     QSharedPointer<QcTileTexture> tile_texture = add_to_texture_cache(tile_spec, image);
     if (tile_texture)
       return tile_texture;
@@ -506,6 +601,12 @@ QcFileTileCache::insert(const QcTileSpec & tile_spec, const QByteArray & bytes,
 void
 QcFileTileCache::evict_from_disk_cache(QcCachedTileDisk * tile_directory)
 {
+  // A transcoded file is a copy of the original, thus it can always be removed
+  if (tile_directory->format == transcoding_suffix(QoiTranscoding)) {
+    QFile::remove(tile_directory->filename);
+    return;
+  }
+
   qWarning() << "evict_from_disk_cache disabled";
   // QFile::remove(tile_directory->filename);
 }
@@ -523,18 +624,34 @@ QcFileTileCache::add_to_disk_cache(const QcTileSpec & tile_spec, const QString
   tile_directory->cache = this;
 
   QFileInfo file_info(filename);
-  int disk_cost = filename.size();
+  int disk_cost = file_info.size();
   m_disk_cache.insert(tile_spec, tile_directory, disk_cost);
   return tile_directory;
 }
 
+void
+QcFileTileCache::add_to_transcoded_cache(const QcTileSpec & tile_spec, const QString & filename)
+{
+  QSharedPointer<QcCachedTileDisk> tile_directory(new QcCachedTileDisk);
+  tile_directory->tile_spec = tile_spec;
+  tile_directory->filename = filename;
+  tile_directory->format = QFileInfo(filename).suffix();
+  tile_directory->cache = this;
+
+  int disk_cost = QFileInfo(filename).size();
+  if (!m_transcoded_cache.insert(tile_spec, tile_directory, disk_cost)) {
+    tile_directory->cache = nullptr;
+    QFile::remove(filename); // larger than the budget
+  }
+}
+
 QSharedPointer<QcCachedTileMemory>
 QcFileTileCache::add_to_memory_cache(const QcTileSpec & tile_spec, const QByteArray & bytes, const QString & format)
 {
   QSharedPointer<QcCachedTileMemory> tile_memory(new QcCachedTileMemory);
   tile_memory->tile_spec = tile_spec;
   tile_memory->cache = this;
-  tile_memory->bytes = bytes;
+  tile_memory->bytes = bytes; // shared, not copied
   tile_memory->format = format;
 
   int cost = bytes.size();
@@ -543,6 +660,33 @@ QcFileTileCache::add_to_memory_cache(const QcTileSpec & tile_spec, const QByteAr
   return tile_memory;
 }
 
+QImage
+QcFileTileCache::decode_image(const QByteArray & bytes, bool use_16_bit)
+{
+  // An opaque QOI image is decoded in place to the 32-bit upload format
+  if (is_qoi_image(bytes)) {
+    QImage image = decode_qoi_image(bytes, use_16_bit ? QImage::Format_RGBX8888 : QcTileTexture::FORMAT);
+    if (use_16_bit and image.format() == QImage::Format_RGBX8888)
+      image = image.convertToFormat(QcTileTexture::FORMAT_16_BIT);
+    else if (image.format() == QImage::Format_RGBA8888)
+      image = image.convertToFormat(QcTileTexture::FORMAT);
+    return image;
+  }
+
+  QImage image;
+  if (!image.loadFromData(bytes))
+    return QImage();
+
+  // Image plugins choose the decoded format, e.g. RGB32 for a JPEG or an indexed format for a PNG,
+  // thus the image is converted here once instead of on the render thread at each upload
+  QImage::Format format = QcTileTexture::FORMAT;
+  if (use_16_bit and !image.hasAlphaChannel())
+    format = QcTileTexture::FORMAT_16_BIT;
+  if (image.format() != format)
+    image = image.convertToFormat(format);
+  return image;
+}
+
 QSharedPointer<QcTileTexture>
 QcFileTileCache::add_to_texture_cache(const QcTileSpec & tile_spec, const QImage & image)
 {
@@ -556,6 +700,56 @@ QcFileTileCache::add_to_texture_cache(const QcTileSpec & tile_spec, const QImage
   return tile_texture;
 }
 
+/* Count the decodes of a tile from its original form and transcode it in the background once it is
+ * hot.  A tile is decoded again each time it is evicted from the texture tier.
+ */
+void
+QcFileTileCache::count_decode(const QcTileSpec & tile_spec, const QByteArray & bytes, const QString & format)
+{
+  const QString suffix = transcoding_suffix(m_transcoding_format);
+  if (suffix.isEmpty() or format == suffix or
+      m_transcoded_cache.contains(tile_spec) or m_pending_transcodings.contains(tile_spec))
+    return;
+
+  if (m_decode_counts.size() >= MAXIMUM_NUMBER_OF_DECODE_COUNTS)
+    m_decode_counts.clear();
+  int & count = m_decode_counts[tile_spec];
+  if (++count < TRANSCODING_THRESHOLD)
+    return;
+  m_decode_counts.remove(tile_spec);
+
+  QString filename = tile_spec_to_filename(tile_spec, suffix, m_directory);
+  auto * transcoder = new QcTileTranscoder(tile_spec, bytes, filename);
+  m_pending_transcodings.insert(tile_spec);
+  connect(transcoder, &QcTileTranscoder::finished, transcoder, &QObject::deleteLater);
+  connect(transcoder, &QcTileTranscoder::finished, this, [this, transcoder]() {
+      on_transcoded(transcoder);
+    });
+  QThreadPool::globalInstance()->start(transcoder);
+}
+
+void
+QcFileTileCache::on_transcoded(QcTileTranscoder * transcoder)
+{
+  const QcTileSpec & tile_spec = transcoder->tile_spec();
+  const QByteArray & bytes = transcoder->transcoded_bytes();
+
+  // The cache was cleared in the meantime
+  if (!m_pending_transcodings.remove(tile_spec)) {
+    if (!bytes.isEmpty())
+      QFile::remove(transcoder->filename());
+    return;
+  }
+
+  if (bytes.isEmpty()) {
+    handle_error(tile_spec, QLatin1Literal("Problem with tile transcoding"));
+    return;
+  }
+
+  // The memory tier keeps the original bytes, the transcoded file is read first on a texture miss
+  add_to_transcoded_cache(tile_spec, transcoder->filename());
+}
+
 /**************************************************************************************************/
 
 // #include "file_tile_cache.moc"
@@ -71,9 +71,11 @@
 
 #include <QCache>
 #include <QDir>
+#include <QHash>
 #include <QImage>
 #include <QMutex>
 #include <QObject>
+#include <QRunnable>
 #include <QSet>
 #include <QTimer>
 
@@ -93,6 +95,11 @@ class QcFileTileCache;
 
 class QC_EXPORT QcTileTexture
 {
+ public:
+  // Formats uploaded by the tile atlas as is
+  static constexpr QImage::Format FORMAT = QImage::Format_RGBA8888_Premultiplied;
+  static constexpr QImage::Format FORMAT_16_BIT = QImage::Format_RGB16; // RGB565
+
  public:
   QcTileTexture();
   ~QcTileTexture();
@@ -131,10 +138,54 @@ class QCache3QTileEvictionPolicy : public QcCache3QDefaultEvictionPolicy<QcTileS
 
 /**************************************************************************************************/
 
+/*! Transcode a tile to a fast-decode form in the thread pool and write it to a file.
+ *
+ * The encoded bytes are shared, thus they can be released by the cache in the meantime.
+ */
+class QcTileTranscoder : public QObject, public QRunnable
+{
+  Q_OBJECT
+
+ public:
+  QcTileTranscoder(const QcTileSpec & tile_spec, const QByteArray & bytes, const QString & filename);
+
+  void run() override;
+
+  const QcTileSpec & tile_spec() const { return m_tile_spec; }
+  const QString & filename() const { return m_filename; }
+  // Transcoded bytes, empty on error
+  const QByteArray & transcoded_bytes() const { return m_transcoded_bytes; }
+
+ signals:
+  void finished();
+
+ private:
+  QcTileSpec m_tile_spec;
+  QByteArray m_bytes;
+  QString m_filename;
+  QByteArray m_transcoded_bytes;
+};
+
+/**************************************************************************************************/
+
 class QC_EXPORT QcFileTileCache : public QObject
 {
   Q_OBJECT
 
+ public:
+  // Fast-decode form of the hot tiles, stored alongside the original file
+  enum TranscodingFormat {
+    NoTranscoding,
+    QoiTranscoding,
+  };
+
+  // A tile is transcoded once it was decoded as many times from its original file
+  static constexpr int TRANSCODING_THRESHOLD = 3;
+  // Decode counts are reset when the table is full, thus cold tiles rarely reach the threshold
+  static constexpr int MAXIMUM_NUMBER_OF_DECODE_COUNTS = 4096;
+
+  static QString transcoding_suffix(TranscodingFormat format);
+
  public:
   QcFileTileCache(const QString & directory = QString());
   ~QcFileTileCache();
@@ -153,9 +204,29 @@ class QC_EXPORT QcFileTileCache : public QObject
   int min_texture_usage() const;
   int texture_usage() const;
 
+  /* Store the opaque tiles in RGB565 in the texture tier, it holds twice as many tiles at the cost
+   * of the colour depth.  Tiles having an alpha channel are kept in 32-bit.
+   */
+  void set_16_bit_textures(bool enabled) { m_16_bit_textures = enabled; }
+  bool has_16_bit_textures() const { return m_16_bit_textures; }
+
+  void set_transcoding_format(TranscodingFormat format) { m_transcoding_format = format; }
+  TranscodingFormat transcoding_format() const { return m_transcoding_format; }
+  // Return true if a fast-decode file is available for the tile
+  bool contains_transcoded(const QcTileSpec & tile_spec) const { return m_transcoded_cache.contains(tile_spec); }
+
+  // Decode a PNG, JPEG or QOI image to a format uploaded by the tile atlas as is, null on error
+  static QImage decode_image(const QByteArray & bytes, bool use_16_bit = false);
+
   void clear_all();
 
   QSharedPointer<QcTileTexture> get(const QcTileSpec & tile_spec);
+  // Look only in the texture and memory tiers
+  QSharedPointer<QcTileTexture> get_from_memory(const QcTileSpec & tile_spec);
+  // Look only in the texture tier, never decode
+  QSharedPointer<QcTileTexture> get_texture(const QcTileSpec & tile_spec) { return m_texture_cache.object(tile_spec); }
+  // Return the encoded image held by the memory tier, null if missing
+  QByteArray memory_bytes(const QcTileSpec & tile_spec) const;
   // QSharedPointer<QcTileTexture> load_from_disk(const QSharedPointer<QcCachedTileDisk> & tile_directory);
   QSharedPointer<QcTileTexture> load_from_disk(const QcTileSpec & tile_spec, const QString & filename);
 
@@ -183,17 +254,26 @@ class QC_EXPORT QcFileTileCache : public QObject
   QSharedPointer<QcTileTexture> load_from_memory(const QSharedPointer<QcCachedTileMemory> & tile_memory);
 
   QSharedPointer<QcCachedTileDisk> add_to_disk_cache(const QcTileSpec & tile_spec, const QString & filename);
+  void add_to_transcoded_cache(const QcTileSpec & tile_spec, const QString & filename);
   QSharedPointer<QcCachedTileMemory> add_to_memory_cache(const QcTileSpec & tile_spec, const QByteArray & bytes, const QString & format);
   QSharedPointer<QcTileTexture> add_to_texture_cache(const QcTileSpec & tile_spec, const QImage & image);
 
+  void count_decode(const QcTileSpec & tile_spec, const QByteArray & bytes, const QString & format);
+  void on_transcoded(QcTileTranscoder * transcoder);
+
  private:
   QcOfflineTileCache * m_offline_cache;
   QcCache3Q<QcTileSpec, QcCachedTileDisk, QCache3QTileEvictionPolicy > m_disk_cache; // Store image on disk
+  QcCache3Q<QcTileSpec, QcCachedTileDisk, QCache3QTileEvictionPolicy > m_transcoded_cache; // Store fast-decode image on disk
   QcCache3Q<QcTileSpec, QcCachedTileMemory > m_memory_cache; // Store encoded images on memory : PNG, JPEG
   QcCache3Q<QcTileSpec, QcTileTexture > m_texture_cache; // Store decoded images
   QString m_directory;
   int m_min_texture_usage;
   int m_extra_texture_usage;
+  bool m_16_bit_textures;
+  TranscodingFormat m_transcoding_format;
+  QHash<QcTileSpec, int> m_decode_counts;
+  QSet<QcTileSpec> m_pending_transcodings;
 };
 
 // QC_END_NAMESPACE
@@ -65,7 +65,8 @@ QcOfflineCachedTileDisk::operator=(const QcOfflineCachedTileDisk & other)
 
 QcOfflineTileCache::QcOfflineTileCache(const QString & directory)
   : m_directory(directory),
-    m_database(nullptr)
+    m_database(nullptr),
+    m_in_batch(false)
 {
   QDir::root().mkpath(m_directory);
   QString sqlite_file_path = QDir(directory).absoluteFilePath(QStringLiteral("offline_cache.sqlite"));
@@ -124,7 +125,7 @@ QcOfflineTileCache::load_tiles()
 bool
 QcOfflineTileCache::contains(const QcTileSpec & tile_spec) const
 {
-  qInfo() << tile_spec;
+  // qInfo() << tile_spec;
 
   return m_database->has_tile(tile_spec) > 0;
 
@@ -173,6 +174,22 @@ QcOfflineTileCache::insert(const QcTileSpec & tile_spec, const QByteArray & byte
   m_database->insert_tile(tile_spec);
 }
 
+void
+QcOfflineTileCache::begin_batch()
+{
+  if (!m_in_batch)
+    m_in_batch = m_database->begin_transaction();
+}
+
+void
+QcOfflineTileCache::end_batch()
+{
+  if (m_in_batch) {
+    m_database->commit();
+    m_in_batch = false;
+  }
+}
+
 void
 QcOfflineTileCache::add_to_disk_cache(const QcTileSpec & tile_spec, const QString & filename)
 {
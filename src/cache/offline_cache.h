@@ -82,6 +82,13 @@ class QC_EXPORT QcOfflineTileCache // : public QObject
   QcOfflineCachedTileDisk get(const QcTileSpec & tile_spec); //  const
   void insert(const QcTileSpec & tile_spec, const QByteArray & bytes, const QString & format);
 
+  // Batch the database updates of the following inserts in one transaction
+  void begin_batch();
+  void end_batch();
+  inline bool in_batch() const { return m_in_batch; }
+
+  QcOfflineCacheDatabase * database() { return m_database; }
+
  private:
   void load_tiles();
   void add_to_disk_cache(const QcTileSpec & tile_spec, const QString & filename);
@@ -89,6 +96,7 @@ class QC_EXPORT QcOfflineTileCache // : public QObject
  private:
   QString m_directory;
   QcOfflineCacheDatabase * m_database;
+  bool m_in_batch;
   // QHash<QcTileSpec, QSharedPointer<QcOfflineCachedTileDisk>> m_offline_cache;
   QHash<QcTileSpec, QcOfflineCachedTileDisk> m_offline_cache;
 };
@@ -66,10 +66,17 @@ QcOfflineCacheDatabase::QcOfflineCacheDatabase(QString sqlite_path)
     create_tables();
   else
     init_cache();
+
+  prepare_tile_queries();
 }
 
 QcOfflineCacheDatabase::~QcOfflineCacheDatabase()
 {
+  // Release the prepared queries before the connection
+  m_select_tile_query = QSqlQuery();
+  m_insert_tile_query = QSqlQuery();
+  m_update_tile_query = QSqlQuery();
+  m_delete_tile_query = QSqlQuery();
   m_database.close();
 }
 
@@ -79,6 +86,15 @@ QcOfflineCacheDatabase::new_query() const
   return QSqlQuery(m_database);
 }
 
+bool
+QcOfflineCacheDatabase::begin_transaction()
+{
+  bool status = m_database.transaction();
+  if (!status)
+    qWarning() << m_database.lastError().text();
+  return status;
+}
+
 bool
 QcOfflineCacheDatabase::commit()
 {
@@ -249,10 +265,26 @@ QcOfflineCacheDatabase::create_tables()
     if (!query.exec(sql_query))
       qWarning() << query.lastError().text();
 
+  create_checkpoint_table();
   init_version();
   commit();
 }
 
+void
+QcOfflineCacheDatabase::create_checkpoint_table()
+{
+  // Added after version 1, thus it is also created on existing databases
+  const QString checkpoint_schema =
+    "CREATE TABLE IF NOT EXISTS checkpoint ("
+    "name TEXT PRIMARY KEY, "
+    "run INTEGER"
+    ")";
+
+  QSqlQuery query = new_query();
+  if (!query.exec(checkpoint_schema))
+    qWarning() << query.lastError().text();
+}
+
 void
 QcOfflineCacheDatabase::init_version()
 {
@@ -264,6 +296,7 @@ QcOfflineCacheDatabase::init_version()
 void
 QcOfflineCacheDatabase::init_cache()
 {
+  create_checkpoint_table();
   load_providers();
   load_map_levels();
 }
@@ -352,73 +385,117 @@ QcOfflineCacheDatabase::get_map_level_id(const QcTileSpec & tile_spec)
   }
 }
 
-QString
-QcOfflineCacheDatabase::tile_where_clause(const QcTileSpec & tile_spec)
+void
+QcOfflineCacheDatabase::prepare_tile_queries()
 {
-  int map_level_id = get_map_level_id(tile_spec);
-  KeyValuePair kwargs;
-  kwargs.insert(MAP_LEVEL_ID, map_level_id);
-  kwargs.insert(ROW, tile_spec.x());
-  kwargs.insert(COLUMN, tile_spec.y());
-  return format_simple_where(kwargs);
+  m_select_tile_query = new_query();
+  m_select_tile_query.prepare(QStringLiteral("SELECT offline_count FROM tile "
+                                             "WHERE map_level_id = ? AND row = ? AND column = ?"));
+  m_insert_tile_query = new_query();
+  m_insert_tile_query.prepare(QStringLiteral("INSERT INTO tile (map_level_id, row, column, offline_count) "
+                                             "VALUES (?, ?, ?, 1)"));
+  m_update_tile_query = new_query();
+  m_update_tile_query.prepare(QStringLiteral("UPDATE tile SET offline_count = ? "
+                                             "WHERE map_level_id = ? AND row = ? AND column = ?"));
+  m_delete_tile_query = new_query();
+  m_delete_tile_query.prepare(QStringLiteral("DELETE FROM tile "
+                                             "WHERE map_level_id = ? AND row = ? AND column = ?"));
+}
+
+void
+QcOfflineCacheDatabase::bind_tile(QSqlQuery & query, const QcTileSpec & tile_spec, int first_index)
+{
+  query.bindValue(first_index, get_map_level_id(tile_spec));
+  query.bindValue(first_index + 1, tile_spec.x());
+  query.bindValue(first_index + 2, tile_spec.y());
+}
+
+void
+QcOfflineCacheDatabase::exec_tile_query(QSqlQuery & query)
+{
+  if (!query.exec())
+    qWarning() << query.lastError().text();
+}
+
+int
+QcOfflineCacheDatabase::tile_offline_count(const QcTileSpec & tile_spec)
+{
+  bind_tile(m_select_tile_query, tile_spec);
+  exec_tile_query(m_select_tile_query);
+  int offline_count = 0;
+  if (m_select_tile_query.next())
+    offline_count = m_select_tile_query.value(0).toInt();
+  m_select_tile_query.finish(); // keep the prepared statement
+  return offline_count;
 }
 
 int
 QcOfflineCacheDatabase::has_tile(const QcTileSpec & tile_spec)
 {
-  QSqlRecord record = select_one(TILE, QStringList(OFFLINE_COUNT), tile_where_clause(tile_spec));
-  if (record.isEmpty())
-    return 0;
-  else
-    return record.value(0).toInt();
+  return tile_offline_count(tile_spec);
 }
 
 void
 QcOfflineCacheDatabase::insert_tile(const QcTileSpec & tile_spec)
 {
-  QString where = tile_where_clause(tile_spec);
-  QSqlRecord record = select_one(TILE, QStringList(OFFLINE_COUNT), where);
-  if (record.isEmpty()) {
-    int map_level_id = get_map_level_id(tile_spec);
-    KeyValuePair kwargs;
-    kwargs.insert(MAP_LEVEL_ID, map_level_id);
-    kwargs.insert(ROW, tile_spec.x());
-    kwargs.insert(COLUMN, tile_spec.y());
-    kwargs.insert(OFFLINE_COUNT, 1);
-    insert(TILE, kwargs);
+  int offline_count = tile_offline_count(tile_spec);
+  if (!offline_count) {
+    bind_tile(m_insert_tile_query, tile_spec);
+    exec_tile_query(m_insert_tile_query);
   } else {
-    int offline_count = record.value(0).toInt();
-    KeyValuePair kwargs;
-    kwargs.insert(OFFLINE_COUNT, offline_count +1);
-    update(TILE, kwargs, where);
+    m_update_tile_query.bindValue(0, offline_count + 1);
+    bind_tile(m_update_tile_query, tile_spec, 1);
+    exec_tile_query(m_update_tile_query);
   }
 }
 
-/*
 void
-QcOfflineCacheDatabase::update_tile_offline_count(const QcTileSpec & tile_spec, int offline_count)
+QcOfflineCacheDatabase::delete_tile(const QcTileSpec & tile_spec)
 {
-  KeyValuePair kwargs;
-  kwargs.insert(OFFLINE_COUNT, offline_count);
-  update(TILE, kwargs, tile_where_clause(tile_spec));
+  int offline_count = tile_offline_count(tile_spec);
+  if (offline_count > 1) {
+    m_update_tile_query.bindValue(0, offline_count - 1);
+    bind_tile(m_update_tile_query, tile_spec, 1);
+    exec_tile_query(m_update_tile_query);
+  } else if (offline_count == 1) {
+    bind_tile(m_delete_tile_query, tile_spec);
+    exec_tile_query(m_delete_tile_query);
+  }
 }
-*/
 
 void
-QcOfflineCacheDatabase::delete_tile(const QcTileSpec & tile_spec)
+QcOfflineCacheDatabase::set_checkpoint(const QString & name, int run)
 {
-  QString where = tile_where_clause(tile_spec);
-  QSqlRecord record = select_one(TILE, QStringList(OFFLINE_COUNT), where);
-  if (!record.isEmpty()) {
-    int offline_count = record.value(0).toInt();
-    if (offline_count > 1) {
-      KeyValuePair kwargs;
-      kwargs.insert(OFFLINE_COUNT, offline_count -1);
-      update(TILE, kwargs, where);
-    }
-    else
-      delete_row(TILE, where);
-  }
+  QSqlQuery query = new_query();
+  query.prepare(QStringLiteral("INSERT OR REPLACE INTO checkpoint (name, run) VALUES (?, ?)"));
+  query.addBindValue(name);
+  query.addBindValue(run);
+  if (!query.exec())
+    qWarning() << query.lastError().text();
+}
+
+int
+QcOfflineCacheDatabase::checkpoint(const QString & name)
+{
+  QSqlQuery query = new_query();
+  query.prepare(QStringLiteral("SELECT run FROM checkpoint WHERE name = ?"));
+  query.addBindValue(name);
+  if (!query.exec())
+    qWarning() << query.lastError().text();
+  if (query.next())
+    return query.value(0).toInt();
+  else
+    return -1;
+}
+
+void
+QcOfflineCacheDatabase::delete_checkpoint(const QString & name)
+{
+  QSqlQuery query = new_query();
+  query.prepare(QStringLiteral("DELETE FROM checkpoint WHERE name = ?"));
+  query.addBindValue(name);
+  if (!query.exec())
+    qWarning() << query.lastError().text();
 }
 
 /**************************************************************************************************/
@@ -59,12 +59,20 @@ public:
   int has_tile(const QcTileSpec & tile_spec);
   void delete_tile(const QcTileSpec & tile_spec);
 
+  // Batch several writes in one transaction
+  bool begin_transaction();
+  bool commit();
+
+  // Resume point of a bulk download: every tile before run is stored
+  void set_checkpoint(const QString & name, int run);
+  int checkpoint(const QString & name); // return -1 if there is no checkpoint
+  void delete_checkpoint(const QString & name);
+
 private:
   typedef QHash<QString, QVariant> KeyValuePair;
 
 private:
   QSqlQuery new_query() const;
-  bool commit();
   QString format_kwarg(const KeyValuePair & kwargs, const QString & sperator = QStringLiteral(","));
   QString format_simple_where(const KeyValuePair & kwargs);
   QSqlQuery select(const QString & table, const QStringList & fields, const QString & where = QStringLiteral(""));
@@ -73,6 +81,7 @@ private:
   QSqlQuery update(const QString & table, const KeyValuePair & kwargs, const QString & where = QStringLiteral(""));
   QSqlQuery delete_row(const QString & table, const QString & where);
   void create_tables();
+  void create_checkpoint_table();
   void init_cache();
   void load_providers();
   void load_map_levels();
@@ -80,10 +89,18 @@ private:
   int get_provider_id(const QString & provider);
   unsigned int hash_tile_spec(int provider_id, int map_id, int level);
   int get_map_level_id(const QcTileSpec & tile_spec);
-  QString tile_where_clause(const QcTileSpec & tile_spec);
+  void prepare_tile_queries();
+  void bind_tile(QSqlQuery & query, const QcTileSpec & tile_spec, int first_index = 0);
+  void exec_tile_query(QSqlQuery & query);
+  int tile_offline_count(const QcTileSpec & tile_spec); // return 0 if the tile is missing
 
 private:
   QSqlDatabase m_database;
+  // Tile queries are run for each tile of a bulk download, thus they are prepared once
+  QSqlQuery m_select_tile_query;
+  QSqlQuery m_insert_tile_query;
+  QSqlQuery m_update_tile_query;
+  QSqlQuery m_delete_tile_query;
   QHash<QString, int> m_providers;
   QHash<unsigned int, int> m_map_levels;
 };
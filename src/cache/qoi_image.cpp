@@ -0,0 +1,279 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#include "qoi_image.h"
+
+#include <climits>
+#include <cstring>
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+constexpr int QOI_HEADER_SIZE = 14;
+constexpr int QOI_PADDING_SIZE = 8;
+constexpr char QOI_MAGIC[] = "qoif";
+constexpr char QOI_PADDING[QOI_PADDING_SIZE] = {0, 0, 0, 0, 0, 0, 0, 1};
+// Upper bound from the specification
+constexpr quint64 QOI_MAXIMUM_NUMBER_OF_PIXELS = 400000000;
+
+constexpr quint8 QOI_OP_INDEX = 0x00;
+constexpr quint8 QOI_OP_DIFF = 0x40;
+constexpr quint8 QOI_OP_LUMA = 0x80;
+constexpr quint8 QOI_OP_RUN = 0xc0;
+constexpr quint8 QOI_OP_RGB = 0xfe;
+constexpr quint8 QOI_OP_RGBA = 0xff;
+constexpr quint8 QOI_MASK = 0xc0;
+
+constexpr int QOI_MAXIMUM_RUN = 62;
+
+struct QcQoiPixel
+{
+  quint8 r = 0;
+  quint8 g = 0;
+  quint8 b = 0;
+  quint8 a = 0;
+
+  inline bool operator==(const QcQoiPixel & other) const {
+    return r == other.r and g == other.g and b == other.b and a == other.a;
+  }
+  inline bool operator!=(const QcQoiPixel & other) const { return !(*this == other); }
+
+  inline int hash() const { return (r * 3 + g * 5 + b * 7 + a * 11) % 64; }
+};
+
+static inline void
+write_32(quint8 * data, quint32 value)
+{
+  data[0] = value >> 24;
+  data[1] = value >> 16;
+  data[2] = value >> 8;
+  data[3] = value;
+}
+
+static inline quint32
+read_32(const quint8 * data)
+{
+  return (quint32(data[0]) << 24) | (quint32(data[1]) << 16) | (quint32(data[2]) << 8) | data[3];
+}
+
+/**************************************************************************************************/
+
+bool
+is_qoi_image(const QByteArray & bytes)
+{
+  return bytes.size() >= QOI_HEADER_SIZE + QOI_PADDING_SIZE and
+    std::memcmp(bytes.constData(), QOI_MAGIC, 4) == 0;
+}
+
+QByteArray
+encode_qoi_image(const QImage & image)
+{
+  if (image.isNull())
+    return QByteArray();
+
+  int width = image.width();
+  int height = image.height();
+  quint8 channels = image.hasAlphaChannel() ? 4 : 3;
+  const QImage rgba_image = image.convertToFormat(QImage::Format_RGBA8888);
+
+  // Worst case is one RGBA op per pixel
+  QByteArray bytes(QOI_HEADER_SIZE + width * height * (channels + 1) + QOI_PADDING_SIZE, Qt::Uninitialized);
+  quint8 * data = reinterpret_cast<quint8 *>(bytes.data());
+  int p = 0;
+
+  std::memcpy(data, QOI_MAGIC, 4);
+  write_32(data + 4, width);
+  write_32(data + 8, height);
+  data[12] = channels;
+  data[13] = 0; // sRGB with linear alpha
+  p += QOI_HEADER_SIZE;
+
+  QcQoiPixel index[64];
+  QcQoiPixel previous_pixel;
+  previous_pixel.a = 255;
+  int run = 0;
+
+  for (int y = 0; y < height; y++) {
+    const quint8 * line = rgba_image.constScanLine(y);
+    for (int x = 0; x < width; x++) {
+      QcQoiPixel pixel;
+      pixel.r = line[0];
+      pixel.g = line[1];
+      pixel.b = line[2];
+      pixel.a = line[3];
+      line += 4;
+
+      if (pixel == previous_pixel) {
+        run++;
+        if (run == QOI_MAXIMUM_RUN) {
+          data[p++] = QOI_OP_RUN | (run - 1);
+          run = 0;
+        }
+        continue;
+      }
+
+      if (run) {
+        data[p++] = QOI_OP_RUN | (run - 1);
+        run = 0;
+      }
+
+      int index_position = pixel.hash();
+      if (index[index_position] == pixel)
+        data[p++] = QOI_OP_INDEX | index_position;
+      else {
+        index[index_position] = pixel;
+        if (pixel.a == previous_pixel.a) {
+          qint8 vr = pixel.r - previous_pixel.r;
+          qint8 vg = pixel.g - previous_pixel.g;
+          qint8 vb = pixel.b - previous_pixel.b;
+          qint8 vg_r = vr - vg;
+          qint8 vg_b = vb - vg;
+          if (vr > -3 and vr < 2 and
+              vg > -3 and vg < 2 and
+              vb > -3 and vb < 2)
+            data[p++] = QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2);
+          else if (vg_r > -9 and vg_r < 8 and
+                   vg > -33 and vg < 32 and
+                   vg_b > -9 and vg_b < 8) {
+            data[p++] = QOI_OP_LUMA | (vg + 32);
+            data[p++] = (vg_r + 8) << 4 | (vg_b + 8);
+          } else {
+            data[p++] = QOI_OP_RGB;
+            data[p++] = pixel.r;
+            data[p++] = pixel.g;
+            data[p++] = pixel.b;
+          }
+        } else {
+          data[p++] = QOI_OP_RGBA;
+          data[p++] = pixel.r;
+          data[p++] = pixel.g;
+          data[p++] = pixel.b;
+          data[p++] = pixel.a;
+        }
+      }
+
+      previous_pixel = pixel;
+    }
+  }
+
+  if (run)
+    data[p++] = QOI_OP_RUN | (run - 1);
+
+  std::memcpy(data + p, QOI_PADDING, QOI_PADDING_SIZE);
+  p += QOI_PADDING_SIZE;
+
+  bytes.resize(p);
+  return bytes;
+}
+
+QImage
+decode_qoi_image(const QByteArray & bytes, QImage::Format opaque_format)
+{
+  if (!is_qoi_image(bytes))
+    return QImage();
+
+  const quint8 * data = reinterpret_cast<const quint8 *>(bytes.constData());
+  quint32 width = read_32(data + 4);
+  quint32 height = read_32(data + 8);
+  quint8 channels = data[12];
+  if (!width or !height or
+      quint64(width) * height > QOI_MAXIMUM_NUMBER_OF_PIXELS or
+      width > INT_MAX or height > INT_MAX or
+      (channels != 3 and channels != 4))
+    return QImage();
+
+  QImage::Format format = channels == 4 ? QImage::Format_RGBA8888 : opaque_format;
+  QImage image(width, height, format);
+  if (image.isNull())
+    return image;
+
+  int p = QOI_HEADER_SIZE;
+  int chunks_end = bytes.size() - QOI_PADDING_SIZE;
+
+  QcQoiPixel index[64];
+  QcQoiPixel pixel;
+  pixel.a = 255;
+  int run = 0;
+
+  for (quint32 y = 0; y < height; y++) {
+    quint8 * line = image.scanLine(y);
+    for (quint32 x = 0; x < width; x++) {
+      if (run)
+        run--;
+      else if (p < chunks_end) {
+        quint8 b1 = data[p++];
+        if (b1 == QOI_OP_RGB) {
+          pixel.r = data[p++];
+          pixel.g = data[p++];
+          pixel.b = data[p++];
+        } else if (b1 == QOI_OP_RGBA) {
+          pixel.r = data[p++];
+          pixel.g = data[p++];
+          pixel.b = data[p++];
+          pixel.a = data[p++];
+        } else if ((b1 & QOI_MASK) == QOI_OP_INDEX)
+          pixel = index[b1];
+        else if ((b1 & QOI_MASK) == QOI_OP_DIFF) {
+          pixel.r += ((b1 >> 4) & 0x03) - 2;
+          pixel.g += ((b1 >> 2) & 0x03) - 2;
+          pixel.b += (b1 & 0x03) - 2;
+        } else if ((b1 & QOI_MASK) == QOI_OP_LUMA) {
+          quint8 b2 = data[p++];
+          int vg = (b1 & 0x3f) - 32;
+          pixel.r += vg - 8 + ((b2 >> 4) & 0x0f);
+          pixel.g += vg;
+          pixel.b += vg - 8 + (b2 & 0x0f);
+        } else if ((b1 & QOI_MASK) == QOI_OP_RUN)
+          run = b1 & 0x3f;
+        index[pixel.hash()] = pixel;
+      } else
+        return QImage(); // truncated stream
+
+      line[0] = pixel.r;
+      line[1] = pixel.g;
+      line[2] = pixel.b;
+      line[3] = channels == 4 ? pixel.a : 255;
+      line += 4;
+    }
+  }
+
+  return image;
+}
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
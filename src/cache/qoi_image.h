@@ -0,0 +1,72 @@
+// -*- mode: c++ -*-
+
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#ifndef __QOI_IMAGE_H__
+#define __QOI_IMAGE_H__
+
+/**************************************************************************************************/
+
+#include <QByteArray>
+#include <QImage>
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/* Codec for the "Quite OK Image" format, see https://qoiformat.org
+ *
+ * QOI is lossless and decodes several times faster than PNG at the cost of a larger file, thus it
+ * is used to store the hot tiles in a fast-decode form.
+ */
+
+// Return true if bytes start with a QOI header
+bool is_qoi_image(const QByteArray & bytes);
+
+// Encode an image, the alpha channel is dropped if the image is opaque
+QByteArray encode_qoi_image(const QImage & image);
+
+/* Decode an image to RGBA8888, null on error.
+ *
+ * An opaque image is tagged with opaque_format, which must have the RGBX8888 byte layout,
+ * e.g. RGBA8888_Premultiplied to skip a conversion.
+ */
+QImage decode_qoi_image(const QByteArray & bytes, QImage::Format opaque_format = QImage::Format_RGBX8888);
+
+// QC_END_NAMESPACE
+
+/**************************************************************************************************/
+
+#endif /* __QOI_IMAGE_H__ */
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -0,0 +1,114 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#include "tile_buffer_pool.h"
+
+#include <QMutexLocker>
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+QcTileBufferPool::QcTileBufferPool()
+  : m_mutex(),
+    m_buffers(),
+    m_number_of_allocations(0),
+    m_number_of_reuses(0)
+{}
+
+QcTileBufferPool::~QcTileBufferPool()
+{}
+
+QByteArray
+QcTileBufferPool::acquire(qint64 size)
+{
+  int capacity;
+  if (size <= 0)
+    capacity = DEFAULT_BUFFER_CAPACITY;
+  else
+    capacity = static_cast<int>(qMin(size, qint64(MAXIMUM_BUFFER_CAPACITY)));
+
+  {
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < m_buffers.size(); i++) {
+      if (m_buffers[i].capacity() >= capacity) {
+        m_number_of_reuses++;
+        return m_buffers.takeAt(i);
+      }
+    }
+    m_number_of_allocations++;
+  }
+
+  QByteArray buffer;
+  buffer.reserve(capacity);
+  return buffer;
+}
+
+void
+QcTileBufferPool::release(QByteArray & buffer)
+{
+  // A shared buffer is still in use, e.g. by the memory cache
+  if (buffer.isDetached() and buffer.capacity() <= MAXIMUM_BUFFER_CAPACITY) {
+    buffer.resize(0); // keep the reserved capacity
+    if (buffer.capacity()) {
+      QMutexLocker locker(&m_mutex);
+      if (m_buffers.size() < MAXIMUM_NUMBER_OF_BUFFERS)
+        m_buffers << buffer;
+    }
+  }
+
+  buffer = QByteArray();
+}
+
+void
+QcTileBufferPool::clear()
+{
+  QMutexLocker locker(&m_mutex);
+  m_buffers.clear();
+  m_number_of_allocations = 0;
+  m_number_of_reuses = 0;
+}
+
+int
+QcTileBufferPool::number_of_buffers() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_buffers.size();
+}
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -0,0 +1,115 @@
+// -*- mode: c++ -*-
+
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#ifndef __TILE_BUFFER_POOL_H__
+#define __TILE_BUFFER_POOL_H__
+
+/**************************************************************************************************/
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+
+#include "qtcarto_global.h"
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+/*! Pool of reusable buffers for encoded tile payloads.
+ *
+ * A buffer is acquired with a capacity large enough for the expected payload, e.g. the
+ * Content-Length of a reply or the size of a file, thus it can be filled without any
+ * reallocation.  This size comes from outside, it is thus clamped to MAXIMUM_BUFFER_CAPACITY,
+ * and a larger payload grows the buffer as usual.  The buffer is then passed by (implicitly
+ * shared) value to the disk writer, the memory cache and the decoder, and must not be modified
+ * after it is filled.
+ *
+ * A buffer is only recycled when nobody else holds a reference on it.
+ */
+class QC_EXPORT QcTileBufferPool
+{
+ public:
+  static constexpr int MAXIMUM_NUMBER_OF_BUFFERS = 64;
+  // Don't preallocate nor retain large buffers, a tile is usually less than 100 kB
+  static constexpr int MAXIMUM_BUFFER_CAPACITY = 1024 * 1024;
+  // Used when the payload size is unknown
+  static constexpr int DEFAULT_BUFFER_CAPACITY = 32 * 1024;
+
+ public:
+  static QcTileBufferPool & instance() {
+    // Thread-safe in C++11
+    static QcTileBufferPool m_instance;
+    return m_instance;
+  }
+
+  QcTileBufferPool(QcTileBufferPool const &) = delete;
+  QcTileBufferPool & operator=(QcTileBufferPool const &) = delete;
+  QcTileBufferPool(QcTileBufferPool &&) = delete;
+  QcTileBufferPool & operator=(QcTileBufferPool &&) = delete;
+
+  // Return an empty buffer having a capacity of at least size bytes, up to MAXIMUM_BUFFER_CAPACITY
+  QByteArray acquire(qint64 size);
+  // Give back a buffer, it is left empty
+  void release(QByteArray & buffer);
+
+  void clear();
+
+  int number_of_buffers() const;
+  // Statistics
+  int number_of_allocations() const { return m_number_of_allocations; }
+  int number_of_reuses() const { return m_number_of_reuses; }
+
+ private:
+  QcTileBufferPool();
+  ~QcTileBufferPool();
+
+ private:
+  mutable QMutex m_mutex;
+  QList<QByteArray> m_buffers;
+  int m_number_of_allocations;
+  int m_number_of_reuses;
+};
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/**************************************************************************************************/
+
+#endif /* __TILE_BUFFER_POOL_H__ */
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
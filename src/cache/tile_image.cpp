@@ -27,6 +27,7 @@
 /**************************************************************************************************/
 
 #include "tile_image.h"
+#include "tile_buffer_pool.h"
 
 #include <QDir>
 #include <QFile>
@@ -100,9 +101,14 @@ QByteArray
 read_tile_image(const QString & filename)
 {
   QFile file(filename);
-  file.open(QIODevice::ReadOnly);
-  // Fixme: efficient ?
-  QByteArray data = file.readAll();
+  if (!file.open(QIODevice::ReadOnly))
+    return QByteArray();
+  // Read the file in a pooled buffer preallocated from its size
+  qint64 size = file.size();
+  QByteArray data = QcTileBufferPool::instance().acquire(size);
+  data.resize(size);
+  qint64 number_of_read_bytes = file.read(data.data(), size);
+  data.resize(qMax(number_of_read_bytes, qint64(0)));
   file.close();
   return data;
 }
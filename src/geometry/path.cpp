@@ -105,34 +105,106 @@ QcTriangleVertex::operator=(const QcTriangleVertex & other)
   return *this;
 }
 
-QcPolygonTriangulation::QcPolygonTriangulation(const QcPathDouble & path)
-  : m_path(path)
+// Return true if point lies within the bounding box of the collinear segment [p1, p2]
+static inline bool
+is_within(const QcVectorDouble & p1, const QcVectorDouble & p2, const QcVectorDouble & point)
 {
-  int number_of_vertexes = path.number_of_vertexes();
-  int number_of_segments = number_of_vertexes -2; // Fixme: true ?
-
-  double vertexes[number_of_vertexes][2];
-  int i = 0;
-  for (const auto & vertex : path.vertexes()) {
-    qInfo() << vertex;
-    vertexes[i][0] = vertex.x();
-    vertexes[i][1] = vertex.y();
-    i++;
-  }
+  return qMin(p1.x(), p2.x()) <= point.x() and point.x() <= qMax(p1.x(), p2.x()) and
+    qMin(p1.y(), p2.y()) <= point.y() and point.y() <= qMax(p1.y(), p2.y());
+}
 
-  int triangles[number_of_segments][3];
-  for (int i = 0; i < number_of_segments; i++) {
-    for (int j = 0; j < 3; j++)
-      triangles[i][j] = 0;
+/* Return true if the segments [p1, p2] and [p3, p4] intersect or touch.
+ *
+ * QcSegment::intersect reports collinear points lying outside the segments.
+ */
+static bool
+intersect(const QcVectorDouble & p1, const QcVectorDouble & p2,
+          const QcVectorDouble & p3, const QcVectorDouble & p4)
+{
+  double d1 = (p4 - p3).cross(p1 - p3);
+  double d2 = (p4 - p3).cross(p2 - p3);
+  double d3 = (p2 - p1).cross(p3 - p1);
+  double d4 = (p2 - p1).cross(p4 - p1);
+
+  if (((d1 > 0 and d2 < 0) or (d1 < 0 and d2 > 0)) and
+      ((d3 > 0 and d4 < 0) or (d3 < 0 and d4 > 0)))
+    return true;
+
+  return (d1 == 0 and is_within(p3, p4, p1)) or
+    (d2 == 0 and is_within(p3, p4, p2)) or
+    (d3 == 0 and is_within(p1, p2, p3)) or
+    (d4 == 0 and is_within(p1, p2, p4));
+}
+
+// Edges sharing a vertex are not tested
+static bool
+is_self_intersecting(const QcPathDouble::VertexListType & vertexes)
+{
+  int number_of_vertexes = vertexes.size();
+  for (int i = 0; i < number_of_vertexes; i++) {
+    const QcVectorDouble & p1 = vertexes[i];
+    const QcVectorDouble & p2 = vertexes[(i + 1) % number_of_vertexes];
+    for (int j = i + 2; j < number_of_vertexes; j++) {
+      if (i == 0 and j == number_of_vertexes - 1)
+        continue;
+      if (intersect(p1, p2, vertexes[j], vertexes[(j + 1) % number_of_vertexes]))
+        return true;
+    }
   }
+  return false;
+}
 
-  QcSeidlerPolygonTriangulation triangulation(number_of_vertexes, vertexes, triangles);
+QcPolygonTriangulation::QcPolygonTriangulation(const QcPathDouble & path)
+  : m_path(path)
+{
+  static_assert(MAXIMUM_NUMBER_OF_VERTEXES < SEGSIZE, "Seidel tables are too small");
+
+  const QcPathDouble::VertexListType & path_vertexes = path.vertexes();
+  int number_of_vertexes = path_vertexes.size();
+  if (number_of_vertexes < 3 or number_of_vertexes > MAXIMUM_NUMBER_OF_VERTEXES)
+    return;
+  if (is_self_intersecting(path_vertexes))
+    return;
+
+  // The Seidel implementation requires an anticlockwise polygon
+  double area = 0;
+  for (int i = 0; i < number_of_vertexes; i++)
+    area += path_vertexes[i].cross(path_vertexes[(i + 1) % number_of_vertexes]);
+  if (area == 0)
+    return;
+  bool clockwise = area < 0;
+  auto to_path_index = [number_of_vertexes, clockwise](int i) {
+    return clockwise ? number_of_vertexes - 1 - i : i;
+  };
+
+  // Arrays are indexed from 1
+  QVector<double> vertexes(2 * (number_of_vertexes + 1), 0);
+  for (int i = 0; i < number_of_vertexes; i++) {
+    const QcVectorDouble & vertex = path_vertexes[to_path_index(i)];
+    vertexes[2 * (i + 1)] = vertex.x();
+    vertexes[2 * (i + 1) + 1] = vertex.y();
+  }
 
-  for (int i = 0; i < number_of_segments; i++) {
-    qInfo() << triangles[i][0] << triangles[i][1] << triangles[i][2];
-    m_triangles << QcTriangleIndex(triangles[i][0] -1,
-                                   triangles[i][1] -1,
-                                   triangles[i][2] -1);
+  int number_of_triangles = number_of_vertexes - 2;
+  QVector<int> triangles(3 * number_of_triangles, 0);
+
+  // The tables are too large for the stack
+  QcSeidlerPolygonTriangulation * triangulation =
+    new QcSeidlerPolygonTriangulation(number_of_vertexes,
+                                      reinterpret_cast<double (*)[2]>(vertexes.data()),
+                                      reinterpret_cast<int (*)[3]>(triangles.data()));
+  delete triangulation;
+
+  for (int i = 0; i < number_of_triangles; i++) {
+    const int * triangle = &triangles[3 * i];
+    // An index is null if the triangulation failed
+    if (!triangle[0] or !triangle[1] or !triangle[2]) {
+      m_triangles.clear();
+      return;
+    }
+    m_triangles << QcTriangleIndex(to_path_index(triangle[0] -1),
+                                   to_path_index(triangle[1] -1),
+                                   to_path_index(triangle[2] -1));
   }
 }
 
@@ -140,18 +212,23 @@ QList<QcTriangleVertex>
 QcPolygonTriangulation::triangle_vertexes() const
 {
   QList<QcTriangleVertex> triangle_vertexes;
-  for (const auto & triangle: m_triangles) {
-    qInfo() << triangle.p1 << triangle.p2 << triangle.p3;
-    qInfo() << m_path.vertex_at(triangle.p1);
-    qInfo() << m_path.vertex_at(triangle.p2);
-    qInfo() << m_path.vertex_at(triangle.p3);
+  for (const auto & triangle: m_triangles)
     triangle_vertexes << QcTriangleVertex(m_path.vertex_at(triangle.p1),
                                           m_path.vertex_at(triangle.p2),
                                           m_path.vertex_at(triangle.p3));
-  }
   return triangle_vertexes;
 }
 
+QVector<quint16>
+QcPolygonTriangulation::index_buffer() const
+{
+  QVector<quint16> indexes;
+  indexes.reserve(3 * m_triangles.size());
+  for (const auto & triangle: m_triangles)
+    indexes << triangle.p1 << triangle.p2 << triangle.p3;
+  return indexes;
+}
+
 /***************************************************************************************************
  *
  * End
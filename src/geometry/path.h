@@ -163,16 +163,30 @@ public:
   QcVectorDouble p3;
 };
 
+/*! Triangulation of a simple polygon using the Seidel algorithm.
+ *
+ * The triangle indexes refer to the path vertexes.  The triangulation is empty if the polygon is
+ * degenerated, self-intersecting or too large.
+ */
 class QC_EXPORT QcPolygonTriangulation
 {
+ public:
+  // Limited by the tables of the Seidel implementation
+  static constexpr int MAXIMUM_NUMBER_OF_VERTEXES = 1023;
+
  public:
   QcPolygonTriangulation(const QcPathDouble & path);
 
+  const QcPathDouble & path() const { return m_path; }
+  bool is_empty() const { return m_triangles.isEmpty(); }
+
   const QList<QcTriangleIndex> & triangle_indexes() const { return m_triangles; }
   QList<QcTriangleVertex> triangle_vertexes() const;
+  // Index buffer for GL_TRIANGLES
+  QVector<quint16> index_buffer() const;
 
  private:
-  const QcPathDouble & m_path;
+  QcPathDouble m_path;
   QList<QcTriangleIndex> m_triangles;
 };
 
@@ -0,0 +1,134 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include "path_pyramid.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+/**************************************************************************************************/
+
+// Distance of a point to the segment [a, b]
+static double
+distance_to_segment(const QcVectorDouble & point, const QcVectorDouble & a, const QcVectorDouble & b)
+{
+  QcVectorDouble direction = b - a;
+  double length_square = direction.dot(direction);
+  if (length_square == 0)
+    return (point - a).magnitude();
+  double t = qBound(0., (point - a).dot(direction) / length_square, 1.);
+  return (point - (a + direction * t)).magnitude();
+}
+
+/**************************************************************************************************/
+
+QcPathPyramid::QcPathPyramid(const QcPathDouble & path, double coarsest_tolerance, int number_of_levels)
+  : m_coarsest_tolerance(coarsest_tolerance)
+{
+  if (coarsest_tolerance <= 0)
+    throw std::invalid_argument("tolerance must be positive");
+
+  const QcPathDouble::VertexListType & vertexes = path.vertexes();
+  compute_weights(vertexes);
+
+  m_levels.resize(number_of_levels);
+  int number_of_vertexes = m_weights.size();
+  for (int i = 0; i < number_of_levels; i++) {
+    double level_tolerance = tolerance(i);
+    QVector<int> & indexes = m_levels[i];
+    for (int j = 0; j < number_of_vertexes; j++)
+      if (m_weights[j] > level_tolerance)
+        indexes << j;
+  }
+}
+
+void
+QcPathPyramid::compute_weights(const QcPathDouble::VertexListType & vertexes)
+{
+  int number_of_vertexes = vertexes.size();
+  m_weights.fill(.0, number_of_vertexes);
+  if (!number_of_vertexes)
+    return;
+
+  // End points are always retained
+  constexpr double infinity = std::numeric_limits<double>::infinity();
+  m_weights[0] = infinity;
+  m_weights[number_of_vertexes -1] = infinity;
+
+  // Iterative Douglas–Peucker, an interval is split at its farthest vertex
+  struct Interval {
+    int first;
+    int last;
+    double weight; // weight of the vertex which split the parent interval
+  };
+  QVector<Interval> stack;
+  stack << Interval{0, number_of_vertexes -1, infinity};
+  while (!stack.isEmpty()) {
+    Interval interval = stack.takeLast();
+    if (interval.last - interval.first < 2)
+      continue;
+    const QcVectorDouble & a = vertexes[interval.first];
+    const QcVectorDouble & b = vertexes[interval.last];
+    int farthest = interval.first + 1;
+    double maximum_distance = -1;
+    for (int i = interval.first + 1; i < interval.last; i++) {
+      double distance = distance_to_segment(vertexes[i], a, b);
+      if (distance > maximum_distance) {
+        maximum_distance = distance;
+        farthest = i;
+      }
+    }
+    double weight = qMin(maximum_distance, interval.weight);
+    m_weights[farthest] = weight;
+    stack << Interval{interval.first, farthest, weight};
+    stack << Interval{farthest, interval.last, weight};
+  }
+}
+
+int
+QcPathPyramid::level_for_tolerance(double tolerance_) const
+{
+  // tolerance(level) <= tolerance  <=>  level >= log2(coarsest / tolerance)
+  if (tolerance_ <= 0)
+    return -1;
+  int level = qMax(0, int(std::ceil(std::log2(m_coarsest_tolerance / tolerance_))));
+  // Fix rounding errors
+  while (level > 0 and tolerance(level -1) <= tolerance_)
+    level--;
+  while (level < number_of_levels() and tolerance(level) > tolerance_)
+    level++;
+  return level < number_of_levels() ? level : -1;
+}
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
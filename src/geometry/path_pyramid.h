@@ -0,0 +1,95 @@
+// -*- mode: c++ -*-
+
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#ifndef __PATH_PYRAMID_H__
+#define __PATH_PYRAMID_H__
+
+/**************************************************************************************************/
+
+#include <cmath>
+
+#include <QVector>
+
+#include "geometry/path.h"
+#include "qtcarto_global.h"
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+/*! Simplification pyramid of a path for a geometric series of tolerances.
+ *
+ * The tolerance is halved from one level to the next, like the resolution of a tile matrix set,
+ * thus the level 0 is the coarsest.  A level is given by the indexes of the retained vertexes, so
+ * as to look up the vertex attributes.
+ *
+ * The Douglas–Peucker algorithm is run once to assign a weight to each vertex, which is the
+ * tolerance below which the vertex is retained.  The weight of a vertex is bounded by the weight of
+ * the vertex which split its interval, thus the levels are nested.
+ */
+class QC_EXPORT QcPathPyramid
+{
+ public:
+  QcPathPyramid(const QcPathDouble & path, double coarsest_tolerance, int number_of_levels);
+
+  inline int number_of_vertexes() const { return m_weights.size(); }
+  inline int number_of_levels() const { return m_levels.size(); }
+  inline double tolerance(int level) const { return std::ldexp(m_coarsest_tolerance, -level); }
+  inline const QVector<int> & level(int level) const { return m_levels[level]; }
+
+  // Return the coarsest level which has a tolerance lower than the given one, -1 if the path must
+  // be used
+  int level_for_tolerance(double tolerance) const;
+
+ private:
+  void compute_weights(const QcPathDouble::VertexListType & vertexes);
+
+ private:
+  double m_coarsest_tolerance;
+  QVector<double> m_weights;
+  QVector<QVector<int>> m_levels;
+};
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/**************************************************************************************************/
+
+#endif /* __PATH_PYRAMID_H__ */
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
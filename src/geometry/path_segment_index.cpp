@@ -0,0 +1,111 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include "path_segment_index.h"
+
+/**************************************************************************************************/
+
+QcPathSegmentIndex::QcPathSegmentIndex()
+  : m_number_of_segments(0)
+{}
+
+void
+QcPathSegmentIndex::clear()
+{
+  m_number_of_segments = 0;
+  m_chunk_intervals.clear();
+}
+
+void
+QcPathSegmentIndex::build(const QVector<QcVectorDouble> & vertexes, bool closed)
+{
+  clear();
+
+  int number_of_vertexes = vertexes.size();
+  if (number_of_vertexes < 2)
+    return;
+  m_number_of_segments = closed ? number_of_vertexes : number_of_vertexes - 1;
+
+  int number_of_chunks = (m_number_of_segments + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  m_chunk_intervals.reserve(number_of_chunks);
+  for (int chunk = 0; chunk < number_of_chunks; chunk++) {
+    int first_vertex = chunk * CHUNK_SIZE;
+    int last_vertex = qMin(first_vertex + CHUNK_SIZE, m_number_of_segments); // end of the last segment
+    const QcVectorDouble & first = vertexes[first_vertex];
+    double x_inf = first.x(), x_sup = first.x();
+    double y_inf = first.y(), y_sup = first.y();
+    for (int i = first_vertex + 1; i <= last_vertex; i++) {
+      const QcVectorDouble & vertex = vertexes[i % number_of_vertexes];
+      x_inf = qMin(x_inf, vertex.x());
+      x_sup = qMax(x_sup, vertex.x());
+      y_inf = qMin(y_inf, vertex.y());
+      y_sup = qMax(y_sup, vertex.y());
+    }
+    m_chunk_intervals << QcInterval2DDouble(x_inf, x_sup, y_inf, y_sup);
+  }
+}
+
+void
+QcPathSegmentIndex::query(const QcInterval2DDouble & interval, QVector<QcIntervalInt> & segment_ranges) const
+{
+  QVector<QcInterval2DDouble> intervals;
+  intervals << interval;
+  query(intervals, segment_ranges);
+}
+
+void
+QcPathSegmentIndex::query(const QVector<QcInterval2DDouble> & intervals, QVector<QcIntervalInt> & segment_ranges) const
+{
+  // Chunks are visited in order, thus the ranges are sorted
+  int number_of_chunks = m_chunk_intervals.size();
+  for (int chunk = 0; chunk < number_of_chunks; chunk++) {
+    const QcInterval2DDouble & chunk_interval = m_chunk_intervals[chunk];
+    bool found = false;
+    for (const auto & interval : intervals)
+      if (!interval.is_empty() and chunk_interval.intersect(interval)) {
+        found = true;
+        break;
+      }
+    if (!found)
+      continue;
+
+    int first_segment = chunk * CHUNK_SIZE;
+    int last_segment = qMin(first_segment + CHUNK_SIZE, m_number_of_segments) - 1;
+    if (!segment_ranges.isEmpty() and segment_ranges.last().sup() + 1 == first_segment)
+      segment_ranges.last().set_sup(last_segment);
+    else
+      segment_ranges << QcIntervalInt(first_segment, last_segment);
+  }
+}
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
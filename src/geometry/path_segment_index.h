@@ -0,0 +1,94 @@
+// -*- mode: c++ -*-
+
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#ifndef __PATH_SEGMENT_INDEX_H__
+#define __PATH_SEGMENT_INDEX_H__
+
+/**************************************************************************************************/
+
+#include <QVector>
+
+#include "geometry/vector.h"
+#include "math/interval.h"
+#include "qtcarto_global.h"
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+/*! Spatial index of the segments of a path.
+ *
+ * Consecutive segments are grouped by chunks and the bounding box of each chunk is stored, a query
+ * returns the ranges of segments of the chunks intersecting an interval.  A chunk list is enough
+ * for a path since consecutive segments are spatially close, and it is built in linear time.
+ *
+ * The segment i goes from the vertex i to the vertex i+1, the last segment of a closed path goes
+ * back to the first vertex.
+ */
+class QC_EXPORT QcPathSegmentIndex
+{
+ public:
+  static constexpr int CHUNK_SIZE = 32; // segments
+
+ public:
+  QcPathSegmentIndex();
+
+  void build(const QVector<QcVectorDouble> & vertexes, bool closed);
+  void clear();
+
+  inline int number_of_segments() const { return m_number_of_segments; }
+  inline int number_of_chunks() const { return m_chunk_intervals.size(); }
+
+  // Append the ranges of segments which could intersect the interval, ranges are sorted and merged
+  void query(const QcInterval2DDouble & interval, QVector<QcIntervalInt> & segment_ranges) const;
+  // Same for several intervals, e.g. the viewport parts
+  void query(const QVector<QcInterval2DDouble> & intervals, QVector<QcIntervalInt> & segment_ranges) const;
+
+ private:
+  int m_number_of_segments;
+  QVector<QcInterval2DDouble> m_chunk_intervals;
+};
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/**************************************************************************************************/
+
+#endif /* __PATH_SEGMENT_INDEX_H__ */
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -202,39 +202,6 @@ to_grid(double x, double grid_step)
   return int(x / grid_step);
 }
 
-class OpenInterval
-{
-public:
-  OpenInterval(double x, int direction)
-    : x(x), direction(direction)
-  {}
-
-  OpenInterval(const OpenInterval & other)
-    : x(other.x), direction(other.direction)
-  {}
-
-  OpenInterval & operator=(const OpenInterval & other)
-  {
-    if (this != &other) {
-      x = other.x;
-      direction = other.direction;
-    }
-
-    return *this;
-  }
-
-  bool is_gap(const OpenInterval & other) const {
-    return other.direction < 0 && direction > 0 && (x - other.x) >= 2;
-  }
-
-  friend bool operator<(const OpenInterval & open_interval1, const OpenInterval & open_interval2) {
-    return open_interval1.x < open_interval2.x;
-  }
-
-  double x;
-  double direction;
-};
-
 QcTiledPolygon
 QcPolygon::intersec_with_grid(double grid_step) const {
   return QcTiledPolygon(*this, grid_step);
@@ -314,28 +281,39 @@ QcTiledPolygonRun::tile_indexes() const
 
 /**************************************************************************************************/
 
-QcTiledPolygon::QcTiledPolygon(const QcPolygon & polygon, double grid_step)
-  : m_polygon(polygon), m_grid_step(grid_step)
+/* Rasterise a polygon on a grid.
+ *
+ * The row buffers are reused, they are only enlarged when required.
+ */
+template <typename VertexList>
+static void
+rasterise_on_grid(const VertexList & vertexes, int number_of_vertexes, double grid_step,
+                  QVector<QVector<QcOpenInterval>> & rows, QcTiledPolygonRunList & runs)
 {
-  const QcPolygon::IntervalType & polygon_interval = polygon.interval();
-  const QcPolygon::VertexListType & vertexes = polygon.vertexes();
-
-  QcInterval2DInt interval_on_grid(to_grid(polygon_interval.x().inf(), grid_step),
-				   to_grid(polygon_interval.x().sup(), grid_step),
-				   to_grid(polygon_interval.y().inf(), grid_step),
-				   to_grid(polygon_interval.y().sup(), grid_step));
+  runs.resize(0);
+  if (!number_of_vertexes)
+    return;
+
+  double y_inf = vertexes[0].y();
+  double y_sup = y_inf;
+  for (int i = 1; i < number_of_vertexes; i++) {
+    y_inf = qMin(y_inf, vertexes[i].y());
+    y_sup = qMax(y_sup, vertexes[i].y());
+  }
 
-  int Y_min = interval_on_grid.y().inf();
-  int number_of_rows = interval_on_grid.y().length();
-  QVector<QList<OpenInterval>> rows(number_of_rows);
+  int Y_min = to_grid(y_inf, grid_step);
+  int number_of_rows = QcIntervalInt(Y_min, to_grid(y_sup, grid_step)).length();
+  if (rows.size() < number_of_rows)
+    rows.resize(number_of_rows);
+  for (int i = 0; i < number_of_rows; i++)
+    rows[i].resize(0); // keep the capacity
 
-  int number_of_vertexes = vertexes.size();
   for (int i = 0; i < number_of_vertexes; i++) {
-    const QcPolygon::VertexType & p0 = vertexes[i];
+    const QcVectorDouble & p0 = vertexes[i];
     int ii = i + 1;
     if (ii == number_of_vertexes)
       ii = 0;
-    const QcPolygon::VertexType & p1 = vertexes[ii];
+    const QcVectorDouble & p1 = vertexes[ii];
 
     double X0 = to_grid(p0.x(), grid_step);
     double Y0 = to_grid(p0.y(), grid_step);
@@ -346,7 +324,7 @@ QcTiledPolygon::QcTiledPolygon(const QcPolygon & polygon, double grid_step)
     QcLineDouble line = QcLineDouble::from_two_points(p0, p1);
 
     if (Y1 > Y0) {
-      rows[Y0 - Y_min].push_back(OpenInterval(X0, 1));
+      rows[Y0 - Y_min].push_back(QcOpenInterval(X0, 1));
       for (int Y = Y0 +1; Y < Y1 +1; Y++) {
 	double y = Y * grid_step;
 	double x = line.get_x_from_y(y);
@@ -354,13 +332,13 @@ QcTiledPolygon::QcTiledPolygon(const QcPolygon & polygon, double grid_step)
 	int YY = Y - Y_min;
 	if (X1 < X0)
 	  YY -= 1;
-	OpenInterval open_interval(X, 1);
+	QcOpenInterval open_interval(X, 1);
 	rows[YY].push_back(open_interval);
       }
-      rows[Y1 - Y_min].push_back(OpenInterval(X1, 1));
+      rows[Y1 - Y_min].push_back(QcOpenInterval(X1, 1));
     }
     else if (Y1 < Y0) {
-      rows[Y1 - Y_min].push_back(OpenInterval(X1, -1));
+      rows[Y1 - Y_min].push_back(QcOpenInterval(X1, -1));
       for (int Y = Y1 +1; Y < Y0 +1; Y++) {
 	double y = Y * grid_step;
 	double x = line.get_x_from_y(y);
@@ -368,98 +346,172 @@ QcTiledPolygon::QcTiledPolygon(const QcPolygon & polygon, double grid_step)
 	int YY = Y - Y_min;
 	if (X1 < X0)
 	  YY -= 1;
-	OpenInterval open_interval(X, -1);
+	QcOpenInterval open_interval(X, -1);
 	rows[YY].push_back(open_interval);
       }
-      rows[Y0 - Y_min].push_back(OpenInterval(X0, -1));
+      rows[Y0 - Y_min].push_back(QcOpenInterval(X0, -1));
     }
   }
   // qinfo() << "OpenInterval built";
 
   for (int i = 0; i < number_of_rows; i++) {
-    QList<OpenInterval> & row = rows[i];
+    QVector<QcOpenInterval> & row = rows[i];
     if (!row.size()) // Fixme: check
       continue;
     std::sort(row.begin(), row.end());
     int Y = Y_min + i;
-    OpenInterval previous_interval = row[0];
-    double x_inf = previous_interval.x;
-    QList<QcIntervalInt> intervals;
-    intervals.push_back(QcIntervalInt(x_inf, x_inf));
+    QcOpenInterval previous_interval = row[0];
+    int x_inf = previous_interval.x;
+    QcIntervalInt interval(x_inf, x_inf);
     int number_of_intervals = row.size();
     if (number_of_intervals > 1)
       for (int j = 1; j < number_of_intervals; j++) {
- 	const OpenInterval & open_interval = row[j];
+ 	const QcOpenInterval & open_interval = row[j];
 	// qinfo() << "i,j: " << i << j << open_interval.x << open_interval.direction;
 	if (open_interval.is_gap(previous_interval)) {
-	  double x_inf = open_interval.x;
-	  intervals.push_back(QcIntervalInt(x_inf, x_inf));
+	  runs.push_back(QcTiledPolygonRun(Y, interval));
+	  int x_inf = open_interval.x;
+	  interval = QcIntervalInt(x_inf, x_inf);
 	}
 	else {
-	  intervals.last().set_sup(open_interval.x);
+	  interval.set_sup(open_interval.x);
 	  previous_interval = open_interval;
 	}
       }
-    for (const QcIntervalInt & interval : intervals)
-      m_runs.push_back(QcTiledPolygonRun(Y, interval));
+    runs.push_back(QcTiledPolygonRun(Y, interval));
   }
 }
 
+QcTiledPolygon::QcTiledPolygon(const QcPolygon & polygon, double grid_step)
+  : m_polygon(polygon), m_grid_step(grid_step)
+{
+  QVector<QVector<QcOpenInterval>> rows;
+  const QcPolygon::VertexListType & vertexes = polygon.vertexes();
+  rasterise_on_grid(vertexes, vertexes.size(), grid_step, rows, m_runs);
+}
+
+/**************************************************************************************************/
+
+const QcTiledPolygonRunList &
+QcPolygonRasteriser::rasterise(const QcVectorDouble * vertexes, int number_of_vertexes, double grid_step)
+{
+  rasterise_on_grid(vertexes, number_of_vertexes, grid_step, m_rows, m_runs);
+  return m_runs;
+}
+
+/**************************************************************************************************/
+
 QcTiledPolygonDiff
-QcTiledPolygon::diff(const QcTiledPolygon & old_tiled_polygon)
+QcTiledPolygon::diff(const QcTiledPolygon & old_tiled_polygon) const
 {
-  QcTiledPolygonDiff tiled_polygon_diff;
-  QcTiledPolygonRunList old_runs = old_tiled_polygon.m_runs;
-
-  bool exchanged;
-  QcIntervalInt intersection;
-  QcIntervalInt left;
-  QcIntervalInt right;
-  QVector<unsigned int> intersection_count(old_runs.size(), 0);
-
-  for (const QcTiledPolygonRun & new_run : m_runs) {
-    bool has_intersection = false;
-    int i = 0;
-    for (const QcTiledPolygonRun & old_run : old_runs) {
-      if (new_run.cut(old_run, intersection, left, right, exchanged)) {
-	int y = new_run.y();
-	qInfo() << y << intersection << left << right << exchanged;
-	has_intersection = true;
-	intersection_count[i] += 1;
-
-	tiled_polygon_diff.add_same_area(QcTiledPolygonRun(y, intersection));
-
-	if (left.is_not_empty()) {
-	  QcTiledPolygonRun run(y, left);
-	  if (exchanged)
-	    tiled_polygon_diff.add_old_area(run);
-	  else
-	    tiled_polygon_diff.add_new_area(run);
-	}
+  return diff(m_runs, old_tiled_polygon.m_runs);
+}
 
-	if (right.is_not_empty()) {
-	  QcTiledPolygonRun run(y, right);
-	  if (exchanged)
-	    tiled_polygon_diff.add_new_area(run);
-	  else
-	    tiled_polygon_diff.add_old_area(run);
-	}
+/* Merge the new and old intervals of a row.
+ *
+ * Both interval lists are sorted and disjoint, thus a single pass splits the row in new, old and
+ * same area.
+ */
+static void
+diff_row(int y,
+         const QcTiledPolygonRunList & new_runs, int new_begin, int new_end,
+         const QcTiledPolygonRunList & old_runs, int old_begin, int old_end,
+         QcTiledPolygonDiff & tiled_polygon_diff)
+{
+  int i = new_begin;
+  int j = old_begin;
+  // Lower bounds of the current intervals, they are moved forward as cells are consumed
+  int new_inf = i < new_end ? new_runs[i].interval().inf() : 0;
+  int old_inf = j < old_end ? old_runs[j].interval().inf() : 0;
+
+  while (i < new_end and j < old_end) {
+    int new_sup = new_runs[i].interval().sup();
+    int old_sup = old_runs[j].interval().sup();
+    if (new_sup < old_inf) {
+      tiled_polygon_diff.add_new_area(QcTiledPolygonRun(y, QcIntervalInt(new_inf, new_sup)));
+      if (++i < new_end)
+        new_inf = new_runs[i].interval().inf();
+    } else if (old_sup < new_inf) {
+      tiled_polygon_diff.add_old_area(QcTiledPolygonRun(y, QcIntervalInt(old_inf, old_sup)));
+      if (++j < old_end)
+        old_inf = old_runs[j].interval().inf();
+    } else {
+      if (new_inf < old_inf) {
+        tiled_polygon_diff.add_new_area(QcTiledPolygonRun(y, QcIntervalInt(new_inf, old_inf - 1)));
+        new_inf = old_inf;
+      } else if (old_inf < new_inf) {
+        tiled_polygon_diff.add_old_area(QcTiledPolygonRun(y, QcIntervalInt(old_inf, new_inf - 1)));
+        old_inf = new_inf;
       }
-      i++;
+      int sup = qMin(new_sup, old_sup);
+      tiled_polygon_diff.add_same_area(QcTiledPolygonRun(y, QcIntervalInt(new_inf, sup)));
+      if (new_sup == sup) {
+        if (++i < new_end)
+          new_inf = new_runs[i].interval().inf();
+      } else
+        new_inf = sup + 1;
+      if (old_sup == sup) {
+        if (++j < old_end)
+          old_inf = old_runs[j].interval().inf();
+      } else
+        old_inf = sup + 1;
     }
-
-    if (!has_intersection)
-      tiled_polygon_diff.add_new_area(new_run);
   }
 
-  for (int i = 0; i < old_runs.size(); i++) {
-    if (!intersection_count[i])
-      tiled_polygon_diff.add_old_area(old_runs[i]);
+  for (; i < new_end; i++) {
+    tiled_polygon_diff.add_new_area(QcTiledPolygonRun(y, QcIntervalInt(new_inf, new_runs[i].interval().sup())));
+    if (i + 1 < new_end)
+      new_inf = new_runs[i + 1].interval().inf();
+  }
+  for (; j < old_end; j++) {
+    tiled_polygon_diff.add_old_area(QcTiledPolygonRun(y, QcIntervalInt(old_inf, old_runs[j].interval().sup())));
+    if (j + 1 < old_end)
+      old_inf = old_runs[j + 1].interval().inf();
   }
+}
 
+QcTiledPolygonDiff
+QcTiledPolygon::diff(const QcTiledPolygonRunList & new_runs, const QcTiledPolygonRunList & old_runs)
+{
+  QcTiledPolygonDiff tiled_polygon_diff;
+  diff(new_runs, old_runs, tiled_polygon_diff);
   return tiled_polygon_diff;
 }
 
+void
+QcTiledPolygon::diff(const QcTiledPolygonRunList & new_runs, const QcTiledPolygonRunList & old_runs,
+                     QcTiledPolygonDiff & tiled_polygon_diff)
+{
+  tiled_polygon_diff.clear();
+
+  int number_of_new_runs = new_runs.size();
+  int number_of_old_runs = old_runs.size();
+  int i = 0;
+  int j = 0;
+  while (i < number_of_new_runs or j < number_of_old_runs) {
+    // Process the next row
+    int y;
+    if (i == number_of_new_runs)
+      y = old_runs[j].y();
+    else if (j == number_of_old_runs)
+      y = new_runs[i].y();
+    else
+      y = qMin(new_runs[i].y(), old_runs[j].y());
+
+    int new_end = i;
+    while (new_end < number_of_new_runs and new_runs[new_end].y() == y)
+      new_end++;
+    int old_end = j;
+    while (old_end < number_of_old_runs and old_runs[old_end].y() == y)
+      old_end++;
+
+    diff_row(y, new_runs, i, new_end, old_runs, j, old_end, tiled_polygon_diff);
+
+    i = new_end;
+    j = old_end;
+  }
+}
+
 /***************************************************************************************************
  *
  * End
@@ -53,7 +53,8 @@ class QcTiledPolygon;
 class QcTiledPolygonRun;
 class QcTiledPolygonDiff;
 
-typedef QList<QcTiledPolygonRun> QcTiledPolygonRunList;
+// A run is too large to be stored inline in a QList
+typedef QVector<QcTiledPolygonRun> QcTiledPolygonRunList;
 
 class QC_EXPORT QcPolygon : public QcPathDouble
 {
@@ -77,6 +78,7 @@ class QC_EXPORT QcPolygon : public QcPathDouble
 class QC_EXPORT QcTiledPolygonRun
 {
  public:
+  QcTiledPolygonRun() : m_y(0), m_interval() {}
   QcTiledPolygonRun(int y, const QcIntervalInt & interval);
 
   inline int y() const { return m_y; }
@@ -100,6 +102,30 @@ class QC_EXPORT QcTiledPolygonRun
   QcIntervalInt m_interval;
 };
 
+// Crossing of a polygon edge with a grid row, used to rasterise polygons
+class QcOpenInterval
+{
+public:
+  QcOpenInterval()
+    : x(0), direction(0)
+  {}
+
+  QcOpenInterval(double x, int direction)
+    : x(x), direction(direction)
+  {}
+
+  bool is_gap(const QcOpenInterval & other) const {
+    return other.direction < 0 && direction > 0 && (x - other.x) >= 2;
+  }
+
+  friend bool operator<(const QcOpenInterval & open_interval1, const QcOpenInterval & open_interval2) {
+    return open_interval1.x < open_interval2.x;
+  }
+
+  double x;
+  double direction;
+};
+
 class QC_EXPORT QcTiledPolygon
 {
  public:
@@ -109,9 +135,14 @@ class QC_EXPORT QcTiledPolygon
 
   inline double grid_step() const { return m_grid_step; }
 
-  inline const QList<QcTiledPolygonRun> runs() const { return m_runs; }
+  inline const QcTiledPolygonRunList & runs() const { return m_runs; }
 
-  QcTiledPolygonDiff diff(const QcTiledPolygon & polygon);
+  QcTiledPolygonDiff diff(const QcTiledPolygon & polygon) const;
+  // Runs must be sorted by row then column and must not overlap, cost is O(runs)
+  static QcTiledPolygonDiff diff(const QcTiledPolygonRunList & new_runs, const QcTiledPolygonRunList & old_runs);
+  // Same but reuse the buffers of the diff
+  static void diff(const QcTiledPolygonRunList & new_runs, const QcTiledPolygonRunList & old_runs,
+                   QcTiledPolygonDiff & tiled_polygon_diff);
 
  private:
   const QcPolygon & m_polygon;
@@ -122,6 +153,13 @@ class QC_EXPORT QcTiledPolygon
 class QC_EXPORT QcTiledPolygonDiff
 {
  public:
+  // Clear the runs but keep the capacity
+  void clear() {
+    m_new_area.resize(0);
+    m_old_area.resize(0);
+    m_same_area.resize(0);
+  }
+
   inline const QcTiledPolygonRunList & new_area() const { return m_new_area; }
   inline const QcTiledPolygonRunList & old_area() const { return m_old_area; }
   inline const QcTiledPolygonRunList & same_area() const { return m_same_area; }
@@ -146,6 +184,25 @@ class QC_EXPORT QcTiledPolygonDiff
 
 /**************************************************************************************************/
 
+/*! Rasterise polygons on a grid, the buffers are reused from one call to the next.
+ *
+ * It computes the same runs as QcTiledPolygon, but it doesn't allocate once the buffers are large
+ * enough, e.g. when the viewport is panned.
+ */
+class QC_EXPORT QcPolygonRasteriser
+{
+ public:
+  const QcTiledPolygonRunList & rasterise(const QcVectorDouble * vertexes, int number_of_vertexes, double grid_step);
+
+  inline const QcTiledPolygonRunList & runs() const { return m_runs; }
+
+ private:
+  QVector<QVector<QcOpenInterval>> m_rows;
+  QcTiledPolygonRunList m_runs;
+};
+
+/**************************************************************************************************/
+
 // QT_END_NAMESPACE
 
 /**************************************************************************************************/
@@ -37,7 +37,7 @@
 
 /**************************************************************************************************/
 
-#define DEBUG 1
+// #define DEBUG 1
 // #define CLOCK
 // #define STANDALONE
 // #define SIMPLE
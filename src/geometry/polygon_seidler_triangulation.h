@@ -51,9 +51,9 @@
 
 /**************************************************************************************************/
 
-constexpr int QSIZE = 800; // maximum table sizes
-constexpr int TRSIZE = 400; // max# trapezoids
-constexpr int SEGSIZE = 100; // max# of segments
+constexpr int QSIZE = 8192; // maximum table sizes
+constexpr int TRSIZE = 4096; // max# trapezoids
+constexpr int SEGSIZE = 1024; // max# of segments
 
 /**************************************************************************************************/
 
@@ -0,0 +1,386 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#include "tiled_corridor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <QtMath>
+
+#include "coordinate/wgs84.h"
+#include "earth.h"
+#include "geo_data_format/route.h"
+
+/**************************************************************************************************/
+
+/* Swept rectangle of a segment buffered by a radius, vertexes are in grid unit.
+ *
+ * The rectangle is convex, thus its extent on a row is given by the intersection of its edges
+ * with the row band.
+ */
+class QcSweptRectangle
+{
+public:
+  QcSweptRectangle(const QcVectorDouble & p0, const QcVectorDouble & p1, double radius)
+  {
+    QcVectorDouble direction = p1 - p0;
+    double length = direction.magnitude();
+    if (length > 0)
+      direction /= length;
+    else
+      direction = QcVectorDouble(1, 0);
+    direction *= radius;
+    QcVectorDouble normal(-direction.y(), direction.x());
+
+    QcVectorDouble p0_ = p0 - direction;
+    QcVectorDouble p1_ = p1 + direction;
+    m_vertexes[0] = p0_ - normal;
+    m_vertexes[1] = p1_ - normal;
+    m_vertexes[2] = p1_ + normal;
+    m_vertexes[3] = p0_ + normal;
+
+    m_y_inf = m_y_sup = m_vertexes[0].y();
+    for (int i = 1; i < 4; i++) {
+      m_y_inf = qMin(m_y_inf, m_vertexes[i].y());
+      m_y_sup = qMax(m_y_sup, m_vertexes[i].y());
+    }
+  }
+
+  inline int Y_inf() const { return std::floor(m_y_inf); }
+  inline int Y_sup() const { return std::floor(m_y_sup); }
+
+  // Return the columns covered by the row band [Y, Y+1]
+  QcIntervalInt row_interval(int Y) const
+  {
+    double y_inf = Y;
+    double y_sup = Y + 1;
+    double x_inf = .0;
+    double x_sup = .0;
+    bool found = false;
+
+    for (int i = 0; i < 4; i++) {
+      const QcVectorDouble & a = m_vertexes[i];
+      const QcVectorDouble & b = m_vertexes[(i + 1) % 4];
+      double t0, t1;
+      double dy = b.y() - a.y();
+      if (dy == 0) {
+        if (a.y() < y_inf or a.y() > y_sup)
+          continue;
+        t0 = 0;
+        t1 = 1;
+      } else {
+        t0 = (y_inf - a.y()) / dy;
+        t1 = (y_sup - a.y()) / dy;
+        if (t0 > t1)
+          std::swap(t0, t1);
+        t0 = qMax(t0, .0);
+        t1 = qMin(t1, 1.);
+        if (t0 > t1)
+          continue;
+      }
+      double dx = b.x() - a.x();
+      for (double t : {t0, t1}) {
+        double x = a.x() + t * dx;
+        if (found) {
+          x_inf = qMin(x_inf, x);
+          x_sup = qMax(x_sup, x);
+        } else {
+          x_inf = x_sup = x;
+          found = true;
+        }
+      }
+    }
+
+    if (found)
+      return QcIntervalInt(std::floor(x_inf), std::floor(x_sup));
+    else
+      return QcIntervalInt();
+  }
+
+private:
+  QcVectorDouble m_vertexes[4];
+  double m_y_inf;
+  double m_y_sup;
+};
+
+/**************************************************************************************************/
+
+QcTiledCorridor::QcTiledCorridor(const QcPathDouble & path, double radius, double grid_step)
+  : m_radius(radius), m_grid_step(grid_step)
+{
+  QcPathDoubleList paths;
+  paths << path;
+  rasterise(paths, QList<QVector<double>>());
+}
+
+QcTiledCorridor::QcTiledCorridor(const QcPathDoubleList & paths, double radius, double grid_step)
+  : m_radius(radius), m_grid_step(grid_step)
+{
+  rasterise(paths, QList<QVector<double>>());
+}
+
+QcTiledCorridor::QcTiledCorridor(const QcPathDoubleList & paths, const QList<QVector<double>> & radius_scales,
+                                 double radius, double grid_step)
+  : m_radius(radius), m_grid_step(grid_step)
+{
+  if (radius_scales.size() != paths.size())
+    throw std::invalid_argument("a radius scale list is required for each path");
+  rasterise(paths, radius_scales);
+}
+
+void
+QcTiledCorridor::rasterise(const QcPathDoubleList & paths, const QList<QVector<double>> & radius_scales)
+{
+  if (m_grid_step <= 0)
+    throw std::invalid_argument("grid step must be positive");
+
+  double radius = m_radius / m_grid_step;
+
+  QList<QcSweptRectangle> rectangles;
+  for (int path_index = 0; path_index < paths.size(); path_index++) {
+    const QcPathDouble & path = paths[path_index];
+    const QcPathDouble::VertexListType & vertexes = path.vertexes();
+    int number_of_vertexes = vertexes.size();
+    auto scale = [&radius_scales, path_index](int i) {
+      return radius_scales.isEmpty() ? 1. : radius_scales[path_index][i];
+    };
+    if (!number_of_vertexes)
+      continue;
+    else if (number_of_vertexes == 1) {
+      QcVectorDouble p = vertexes[0] / m_grid_step;
+      rectangles << QcSweptRectangle(p, p, radius * scale(0));
+    }
+    else {
+      int number_of_edges = path.closed() ? number_of_vertexes : number_of_vertexes - 1;
+      for (int i = 0; i < number_of_edges; i++) {
+        int j = (i + 1) % number_of_vertexes;
+        QcVectorDouble p0 = vertexes[i] / m_grid_step;
+        QcVectorDouble p1 = vertexes[j] / m_grid_step;
+        rectangles << QcSweptRectangle(p0, p1, radius * qMax(scale(i), scale(j)));
+      }
+    }
+  }
+
+  if (rectangles.isEmpty())
+    return;
+
+  int Y_min = rectangles.first().Y_inf();
+  int Y_max = rectangles.first().Y_sup();
+  for (const QcSweptRectangle & rectangle : rectangles) {
+    Y_min = qMin(Y_min, rectangle.Y_inf());
+    Y_max = qMax(Y_max, rectangle.Y_sup());
+  }
+
+  int number_of_rows = Y_max - Y_min + 1;
+  QVector<QList<QcIntervalInt>> rows(number_of_rows);
+  for (const QcSweptRectangle & rectangle : rectangles) {
+    for (int Y = rectangle.Y_inf(); Y <= rectangle.Y_sup(); Y++) {
+      QcIntervalInt interval = rectangle.row_interval(Y);
+      if (interval.is_not_empty())
+        rows[Y - Y_min] << interval;
+    }
+  }
+
+  // Merge overlapping and adjacent intervals
+  for (int i = 0; i < number_of_rows; i++) {
+    QList<QcIntervalInt> & row = rows[i];
+    if (row.isEmpty())
+      continue;
+    std::sort(row.begin(), row.end(),
+              [](const QcIntervalInt & a, const QcIntervalInt & b) { return a.inf() < b.inf(); });
+    int Y = Y_min + i;
+    QcIntervalInt current = row.first();
+    for (const QcIntervalInt & interval : row) {
+      if (interval.inf() <= current.sup() + 1) {
+        if (interval.sup() > current.sup())
+          current.set_sup(interval.sup());
+      } else {
+        m_runs << QcTiledPolygonRun(Y, current);
+        current = interval;
+      }
+    }
+    m_runs << QcTiledPolygonRun(Y, current);
+  }
+}
+
+void
+QcTiledCorridor::clip(const QcInterval2DInt & interval)
+{
+  QcTiledPolygonRunList runs;
+  for (const QcTiledPolygonRun & run : m_runs) {
+    if (!interval.y().contains(run.y()))
+      continue;
+    const QcIntervalInt & run_interval = run.interval();
+    int x_inf = qMax(run_interval.inf(), interval.x().inf());
+    int x_sup = qMin(run_interval.sup(), interval.x().sup());
+    if (x_inf <= x_sup)
+      runs << QcTiledPolygonRun(run.y(), QcIntervalInt(x_inf, x_sup));
+  }
+  m_runs = runs;
+}
+
+qint64
+QcTiledCorridor::number_of_tiles() const
+{
+  qint64 count = 0;
+  for (const QcTiledPolygonRun & run : m_runs)
+    count += run.interval().length();
+  return count;
+}
+
+/**************************************************************************************************/
+
+QcPathDoubleList
+QcCorridorTileSet::track_to_paths(const QcTrack & track, const QcProjection & projection)
+{
+  QcPathDoubleList paths;
+  for (const QcWayPointList & segment : track.segments()) {
+    QcPathDouble path;
+    for (const QcWayPoint & waypoint : segment)
+      path.add_vertex(waypoint.coordinate().transform(projection));
+    paths << path;
+  }
+  return paths;
+}
+
+/* The scale is measured along the parallel and the meridian, the largest one is used, thus the
+ * corridor is never narrower than the radius whatever the projection.
+ */
+double
+QcCorridorTileSet::ground_scale(const QcProjection & projection, const QcVectorDouble & vertex)
+{
+  constexpr double step = 1e-4; // [degree], about 10 m
+  constexpr double ground_step = EQUATORIAL_RADIUS * step * M_PI / 180.;
+
+  const QcProjection & wgs84_projection = QcWgsCoordinate::cls_projection;
+  QcVectorDouble coordinate = QcGeoCoordinate(&projection, vertex).transform(wgs84_projection);
+  double longitude = coordinate.x();
+  double latitude = coordinate.y();
+  if (qIsNaN(longitude) or qIsNaN(latitude))
+    return 1.;
+
+  // Step toward the equator and the prime meridian so as to stay within the WGS84 domain
+  double longitude_step = longitude < 0 ? step : -step;
+  double latitude_step = latitude < 0 ? step : -step;
+  QcVectorDouble parallel_point = QcGeoCoordinate(&wgs84_projection, longitude + longitude_step, latitude).transform(projection);
+  QcVectorDouble meridian_point = QcGeoCoordinate(&wgs84_projection, longitude, latitude + latitude_step).transform(projection);
+  double parallel_scale = (parallel_point - vertex).magnitude() / (ground_step * std::cos(qDegreesToRadians(latitude)));
+  double meridian_scale = (meridian_point - vertex).magnitude() / ground_step;
+  return qMax(parallel_scale, meridian_scale);
+}
+
+QcCorridorTileSet::QcCorridorTileSet(const QcTileMatrixSet & tile_matrix_set,
+                                     const QcPathDoubleList & paths,
+                                     double radius,
+                                     const QcIntervalInt & levels)
+  : m_radius(radius),
+    m_levels(levels)
+{
+  compute(tile_matrix_set, paths);
+}
+
+QcCorridorTileSet::QcCorridorTileSet(const QcTileMatrixSet & tile_matrix_set,
+                                     const QcTrack & track,
+                                     double radius,
+                                     const QcIntervalInt & levels)
+  : m_radius(radius),
+    m_levels(levels)
+{
+  compute(tile_matrix_set, track_to_paths(track, tile_matrix_set.projection()));
+}
+
+void
+QcCorridorTileSet::compute(const QcTileMatrixSet & tile_matrix_set, const QcPathDoubleList & paths)
+{
+  if (m_levels.inf() < 0 or m_levels.sup() >= tile_matrix_set.number_of_levels())
+    throw std::invalid_argument("level interval is out of the tile matrix set");
+
+  // Map the paths to the tile matrix referential, the radius is converted to the projected unit
+  // at each vertex
+  const QcProjection & projection = tile_matrix_set.projection();
+  const QcVectorDouble & origin = tile_matrix_set.origin();
+  const QcVectorDouble & scale = tile_matrix_set.scale();
+  QcPathDoubleList transformed_paths;
+  QList<QVector<double>> radius_scales;
+  for (const QcPathDouble & path : paths) {
+    QcPathDouble transformed_path;
+    QVector<double> radius_scale;
+    radius_scale.reserve(path.number_of_vertexes());
+    for (const QcVectorDouble & vertex : path.vertexes()) {
+      transformed_path.add_vertex((vertex - origin) * scale);
+      radius_scale << ground_scale(projection, vertex);
+    }
+    transformed_paths << transformed_path;
+    radius_scales << radius_scale;
+  }
+
+  for (int level = m_levels.inf(); level <= m_levels.sup(); level++) {
+    const QcTileMatrix & tile_matrix = tile_matrix_set[level];
+    QcTiledCorridor corridor(transformed_paths, radius_scales, m_radius, tile_matrix.tile_length_m());
+    int last_index = tile_matrix.mosaic_size() - 1;
+    corridor.clip(QcInterval2DInt(0, last_index, 0, last_index));
+    m_corridors << corridor;
+  }
+}
+
+const QcTiledCorridor &
+QcCorridorTileSet::level(int level) const
+{
+  if (!m_levels.contains(level))
+    throw std::invalid_argument("level is out of range");
+  return m_corridors[level - m_levels.inf()];
+}
+
+qint64
+QcCorridorTileSet::number_of_tiles(int level) const
+{
+  return this->level(level).number_of_tiles();
+}
+
+qint64
+QcCorridorTileSet::number_of_tiles() const
+{
+  qint64 count = 0;
+  for (const QcTiledCorridor & corridor : m_corridors)
+    count += corridor.number_of_tiles();
+  return count;
+}
+
+qint64
+QcCorridorTileSet::estimated_bytes(qint64 mean_tile_size) const
+{
+  return number_of_tiles() * mean_tile_size;
+}
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
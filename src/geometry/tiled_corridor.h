@@ -0,0 +1,149 @@
+// -*- mode: c++ -*-
+
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#ifndef __TILED_CORRIDOR_H__
+#define __TILED_CORRIDOR_H__
+
+/**************************************************************************************************/
+
+#include <QList>
+#include <QVector>
+
+#include "geometry/path.h"
+#include "geometry/polygon.h"
+#include "math/interval.h"
+#include "qtcarto_global.h"
+#include "wmts/tile_matrix_set.h"
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+class QcTrack;
+
+typedef QList<QcPathDouble> QcPathDoubleList;
+
+/*! Set of grid cells lying within a distance of a list of paths.
+ *
+ * Each segment is buffered by a swept rectangle which is rasterised row by row, the resulting
+ * intervals are then merged into runs.  Thus the corridor polygon is never materialised.
+ *
+ * The radius, the vertexes and the grid step must be given in the same unit.
+ */
+class QC_EXPORT QcTiledCorridor
+{
+ public:
+  QcTiledCorridor(const QcPathDouble & path, double radius, double grid_step);
+  QcTiledCorridor(const QcPathDoubleList & paths, double radius, double grid_step);
+  /* The radius of a segment is multiplied by the largest scale of its vertexes, e.g. to convert a
+   * ground distance to the unit of a projection.  A scale is given for each vertex of each path.
+   */
+  QcTiledCorridor(const QcPathDoubleList & paths, const QList<QVector<double>> & radius_scales,
+                  double radius, double grid_step);
+
+  inline double radius() const { return m_radius; }
+  inline double grid_step() const { return m_grid_step; }
+
+  inline const QcTiledPolygonRunList & runs() const { return m_runs; }
+
+  // Restrict the runs to the given grid interval, e.g. the tile matrix mosaic.
+  void clip(const QcInterval2DInt & interval);
+
+  qint64 number_of_tiles() const;
+
+ private:
+  void rasterise(const QcPathDoubleList & paths, const QList<QVector<double>> & radius_scales);
+
+ private:
+  double m_radius;
+  double m_grid_step;
+  QcTiledPolygonRunList m_runs;
+};
+
+/**************************************************************************************************/
+
+/*! Tiles of a tile matrix set lying within a distance of a route, for a range of levels.
+ *
+ * Paths are given in the projected coordinate system of the tile matrix set, radius is a ground
+ * distance in metre.  It is converted at each vertex using the local scale of the projection,
+ * e.g. 1/cos(latitude) for Web Mercator.
+ */
+class QC_EXPORT QcCorridorTileSet
+{
+ public:
+  static QcPathDoubleList track_to_paths(const QcTrack & track, const QcProjection & projection);
+  // Return the ratio of a projected length to a ground length at a projected vertex
+  static double ground_scale(const QcProjection & projection, const QcVectorDouble & vertex);
+
+ public:
+  QcCorridorTileSet(const QcTileMatrixSet & tile_matrix_set,
+                    const QcPathDoubleList & paths,
+                    double radius,
+                    const QcIntervalInt & levels);
+  QcCorridorTileSet(const QcTileMatrixSet & tile_matrix_set,
+                    const QcTrack & track,
+                    double radius,
+                    const QcIntervalInt & levels);
+
+  inline double radius() const { return m_radius; }
+  inline const QcIntervalInt & levels() const { return m_levels; }
+
+  const QcTiledCorridor & level(int level) const;
+
+  qint64 number_of_tiles(int level) const;
+  qint64 number_of_tiles() const;
+
+  // Estimate the download size using a mean tile size [bytes]
+  qint64 estimated_bytes(qint64 mean_tile_size) const;
+
+ private:
+  void compute(const QcTileMatrixSet & tile_matrix_set, const QcPathDoubleList & paths);
+
+ private:
+  double m_radius;
+  QcIntervalInt m_levels;
+  QList<QcTiledCorridor> m_corridors;
+};
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/**************************************************************************************************/
+
+#endif /* __TILED_CORRIDOR_H__ */
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
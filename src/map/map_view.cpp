@@ -30,19 +30,36 @@
 
 #include "wmts/tile_spec.h"
 
+#include <algorithm>
+
 #include <QtDebug>
 
 /**************************************************************************************************/
 
 // QC_BEGIN_NAMESPACE
 
+// Deepest ancestor used as fallback, its texture is magnified 2^depth times
+constexpr int MAXIMUM_FALLBACK_DEPTH = 4;
+
+// Tiles added around the viewport to the frame of the tile sets, the frame is kept while the viewport
+// pans within it
+constexpr int FRAME_MARGIN = 16;
+
 QcMapViewLayer::QcMapViewLayer(const QcWmtsPluginLayer * plugin_layer, QcViewport * viewport, QcMapLayerScene * layer_scene)
   : QObject(),
     m_plugin_layer(plugin_layer),
     m_viewport(viewport),
     m_layer_scene(layer_scene),
-    m_request_manager(new QcWmtsRequestManager(this, plugin()->wmts_manager()))
-{}
+    m_request_manager(new QcWmtsRequestManager(this, plugin()->wmts_manager())),
+    m_interval_defined(false),
+    m_zoom_level_changed(false),
+    m_visible_tiles_changed(false)
+{
+  m_zoom_settle_timer.setSingleShot(true);
+  m_zoom_settle_timer.setInterval(DEFAULT_ZOOM_SETTLE_INTERVAL);
+  connect(&m_zoom_settle_timer, &QTimer::timeout,
+          this, &QcMapViewLayer::request_deferred_tiles);
+}
 
 QcMapViewLayer::~QcMapViewLayer()
 {
@@ -62,6 +79,34 @@ QcMapViewLayer::set_opacity(float opacity)
   m_layer_scene->set_opacity(opacity);
 }
 
+void
+QcMapViewLayer::set_zoom_settle_interval(int interval)
+{
+  m_zoom_settle_timer.setInterval(qMax(interval, 0));
+  if (!m_zoom_settle_timer.interval() and m_zoom_settle_timer.isActive()) {
+    m_zoom_settle_timer.stop();
+    request_deferred_tiles();
+  }
+}
+
+/*! Fetch the tiles of the level drawn once the zoom is settled.
+ */
+void
+QcMapViewLayer::request_deferred_tiles()
+{
+  if (m_request_manager->has_deferred_tiles())
+    add_cached_tiles(m_request_manager->request_deferred_tiles());
+}
+
+void
+QcMapViewLayer::add_cached_tiles(const QList<QSharedPointer<QcTileTexture> > & cached_tiles)
+{
+  for (const auto & texture : cached_tiles)
+    m_layer_scene->add_tile(texture->tile_spec, texture);
+  if (!cached_tiles.isEmpty())
+    emit scene_graph_changed();
+}
+
 /*! Slot to add a tile to the layer scene
  */
 void
@@ -77,111 +122,350 @@ QcMapViewLayer::update_tile(const QcTileSpec & tile_spec)
   }
 }
 
-//! Transform the polygon to the tile referential
-QcPolygon
-QcMapViewLayer::transform_polygon(const QcPolygon & polygon) // Fixme: const
+//! Transform the polygon to the tile referential, vertexes must hold 4 vertexes
+void
+QcMapViewLayer::transform_polygon(const QcPolygon & polygon, QcVectorDouble * vertexes) // Fixme: const
 {
   const QcTileMatrixSet & tile_matrix_set = plugin()->tile_matrix_set();
-  QcPolygon transformed_polygon;
-  QList<QcVectorDouble> vertexes;
-  for (const auto & vertex : polygon.vertexes()) {
-    // Fixme: [before in viewport] -1 else take tile on border
-    auto transformed_vertex = (vertex - tile_matrix_set.origin()) * tile_matrix_set.scale();
-    vertexes << transformed_vertex;
-    // transformed_polygon.add_vertex(transformed_vertex);
-  }
+  const QcPolygon::VertexListType & polygon_vertexes = polygon.vertexes();
   // Fixme: inverted y
-  transformed_polygon.add_vertex(vertexes[1]);
-  transformed_polygon.add_vertex(vertexes[0]);
-  transformed_polygon.add_vertex(vertexes[3]);
-  transformed_polygon.add_vertex(vertexes[2]);
-  return transformed_polygon;
+  constexpr int order[4] = {1, 0, 3, 2};
+  for (int i = 0; i < 4; i++)
+    // Fixme: [before in viewport] -1 else take tile on border
+    vertexes[i] = (polygon_vertexes[order[i]] - tile_matrix_set.origin()) * tile_matrix_set.scale();
 }
 
-QcTileSpecSet
-QcMapViewLayer::intersec_polygon_with_grid(const QcPolygon & polygon, double tile_length_m, int zoom_level)
+/*! Compute the runs of the tiles covered by the polygon.
+ *
+ * Runs are written in a buffer owned by the caller so as to not allocate when the viewport is panned.
+ */
+void
+QcMapViewLayer::intersec_polygon_with_grid(const QcPolygon & polygon, double tile_length_m, int zoom_level,
+                                           QcTiledPolygonRunList & runs)
 {
-  QcTileSpecSet visible_tiles;
-  QcTiledPolygon tiled_polygon = transform_polygon(polygon).intersec_with_grid(tile_length_m);
+  QcVectorDouble vertexes[4];
+  transform_polygon(polygon, vertexes);
+  const QcTiledPolygonRunList & tiled_polygon_runs = m_rasteriser.rasterise(vertexes, 4, tile_length_m);
   int number_of_tiles = 1 << zoom_level; // Fixme: cf. tile_matrix_set
-  QcIntervalInt valid_interval(0, number_of_tiles -1);
-  for (const QcTiledPolygonRun & run: tiled_polygon.runs()) {
-    QcIntervalInt run_interval = run.interval(); // const &
+  int last_index = number_of_tiles - 1;
+
+  runs.resize(0); // keep the capacity
+  bool clamped = false;
+  for (const QcTiledPolygonRun & run: tiled_polygon_runs) {
+    const QcIntervalInt & run_interval = run.interval();
     int y = run.y();
     // qInfo() << "Run " << run.y() << " [" << run_interval.inf() << ", " << run_interval.sup() << "]";
-    if (!valid_interval.contains(y)) {
+    if (y < 0 or y > last_index) {
       // It arises at large zoom, when the item eight is larger than the map.
       // qWarning() << "Tile columns is out of range" << y;
-      y = qMax(qMin(y, number_of_tiles -1), 0); // Fixme: to func
+      y = qMax(qMin(y, last_index), 0); // Fixme: to func
+      clamped = true;
     }
     // It arises when the polygon vertexes are at the border
-    if (run_interval.sup() >= number_of_tiles)
-      run_interval.set_sup(valid_interval.sup());
-    // if (!run_interval.is_included_in(valid_interval)) {
-    //   // qWarning() << "Tile row is out of range" << run_interval;
-    //   run_interval &= valid_interval;
-    // }
-    for (int x = run_interval.inf(); x <= run_interval.sup(); x++)
-      visible_tiles.insert(m_plugin_layer->create_tile_spec(zoom_level, x, y));
+    int x_inf = qMax(run_interval.inf(), 0);
+    int x_sup = qMin(run_interval.sup(), last_index);
+    if (x_inf <= x_sup)
+      runs << QcTiledPolygonRun(y, QcIntervalInt(x_inf, x_sup));
+  }
+
+  // Clamped rows can overlap, merge them in place so as to keep the runs sorted and disjoint
+  if (clamped) {
+    std::sort(runs.begin(), runs.end(),
+              [](const QcTiledPolygonRun & a, const QcTiledPolygonRun & b) {
+                return a.y() < b.y() or (a.y() == b.y() and a.interval().inf() < b.interval().inf());
+              });
+    int number_of_merged_runs = 0;
+    for (int i = 0; i < runs.size(); i++) {
+      const QcTiledPolygonRun & run = runs[i];
+      if (number_of_merged_runs) {
+        QcTiledPolygonRun & last_run = runs[number_of_merged_runs - 1];
+        if (last_run.y() == run.y() and run.interval().inf() <= last_run.interval().sup() + 1) {
+          int x_sup = qMax(last_run.interval().sup(), run.interval().sup());
+          last_run = QcTiledPolygonRun(run.y(), QcIntervalInt(last_run.interval().inf(), x_sup));
+          continue;
+        }
+      }
+      runs[number_of_merged_runs++] = run;
+    }
+    runs.resize(number_of_merged_runs);
   }
-  return visible_tiles;
 }
 
+/*! Set the frame of the new visible tiles.
+ *
+ * The frame of the last update is kept as long as it contains the runs, thus the tile sets are
+ * compared word by word during a pan.  Else the frame is the hull of the viewport parts enlarged by
+ * a margin, the west part lies at the east of the mosaic.
+ */
 void
-QcMapViewLayer::update_scene()
+QcMapViewLayer::update_frame(int zoom_level, int mosaic_size)
+{
+  const QcTiledPolygonRunList * part_runs[3] = {&m_west_new_runs, &m_central_new_runs, &m_east_new_runs};
+  auto contains_runs = [&part_runs](const QcTileBitSet & tile_set) {
+    for (const QcTiledPolygonRunList * runs : part_runs)
+      for (const QcTiledPolygonRun & run : *runs)
+        if (!tile_set.frame_contains(run))
+          return false;
+    return true;
+  };
+
+  if (m_visible_tiles.level() == zoom_level and contains_runs(m_visible_tiles)) {
+    m_new_visible_tiles.set_frame(m_visible_tiles);
+    return;
+  }
+
+  int x_inf = -1;
+  int x_sup = -1;
+  int y_inf = mosaic_size;
+  int y_sup = -1;
+  int number_of_columns = 0;
+  for (const QcTiledPolygonRunList * runs : part_runs) {
+    if (runs->isEmpty())
+      continue;
+    int part_x_inf = mosaic_size;
+    int part_x_sup = -1;
+    for (const QcTiledPolygonRun & run : *runs) {
+      part_x_inf = qMin(part_x_inf, run.interval().inf());
+      part_x_sup = qMax(part_x_sup, run.interval().sup());
+      y_inf = qMin(y_inf, run.y());
+      y_sup = qMax(y_sup, run.y());
+    }
+    if (x_inf < 0)
+      x_inf = part_x_inf;
+    x_sup = part_x_sup;
+    number_of_columns += part_x_sup - part_x_inf + 1;
+  }
+
+  if (y_sup < 0) {
+    m_new_visible_tiles.set_frame(zoom_level, mosaic_size, 0, 0, 0, 0);
+    return;
+  }
+
+  int x0 = ((x_inf - FRAME_MARGIN) % mosaic_size + mosaic_size) % mosaic_size;
+  int width = (x_sup - x_inf + mosaic_size) % mosaic_size + 1 + 2*FRAME_MARGIN;
+  if (number_of_columns >= mosaic_size or width >= mosaic_size) { // the viewport covers the mosaic
+    x0 = 0;
+    width = mosaic_size;
+  }
+  y_inf = qMax(y_inf - FRAME_MARGIN, 0);
+  y_sup = qMin(y_sup + FRAME_MARGIN, mosaic_size - 1);
+  int height = y_sup - y_inf + 1;
+  m_new_visible_tiles.set_frame(zoom_level, mosaic_size, x0, width, y_inf, height);
+  if (!contains_runs(m_new_visible_tiles)) // unexpected order of the parts
+    m_new_visible_tiles.set_frame(zoom_level, mosaic_size, 0, mosaic_size, y_inf, height);
+}
+
+/*! Fill the visible tiles of a viewport part from its runs and add them to the new visible tiles.
+ *
+ * Return true if the tiles of the part changed.
+ */
+bool
+QcMapViewLayer::update_visible_part(const QcTiledPolygonRunList & runs, QcTileBitSet & visible_tiles)
+{
+  m_new_part_tiles.set_frame(m_new_visible_tiles);
+  for (const QcTiledPolygonRun & run : runs)
+    m_new_part_tiles.insert(run);
+  m_new_visible_tiles |= m_new_part_tiles;
+
+  if (m_new_part_tiles == visible_tiles)
+    return false;
+  // The old tiles become the buffer of the next update
+  std::swap(visible_tiles, m_new_part_tiles);
+  return true;
+}
+
+/*! Look for textures to draw in place of the tiles in flight, in the texture tier.
+ *
+ * Only decoded textures are used, an encoded tile of the memory tier would be decoded here on the
+ * GUI thread.  The four children are used when they are all available, else the nearest ancestor,
+ * else the available children.  Return true if a fallback was added.
+ */
+bool
+QcMapViewLayer::update_fallback_tiles(const QcTileSpecSet & missing_tiles)
+{
+  int number_of_levels = plugin()->tile_matrix_set().number_of_levels();
+
+  // Neighbour tiles share their ancestors
+  QHash<QcTileSpec, QSharedPointer<QcTileTexture> > textures;
+  auto decoded_texture = [&](int level, int x, int y) {
+    QcTileSpec tile_spec = m_plugin_layer->create_tile_spec(level, x, y);
+    if (!textures.contains(tile_spec)) {
+      QSharedPointer<QcTileTexture> texture = m_request_manager->decoded_tile_texture(tile_spec);
+      if (texture and texture->image.isNull())
+        texture.clear();
+      textures.insert(tile_spec, texture);
+    }
+    return textures.value(tile_spec);
+  };
+
+  bool added = false;
+  for (const auto & tile_spec : missing_tiles) {
+    if (m_layer_scene->has_texture(tile_spec) or m_layer_scene->has_fallback(tile_spec))
+      continue;
+
+    int level = tile_spec.level();
+    int x = tile_spec.x();
+    int y = tile_spec.y();
+
+    QcTileTextureList children;
+    if (level + 1 < number_of_levels)
+      for (int i = 0; i < 4; i++) {
+        QSharedPointer<QcTileTexture> texture = decoded_texture(level + 1, 2*x + (i & 1), 2*y + (i >> 1));
+        if (texture)
+          children << texture;
+      }
+
+    QcTileTextureList fallback;
+    if (children.size() == 4)
+      fallback = children;
+    else {
+      for (int depth = 1; depth <= qMin(MAXIMUM_FALLBACK_DEPTH, level); depth++) {
+        QSharedPointer<QcTileTexture> texture = decoded_texture(level - depth, x >> depth, y >> depth);
+        if (texture) {
+          fallback << texture;
+          break;
+        }
+      }
+      if (fallback.isEmpty())
+        fallback = children;
+    }
+
+    if (!fallback.isEmpty()) {
+      m_layer_scene->add_fallback_tile(tile_spec, fallback);
+      added = true;
+    }
+  }
+
+  return added;
+}
+
+/*! Compute the tiles entering and leaving the viewport.
+ *
+ * It only reads the viewport and writes the state of the layer, thus the layers of a map view are
+ * prepared concurrently, cf. QcMapView::update_viewport.
+ */
+void
+QcMapViewLayer::prepare_scene()
 {
   // qInfo();
 
+  QcStageTimer timer(m_layer_scene->frame_statistics(), QcFrameStatistics::ViewLayerPreparation, m_layer_scene->name());
+
   // Fixme: if layers share the same tile matrix ?
 
-  // Compute visible tile set in viewport
+  m_interval_defined = m_viewport->is_interval_defined();
+  m_zoom_level_changed = false;
+  m_visible_tiles_changed = false;
 
-  m_west_visible_tiles.clear();
-  m_central_visible_tiles.clear();
-  m_east_visible_tiles.clear();
-  m_visible_tiles.clear();
+  // Compute visible tile set in viewport
 
-  if (m_viewport->is_interval_defined()) {
+  if (m_interval_defined) {
     // Fixme: Done in map scene !!!
-    QcTileMatrixSet tile_matrix_set = plugin()->tile_matrix_set();
+    const QcTileMatrixSet & tile_matrix_set = plugin()->tile_matrix_set();
     int zoom_level = m_viewport->zoom_level();
     const QcTileMatrix & tile_matrix = tile_matrix_set[zoom_level];
     double tile_length_m = tile_matrix.tile_length_m();
 
     // Fixme: use if(m_viewport->west_part()) ?
     if (m_viewport->cross_west_line())
-      m_west_visible_tiles = intersec_polygon_with_grid(m_viewport->west_part().polygon(), tile_length_m, zoom_level);
+      intersec_polygon_with_grid(m_viewport->west_part().polygon(), tile_length_m, zoom_level, m_west_new_runs);
+    else
+      m_west_new_runs.resize(0);
 
-    m_central_visible_tiles = intersec_polygon_with_grid(m_viewport->central_part().polygon(), tile_length_m, zoom_level);
+    intersec_polygon_with_grid(m_viewport->central_part().polygon(), tile_length_m, zoom_level, m_central_new_runs);
 
     if (m_viewport->cross_east_line())
-      m_east_visible_tiles = intersec_polygon_with_grid(m_viewport->east_part().polygon(), tile_length_m, zoom_level);
-
-    QcTileSpecSet visible_tiles = m_east_visible_tiles + m_central_visible_tiles + m_west_visible_tiles;
-    // qInfo() << "visible west tiles: " << m_west_visible_tiles << '\n'
-    //         << "visible central tiles: " << m_central_visible_tiles << '\n'
-    //         << "visible east tiles: " << m_east_visible_tiles << '\n'
-    //         << "visible tiles: " << visible_tiles << '\n'
-    //         << "new visible tiles: " << visible_tiles - m_visible_tiles;
-
-    // bool new_tiles_introduced = !m_visible_tiles.contains(visible_tiles);
-    m_visible_tiles = visible_tiles;
+      intersec_polygon_with_grid(m_viewport->east_part().polygon(), tile_length_m, zoom_level, m_east_new_runs);
+    else
+      m_east_new_runs.resize(0);
+
+    m_zoom_level_changed = m_visible_tiles.level() != -1 and m_visible_tiles.level() != zoom_level;
+
+    update_frame(zoom_level, 1 << zoom_level); // Fixme: cf. tile_matrix_set
+    bool west_changed = update_visible_part(m_west_new_runs, m_west_visible_tiles);
+    bool central_changed = update_visible_part(m_central_new_runs, m_central_visible_tiles);
+    bool east_changed = update_visible_part(m_east_new_runs, m_east_visible_tiles);
+
+    // Nothing to do in the steady state of a pan, when the viewport moves within the same tiles
+    if (west_changed or central_changed or east_changed) {
+      // A tile can be visible in several parts
+      m_tiles_added.assign(m_new_visible_tiles);
+      m_tiles_added -= m_visible_tiles;
+      m_tiles_removed.assign(m_visible_tiles);
+      m_tiles_removed -= m_new_visible_tiles;
+      std::swap(m_visible_tiles, m_new_visible_tiles);
+      // The tile specs are created by the commit, thus the preparation doesn't allocate
+      m_visible_tiles_changed = true;
+    }
+  } else {
+    m_west_visible_tiles.reset();
+    m_central_visible_tiles.reset();
+    m_east_visible_tiles.reset();
+    m_visible_tiles.reset();
+  }
+}
 
-    // Fixme: better ?
-    m_layer_scene->set_visible_tiles(m_visible_tiles, m_west_visible_tiles, m_central_visible_tiles, m_east_visible_tiles);
+/*! Convert the tiles of a bit set to tile specs of this layer.
+ */
+QcTileSpecSet
+QcMapViewLayer::to_tile_spec_set(const QcTileBitSet & tiles) const
+{
+  QcTileSpecSet tile_specs;
+  tile_specs.reserve(tiles.count());
+  int level = tiles.level();
+  tiles.for_each([this, level, &tile_specs](int x, int y) {
+      tile_specs.insert(m_plugin_layer->create_tile_spec(level, x, y));
+    });
+  return tile_specs;
+}
 
-    // Don't request tiles that are already built and textured
-    QcTileSpecSet tile_to_request = m_visible_tiles - m_layer_scene->textured_tiles();
-    if (!tile_to_request.isEmpty()) {
-        QList<QSharedPointer<QcTileTexture> > cached_tiles = m_request_manager->request_tiles(tile_to_request);
-        for (const auto & texture : cached_tiles)
-          m_layer_scene->add_tile(texture->tile_spec, texture);
-        if (!cached_tiles.isEmpty())
+/*! Apply the prepared tiles to the layer scene and update the tile requests.
+ *
+ * The tile cache is shared by the layers of a plugin and isn't thread-safe, thus it is probed here,
+ * on the thread of the map view.
+ *
+ * A translation keeps the level, thus the zoom settle and the fallbacks are skipped during a pan.
+ */
+void
+QcMapViewLayer::commit_scene(QcViewport::ChangeFlags changes)
+{
+  QcStageTimer timer(m_layer_scene->frame_statistics(), QcFrameStatistics::ViewLayerUpdate, m_layer_scene->name());
+
+  bool translation_only = changes == QcViewport::TranslationChange;
+
+  if (m_interval_defined) {
+    /* During a pinch or a wheel zoom, each level is drawn using the cached tiles and the fallbacks,
+     * and the network fetches are deferred until the zoom level is stable.  The requests of the
+     * level left are cancelled at once.
+     */
+    if (!translation_only and m_zoom_level_changed and m_zoom_settle_timer.interval())
+      m_zoom_settle_timer.start(); // restarted at each step
+    bool deferred = m_zoom_settle_timer.isActive();
+
+    if (m_visible_tiles_changed) {
+      QcTileSpecSetDiff tiles_diff;
+      tiles_diff.added = to_tile_spec_set(m_tiles_added);
+      tiles_diff.removed = to_tile_spec_set(m_tiles_removed);
+      // qInfo() << "new visible tiles: " << tiles_diff.added << '\n'
+      //         << "old visible tiles: " << tiles_diff.removed;
+
+      m_layer_scene->update_visible_tiles(tiles_diff,
+                                          m_visible_tiles,
+                                          m_west_visible_tiles,
+                                          m_central_visible_tiles,
+                                          m_east_visible_tiles);
+
+      // Only request the tiles entering the viewport
+      if (!tiles_diff.is_empty()) {
+        add_cached_tiles(m_request_manager->update_tile_requests(tiles_diff.added, tiles_diff.removed, deferred));
+        // Hide the fetch latency
+        if (!translation_only and update_fallback_tiles(tiles_diff.added))
           emit scene_graph_changed();
+      }
     }
   } else {
     // Fixme: code
-    m_layer_scene->set_visible_tiles(m_visible_tiles, m_east_visible_tiles, m_central_visible_tiles, m_west_visible_tiles);
+    m_layer_scene->set_visible_tiles(m_visible_tiles, m_west_visible_tiles, m_central_visible_tiles, m_east_visible_tiles);
     emit scene_graph_changed();
  }
 
@@ -189,13 +473,48 @@ QcMapViewLayer::update_scene()
   emit scene_graph_changed();
 }
 
+void
+QcMapViewLayer::update_scene()
+{
+  prepare_scene();
+  commit_scene();
+}
+
+/**************************************************************************************************/
+
+class QcMapViewLayerPreparation : public QRunnable
+{
+public:
+  QcMapViewLayerPreparation(QcMapViewLayer * layer, QSemaphore * done)
+    : QRunnable(),
+      m_layer(layer),
+      m_done(done)
+  {
+    setAutoDelete(false); // reused on each update, deleted by the map view
+  }
+
+  void run() override {
+    m_layer->prepare_scene();
+    m_done->release();
+  }
+
+private:
+  QcMapViewLayer * m_layer;
+  QSemaphore * m_done;
+};
+
 /**************************************************************************************************/
 
 QcMapView::QcMapView()
   : QObject(),
     m_viewport(nullptr), // initialised in ctor
-    m_map_scene(nullptr) // initialised in ctor
+    m_map_scene(nullptr), // initialised in ctor
+    m_zoom_settle_interval(QcMapViewLayer::DEFAULT_ZOOM_SETTLE_INTERVAL),
+    m_parallel_preparation_threshold(DEFAULT_PARALLEL_PREPARATION_THRESHOLD)
 {
+  // The preparation threads are kept alive between the updates
+  m_layer_thread_pool.setExpiryTimeout(-1);
+
   // Fixme: need to pass fake state
   QcWgsCoordinate coordinate_origin(0, 0);
   int tile_size = 256; // map can have different tile size ! Use the most common ?
@@ -207,17 +526,21 @@ QcMapView::QcMapView()
   // Fixme: cf. add_layer
   m_viewport->set_projection(&QcWebMercatorCoordinate::cls_projection);
 
-  m_map_scene = new QcMapScene(m_viewport, m_location_circle_data); // parent
+  m_map_scene = new QcMapScene(m_viewport, m_location_circle_data, m_overlay_layer, &m_frame_statistics); // parent
+  connect(m_map_scene, &QcMapScene::scene_graph_changed,
+	  this, &QcMapView::scene_graph_changed);
 
-  connect(m_viewport, SIGNAL(viewport_changed()),
-	  this, SLOT(update_scene()),
-	  Qt::QueuedConnection);
+  // The viewport coalesces its changes, thus the scene is updated at most once per frame
+  connect(m_viewport, &QcViewport::viewport_changed,
+	  this, &QcMapView::update_viewport);
 }
 
 QcMapView::~QcMapView()
 {
   for (auto * layer : m_layers)
     layer->deleteLater(); // Fixme: delete ?
+  m_layer_thread_pool.waitForDone(); // a runnable can still be returning
+  qDeleteAll(m_layer_preparations);
   delete m_map_scene;
   delete m_viewport;
 }
@@ -231,6 +554,14 @@ QcMapView::set_projection(const QcProjection * new_projection)
   }
 }
 
+void
+QcMapView::set_zoom_settle_interval(int interval)
+{
+  m_zoom_settle_interval = qMax(interval, 0);
+  for (auto * layer : m_layers)
+    layer->set_zoom_settle_interval(m_zoom_settle_interval);
+}
+
 void
 QcMapView::update_zoom_level_interval()
 {
@@ -267,7 +598,9 @@ QcMapView::add_layer(const QcWmtsPluginLayer * plugin_layer)
     if (!m_layer_map.contains(name)) {
       QcMapLayerScene * layer_scene = m_map_scene->add_layer(plugin_layer);
       QcMapViewLayer * layer = new QcMapViewLayer(plugin_layer, m_viewport, layer_scene);
+      layer->set_zoom_settle_interval(m_zoom_settle_interval);
       m_layers << layer;
+      m_layer_preparations << new QcMapViewLayerPreparation(layer, &m_layer_preparation_done);
       m_layer_map.insert(name, layer);
       update_zoom_level_interval();
       connect(layer, SIGNAL(scene_graph_changed()),
@@ -283,7 +616,10 @@ QcMapView::remove_layer(const QcWmtsPluginLayer * plugin_layer)
   QcMapViewLayer * layer = get_layer(plugin_layer);
   if (layer) {
     m_map_scene->remove_layer(plugin_layer);
-    m_layers.removeOne(layer);
+    int index = m_layers.indexOf(layer);
+    m_layers.removeAt(index);
+    m_layer_thread_pool.waitForDone(); // a runnable can still be returning
+    delete m_layer_preparations.takeAt(index);
     QString name = plugin_layer->hash_name();
     m_layer_map.remove(name);
     update_zoom_level_interval();
@@ -329,10 +665,54 @@ QcMapView::set_opacity(const QcWmtsPluginLayer * plugin_layer, float opacity)
 void
 QcMapView::update_scene()
 {
-  // qInfo();
+  update_viewport(QcViewport::AllChanges);
+}
+
+void
+QcMapView::update_viewport(QcViewport::ChangeFlags changes)
+{
+  // qInfo() << changes;
+  m_map_scene->add_viewport_changes(changes);
+  prepare_layers();
+  commit_layers(changes);
+}
+
+void
+QcMapView::set_parallel_preparation_threshold(int number_of_layers)
+{
+  m_parallel_preparation_threshold = qMax(number_of_layers, 2);
+}
+
+/*! Prepare the layers concurrently, the first one on this thread.
+ *
+ *  The runnables are created with the layers, thus an update does not allocate.  Each runnable
+ *  releases the semaphore when it is done, since waitForDone joins and deletes the threads of the
+ *  pool.
+ */
+void
+QcMapView::prepare_layers()
+{
+  int number_of_layers = m_layers.size();
+  if (number_of_layers < m_parallel_preparation_threshold) {
+    for (auto * layer : m_layers)
+      layer->prepare_scene();
+    return;
+  }
+
+  for (int i = 1; i < number_of_layers; i++)
+    m_layer_thread_pool.start(m_layer_preparations[i]);
+  m_layers.first()->prepare_scene();
+  m_layer_preparation_done.acquire(number_of_layers - 1);
+}
+
+/*! Commit the layers in their order so as to request the tiles and to update the scene
+ *  deterministically.
+ */
+void
+QcMapView::commit_layers(QcViewport::ChangeFlags changes)
+{
   for (auto * layer : m_layers)
-    layer->update_scene();
-  m_map_scene->set_dirty_path(); // viewport changed thus update vertexes
+    layer->commit_scene(changes);
 }
 
 /**************************************************************************************************/
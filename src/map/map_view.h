@@ -35,11 +35,17 @@
 
 #include <QList>
 #include <QObject>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QTimer>
 
 #include "map/location_circle_data.h"
+#include "map/overlay_layer.h"
 #include "map/viewport.h"
 #include "qtcarto_global.h"
 #include "scene/map_scene.h"
+#include "tools/frame_statistics.h"
+#include "wmts/tile_bit_set.h"
 #include "wmts/tile_spec.h"
 #include "wmts/wmts_plugin.h" // circular
 #include "wmts/wmts_request_manager.h" // circular
@@ -54,11 +60,16 @@
 /**************************************************************************************************/
 
 class QcMapView;
+class QcMapViewLayerPreparation;
 
 class QC_EXPORT QcMapViewLayer : public QObject
 {
   Q_OBJECT
 
+ public:
+  // Time the zoom level must be stable before the missing tiles are fetched [ms]
+  static constexpr int DEFAULT_ZOOM_SETTLE_INTERVAL = 150;
+
  public:
   QcMapViewLayer(const QcWmtsPluginLayer * plugin_layer, QcViewport * m_viewport, QcMapLayerScene * layer_scene);
   ~QcMapViewLayer();
@@ -69,18 +80,38 @@ class QC_EXPORT QcMapViewLayer : public QObject
 
   QcWmtsRequestManager * request_manager() { return m_request_manager; };
 
+  // Tiles covered by the viewport at the last update
+  const QcTileBitSet & visible_tiles() const { return m_visible_tiles; }
+
   float opacity() const;
   void set_opacity(float opacity);
 
+  // 0 fetches the tiles of each level as soon as it is drawn
+  int zoom_settle_interval() const { return m_zoom_settle_timer.interval(); }
+  void set_zoom_settle_interval(int interval);
+
   void update_tile(const QcTileSpec & tile_spec);
+  // Prepare then commit
   void update_scene();
+  // Thread-safe part of the update, it doesn't touch the caches nor the layer scene
+  void prepare_scene();
+  void commit_scene(QcViewport::ChangeFlags changes = QcViewport::AllChanges);
 
  signals:
   void scene_graph_changed();
 
+ private slots:
+  void request_deferred_tiles();
+
  private:
-  QcPolygon transform_polygon(const QcPolygon & polygon); // Fixme: const;
-  QcTileSpecSet intersec_polygon_with_grid(const QcPolygon & polygon, double tile_length_m, int zoom_level);
+  void add_cached_tiles(const QList<QSharedPointer<QcTileTexture> > & cached_tiles);
+  void transform_polygon(const QcPolygon & polygon, QcVectorDouble * vertexes); // Fixme: const;
+  void intersec_polygon_with_grid(const QcPolygon & polygon, double tile_length_m, int zoom_level,
+                                  QcTiledPolygonRunList & runs);
+  void update_frame(int zoom_level, int mosaic_size);
+  bool update_visible_part(const QcTiledPolygonRunList & runs, QcTileBitSet & visible_tiles);
+  bool update_fallback_tiles(const QcTileSpecSet & missing_tiles);
+  QcTileSpecSet to_tile_spec_set(const QcTileBitSet & tiles) const;
 
  private:
   const QcWmtsPluginLayer * m_plugin_layer;
@@ -88,11 +119,29 @@ class QC_EXPORT QcMapViewLayer : public QObject
   QcMapLayerScene * m_layer_scene;
 
   QcWmtsRequestManager * m_request_manager;
-
-  QcTileSpecSet m_west_visible_tiles;
-  QcTileSpecSet m_central_visible_tiles;
-  QcTileSpecSet m_east_visible_tiles;
-  QcTileSpecSet m_visible_tiles;
+  QTimer m_zoom_settle_timer;
+
+  // Tiles of the last update, used to compute the tiles entering and leaving the viewport
+  QcTileBitSet m_west_visible_tiles;
+  QcTileBitSet m_central_visible_tiles;
+  QcTileBitSet m_east_visible_tiles;
+  QcTileBitSet m_visible_tiles;
+
+  // Scratch buffers of the viewport update, they are reused so as to not allocate on pan
+  QcPolygonRasteriser m_rasteriser;
+  QcTiledPolygonRunList m_west_new_runs;
+  QcTiledPolygonRunList m_central_new_runs;
+  QcTiledPolygonRunList m_east_new_runs;
+  QcTileBitSet m_new_part_tiles;
+  QcTileBitSet m_new_visible_tiles;
+  QcTileBitSet m_tiles_added;
+  QcTileBitSet m_tiles_removed;
+
+  // Result of the preparation, applied by the commit, the tiles entering and leaving the viewport
+  // are m_tiles_added and m_tiles_removed
+  bool m_interval_defined;
+  bool m_zoom_level_changed;
+  bool m_visible_tiles_changed;
 };
 
 // typedef QSet<QcMapViewLayer *> QcMapViewLayerSet;
@@ -103,6 +152,10 @@ class QC_EXPORT QcMapView : public QObject
 {
   Q_OBJECT
 
+ public:
+  // Layers are prepared concurrently from this number of layers
+  static constexpr int DEFAULT_PARALLEL_PREPARATION_THRESHOLD = 2;
+
  public:
   QcMapView();
   ~QcMapView();
@@ -117,10 +170,12 @@ class QC_EXPORT QcMapView : public QObject
   float opacity(const QcWmtsPluginLayer * plugin_layer);
   void set_opacity(const QcWmtsPluginLayer * plugin_layer, float opacity);
   QList<const QcWmtsPluginLayer *> layers() const;
+  QcMapViewLayer * get_layer(const QcWmtsPluginLayer * plugin_layer);
 
   QSGNode * update_scene_graph(QSGNode * old_node, QQuickWindow * window) {
     return m_map_scene->update_scene_graph(old_node, window);
   }
+  bool has_pending_uploads() const { return m_map_scene->has_pending_uploads(); }
 
   void update_path(const QcDecoratedPathDouble * path) {
     m_map_scene->update_path(path);
@@ -129,21 +184,48 @@ class QC_EXPORT QcMapView : public QObject
   QcLocationCircleData & location_circle_data() { return m_location_circle_data; }
   const QcLocationCircleData & location_circle_data() const { return m_location_circle_data; }
 
+  // Paths and markers drawn on top of the map
+  QcOverlayLayer & overlay_layer() { return m_overlay_layer; }
+  const QcOverlayLayer & overlay_layer() const { return m_overlay_layer; }
+
+  // Durations of the scene update stages, disabled by default
+  QcFrameStatistics * frame_statistics() { return &m_frame_statistics; }
+
+  // Delay of the tile fetches after a zoom step, cf. QcMapViewLayer
+  int zoom_settle_interval() const { return m_zoom_settle_interval; }
+  void set_zoom_settle_interval(int interval);
+
+  // Number of layers from which they are prepared concurrently, at least two
+  int parallel_preparation_threshold() const { return m_parallel_preparation_threshold; }
+  void set_parallel_preparation_threshold(int number_of_layers);
+
  signals:
   void scene_graph_changed();
 
  public slots:
   void update_scene();
+  void update_viewport(QcViewport::ChangeFlags changes);
+
+ public:
+  // Two halves of update_viewport, the preparation reuses its buffers, thus it does not allocate on pan
+  void prepare_layers();
+  void commit_layers(QcViewport::ChangeFlags changes = QcViewport::AllChanges);
 
  private:
-  QcMapViewLayer * get_layer(const QcWmtsPluginLayer * plugin_layer);
   void update_zoom_level_interval();
 
  private:
   QcViewport * m_viewport;
   QcMapScene * m_map_scene;
   QcLocationCircleData m_location_circle_data;
+  QcOverlayLayer m_overlay_layer;
+  QcFrameStatistics m_frame_statistics;
+  int m_zoom_settle_interval;
+  int m_parallel_preparation_threshold;
+  QThreadPool m_layer_thread_pool; // prepare the layers, apart from the global pool
+  QSemaphore m_layer_preparation_done; // released by each runnable
   QList<QcMapViewLayer *> m_layers;
+  QList<QcMapViewLayerPreparation *> m_layer_preparations; // indexed as m_layers
   QHash<QString, QcMapViewLayer *> m_layer_map;
 };
 
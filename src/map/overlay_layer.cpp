@@ -0,0 +1,367 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include "overlay_layer.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+// Pixel quantities are stored as fixed point numbers in 1/16 px
+constexpr double PIXEL_UNIT = 16;
+
+static inline qint16
+to_fixed_point(double x)
+{
+  return qint16(qBound(-32767., std::round(x * PIXEL_UNIT), 32767.));
+}
+
+template <typename Vertex>
+static inline void
+set_colour(Vertex & vertex, const QColor & colour)
+{
+  vertex.r = colour.red();
+  vertex.g = colour.green();
+  vertex.b = colour.blue();
+  vertex.a = colour.alpha();
+}
+
+/* Set the quad of a segment, points are relative to the chunk origin.
+ *
+ * The quad is extended by the half line width along the segment so as to cover the joins.
+ */
+static void
+set_segment(QcOverlayPathVertex * quad,
+            const QcVectorDouble & point1,
+            const QcVectorDouble & point2,
+            const QcOverlayStyle & style)
+{
+  QcVectorDouble direction = point2 - point1;
+  double length = direction.magnitude();
+  if (length > 0)
+    direction /= length;
+  else
+    direction = QcVectorDouble(1, 0);
+
+  double half_width = .5 * style.width;
+  double half_extent = half_width + QcOverlayLayer::ANTIALIAS_MARGIN;
+  QcVectorDouble normal = direction.rotate_counter_clockwise_90() * half_extent;
+  QcVectorDouble tangent = direction * half_width;
+
+  for (int i = 0; i < QcOverlayLayer::NUMBER_OF_SEGMENT_VERTEXES; i++) {
+    QcOverlayPathVertex & vertex = quad[i];
+    bool end = i >= 2;
+    double side = i % 2 ? 1 : -1;
+    const QcVectorDouble & point = end ? point2 : point1;
+    QcVectorDouble offset = normal * side + (end ? tangent : - tangent);
+    vertex.x = point.x();
+    vertex.y = point.y();
+    vertex.offset_x = to_fixed_point(offset.x());
+    vertex.offset_y = to_fixed_point(offset.y());
+    set_colour(vertex, style.colour);
+    vertex.v = to_fixed_point(side * half_extent);
+    vertex.half_width = to_fixed_point(half_width);
+  }
+}
+
+static inline void
+set_segment_indexes(quint16 * indexes, int vertex_offset)
+{
+  quint16 i = vertex_offset;
+  indexes[0] = i;
+  indexes[1] = i + 1;
+  indexes[2] = i + 2;
+  indexes[3] = i + 2;
+  indexes[4] = i + 1;
+  indexes[5] = i + 3;
+}
+
+static void
+set_marker(QcOverlayMarkerVertex & vertex, const QcOverlayStyle & style)
+{
+  set_colour(vertex, style.colour);
+  double size = std::ceil(style.radius + 2 * QcOverlayLayer::ANTIALIAS_MARGIN);
+  vertex.radius = qBound(0., std::round(style.radius), 255.);
+  vertex.size = qBound(0., size, 255.);
+}
+
+/**************************************************************************************************/
+
+QcOverlayLayer::QcOverlayLayer(QObject * parent)
+  : QObject(parent),
+    m_next_item_id(0),
+    m_revision(0)
+{}
+
+QcOverlayLayer::~QcOverlayLayer()
+{}
+
+/* Return a chunk having room for the segments, else the last chunk if it has some room, else a
+ * new chunk.
+ */
+int
+QcOverlayLayer::allocate_path_chunk(int number_of_segments)
+{
+  int number_of_vertexes = number_of_segments * NUMBER_OF_SEGMENT_VERTEXES;
+  int number_of_chunks = m_path_chunks.size();
+  for (int i = 0; i < number_of_chunks; i++)
+    if (m_path_chunks[i].vertexes.size() + number_of_vertexes <= CHUNK_SIZE)
+      return i;
+
+  if (number_of_chunks and
+      m_path_chunks.last().vertexes.size() + NUMBER_OF_SEGMENT_VERTEXES <= CHUNK_SIZE)
+    return number_of_chunks - 1;
+
+  m_path_chunks.append(QcOverlayPathChunk());
+  return number_of_chunks;
+}
+
+int
+QcOverlayLayer::add_path(const QcPathDouble & path, const QcOverlayStyle & style)
+{
+  int item_id = m_next_item_id++;
+  Item & item = m_items[item_id];
+  item.is_marker = false;
+  item.style = style;
+  item.chunk = item.slot = -1;
+
+  const QcPathDouble::VertexListType & vertexes = path.vertexes();
+  int number_of_vertexes = vertexes.size();
+  int number_of_segments = 0;
+  if (number_of_vertexes >= 2)
+    number_of_segments = path.closed() and number_of_vertexes > 2 ? number_of_vertexes : number_of_vertexes - 1;
+
+  int segment_index = 0;
+  while (segment_index < number_of_segments) {
+    PathPiece piece;
+    piece.chunk = allocate_path_chunk(number_of_segments - segment_index);
+    QcOverlayPathChunk & chunk = m_path_chunks[piece.chunk];
+    if (chunk.vertexes.isEmpty())
+      chunk.origin = vertexes[segment_index];
+    int number_of_free_segments = (CHUNK_SIZE - chunk.vertexes.size()) / NUMBER_OF_SEGMENT_VERTEXES;
+    piece.number_of_segments = qMin(number_of_free_segments, number_of_segments - segment_index);
+    piece.vertex_offset = chunk.vertexes.size();
+    piece.index_offset = chunk.indexes.size();
+    chunk.vertexes.resize(piece.vertex_offset + piece.number_of_segments * NUMBER_OF_SEGMENT_VERTEXES);
+    chunk.indexes.resize(piece.index_offset + piece.number_of_segments * NUMBER_OF_SEGMENT_INDEXES);
+
+    int vertex_offset = piece.vertex_offset;
+    quint16 * indexes = chunk.indexes.data() + piece.index_offset;
+    for (int i = 0; i < piece.number_of_segments; i++, segment_index++) {
+      QcVectorDouble point1 = (vertexes[segment_index] - chunk.origin).mirror_y();
+      QcVectorDouble point2 = (vertexes[(segment_index + 1) % number_of_vertexes] - chunk.origin).mirror_y();
+      set_segment(chunk.vertexes.data() + vertex_offset, point1, point2, style);
+      set_segment_indexes(indexes, vertex_offset);
+      vertex_offset += NUMBER_OF_SEGMENT_VERTEXES;
+      indexes += NUMBER_OF_SEGMENT_INDEXES;
+    }
+
+    chunk.items << item_id;
+    chunk.revision = ++m_revision;
+    item.pieces << piece;
+  }
+
+  emit changed();
+  return item_id;
+}
+
+int
+QcOverlayLayer::add_marker(const QcVectorDouble & coordinate, const QcOverlayStyle & style)
+{
+  int item_id = m_next_item_id++;
+  Item & item = m_items[item_id];
+  item.is_marker = true;
+  item.style = style;
+
+  // Reuse the slot of a removed marker
+  if (!m_free_marker_slots.isEmpty()) {
+    const QPair<int, int> & free_slot = m_free_marker_slots.takeLast();
+    item.chunk = free_slot.first;
+    item.slot = free_slot.second;
+  } else {
+    if (m_marker_chunks.isEmpty() or m_marker_chunks.last().vertexes.size() == CHUNK_SIZE) {
+      m_marker_chunks.append(QcOverlayMarkerChunk());
+      m_marker_chunks.last().origin = coordinate;
+    }
+    item.chunk = m_marker_chunks.size() - 1;
+    QcOverlayMarkerChunk & chunk = m_marker_chunks.last();
+    item.slot = chunk.vertexes.size();
+    chunk.vertexes.resize(item.slot + 1);
+  }
+
+  QcOverlayMarkerChunk & chunk = m_marker_chunks[item.chunk];
+  QcOverlayMarkerVertex & vertex = chunk.vertexes[item.slot];
+  QcVectorDouble position = (coordinate - chunk.origin).mirror_y();
+  vertex.x = position.x();
+  vertex.y = position.y();
+  set_marker(vertex, style);
+  chunk.revision = ++m_revision;
+
+  emit changed();
+  return item_id;
+}
+
+void
+QcOverlayLayer::remove(int item_id)
+{
+  if (!m_items.contains(item_id))
+    return;
+
+  Item item = m_items.take(item_id);
+  if (item.is_marker) {
+    // A null sprite is not drawn
+    QcOverlayMarkerChunk & chunk = m_marker_chunks[item.chunk];
+    QcOverlayMarkerVertex & vertex = chunk.vertexes[item.slot];
+    vertex.a = vertex.radius = vertex.size = 0;
+    chunk.revision = ++m_revision;
+    m_free_marker_slots << qMakePair(item.chunk, item.slot);
+  } else {
+    // The triangles are degenerated, the vertexes are reclaimed when the chunk is compacted
+    for (const PathPiece & piece : item.pieces) {
+      QcOverlayPathChunk & chunk = m_path_chunks[piece.chunk];
+      quint16 * indexes = chunk.indexes.data() + piece.index_offset;
+      std::fill(indexes, indexes + piece.number_of_segments * NUMBER_OF_SEGMENT_INDEXES, 0);
+      chunk.number_of_free_vertexes += piece.number_of_segments * NUMBER_OF_SEGMENT_VERTEXES;
+      chunk.items.remove(item_id);
+      chunk.revision = ++m_revision;
+      if (2 * chunk.number_of_free_vertexes > chunk.vertexes.size())
+        compact_path_chunk(piece.chunk);
+    }
+  }
+
+  emit changed();
+}
+
+//! Move the pieces of the chunk so as to remove the holes
+void
+QcOverlayLayer::compact_path_chunk(int chunk_index)
+{
+  QcOverlayPathChunk & chunk = m_path_chunks[chunk_index];
+  int number_of_vertexes = chunk.vertexes.size() - chunk.number_of_free_vertexes;
+  QVector<QcOverlayPathVertex> vertexes;
+  QVector<quint16> indexes;
+  vertexes.reserve(number_of_vertexes);
+  indexes.reserve(number_of_vertexes / NUMBER_OF_SEGMENT_VERTEXES * NUMBER_OF_SEGMENT_INDEXES);
+
+  for (int item_id : chunk.items)
+    for (PathPiece & piece : m_items[item_id].pieces) {
+      if (piece.chunk != chunk_index)
+        continue;
+      int vertex_offset = vertexes.size();
+      int index_offset = indexes.size();
+      int piece_number_of_vertexes = piece.number_of_segments * NUMBER_OF_SEGMENT_VERTEXES;
+      for (int i = 0; i < piece_number_of_vertexes; i++)
+        vertexes << chunk.vertexes[piece.vertex_offset + i];
+      indexes.resize(index_offset + piece.number_of_segments * NUMBER_OF_SEGMENT_INDEXES);
+      for (int i = 0; i < piece.number_of_segments; i++)
+        set_segment_indexes(indexes.data() + index_offset + i * NUMBER_OF_SEGMENT_INDEXES,
+                            vertex_offset + i * NUMBER_OF_SEGMENT_VERTEXES);
+      piece.vertex_offset = vertex_offset;
+      piece.index_offset = index_offset;
+    }
+
+  chunk.vertexes = vertexes;
+  chunk.indexes = indexes;
+  chunk.number_of_free_vertexes = 0;
+  chunk.revision = ++m_revision;
+}
+
+void
+QcOverlayLayer::clear()
+{
+  m_items.clear();
+  m_path_chunks.clear();
+  m_marker_chunks.clear();
+  m_free_marker_slots.clear();
+  emit changed();
+}
+
+QcOverlayStyle
+QcOverlayLayer::style(int item_id) const
+{
+  return m_items.value(item_id).style;
+}
+
+void
+QcOverlayLayer::set_style(int item_id, const QcOverlayStyle & style)
+{
+  if (!m_items.contains(item_id))
+    return;
+
+  Item & item = m_items[item_id];
+  if (item.style == style)
+    return;
+  item.style = style;
+  if (item.is_marker)
+    set_marker_style(item);
+  else
+    set_path_style(item);
+
+  emit changed();
+}
+
+void
+QcOverlayLayer::set_path_style(const Item & item)
+{
+  for (const PathPiece & piece : item.pieces) {
+    QcOverlayPathChunk & chunk = m_path_chunks[piece.chunk];
+    QcOverlayPathVertex * quad = chunk.vertexes.data() + piece.vertex_offset;
+    for (int i = 0; i < piece.number_of_segments; i++) {
+      // The quad ends are the segment vertexes
+      QcVectorDouble point1(quad[0].x, quad[0].y);
+      QcVectorDouble point2(quad[2].x, quad[2].y);
+      set_segment(quad, point1, point2, item.style);
+      quad += NUMBER_OF_SEGMENT_VERTEXES;
+    }
+    chunk.revision = ++m_revision;
+  }
+}
+
+void
+QcOverlayLayer::set_marker_style(const Item & item)
+{
+  QcOverlayMarkerChunk & chunk = m_marker_chunks[item.chunk];
+  set_marker(chunk.vertexes[item.slot], item.style);
+  chunk.revision = ++m_revision;
+}
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -0,0 +1,213 @@
+// -*- mode: c++ -*-
+
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#ifndef __OVERLAY_LAYER_H__
+#define __OVERLAY_LAYER_H__
+
+/**************************************************************************************************/
+
+#include "qtcarto_global.h"
+#include "geometry/path.h"
+#include "geometry/vector.h"
+
+#include <QColor>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+struct QC_EXPORT QcOverlayStyle
+{
+  QcOverlayStyle(const QColor & colour = QColor(0, 0, 255), double width = 5, double radius = 10)
+    : colour(colour), width(width), radius(radius)
+  {}
+
+  bool operator==(const QcOverlayStyle & other) const {
+    return colour == other.colour and width == other.width and radius == other.radius;
+  }
+
+  QColor colour;
+  double width; // line width [px]
+  double radius; // marker radius [px]
+};
+
+/**************************************************************************************************/
+
+/* The position is given in the projected coordinate system relatively to the chunk origin, y axis
+ * pointing down.  The extrusion offset, the distance to the centre line and the half line width
+ * are fixed point numbers in 1/16 px.
+ */
+struct QcOverlayPathVertex
+{
+  float x;
+  float y;
+  qint16 offset_x;
+  qint16 offset_y;
+  quint8 r;
+  quint8 g;
+  quint8 b;
+  quint8 a;
+  qint16 v;
+  qint16 half_width;
+};
+
+// A marker is drawn as a point sprite, same layout as the path node markers
+struct QcOverlayMarkerVertex
+{
+  float x;
+  float y;
+  quint8 r;
+  quint8 g;
+  quint8 b;
+  quint8 a;
+  quint8 radius; // [px]
+  quint8 size; // half size of the sprite [px]
+  quint8 padding[2];
+};
+
+/* The vertexes of a chunk are drawn by a single draw call, its vertexes are indexed by 16-bit
+ * indexes.  The revision is stamped from a counter of the layer on each change, thus the scene
+ * graph only copies the changed chunks, even when a chunk is recreated after a clear.
+ */
+struct QcOverlayPathChunk
+{
+  QcVectorDouble origin; // in projected coordinate system
+  QVector<QcOverlayPathVertex> vertexes;
+  QVector<quint16> indexes;
+  QSet<int> items;
+  int number_of_free_vertexes = 0; // vertexes of the removed items
+  int revision = 0;
+};
+
+struct QcOverlayMarkerChunk
+{
+  QcVectorDouble origin; // in projected coordinate system
+  QVector<QcOverlayMarkerVertex> vertexes;
+  int revision = 0;
+};
+
+/**************************************************************************************************/
+
+/*! Layer of paths and markers drawn on top of the map.
+ *
+ * Items are stored in shared chunks of vertexes, each item records its offsets within the
+ * chunks, thus adding, removing or restyling an item only touches its own vertexes.  A path
+ * is drawn as a list of segment quads, a marker as a point sprite.  A path longer than a chunk
+ * is split across several chunks.
+ *
+ * Coordinates are given in the projected coordinate system of the map.
+ */
+class QC_EXPORT QcOverlayLayer : public QObject
+{
+  Q_OBJECT
+
+public:
+  // Maximum number of vertexes of a chunk, indexes are 16-bit
+  static constexpr int CHUNK_SIZE = 1 << 16;
+  static constexpr int NUMBER_OF_SEGMENT_VERTEXES = 4;
+  static constexpr int NUMBER_OF_SEGMENT_INDEXES = 6;
+  // Antialias margin around the lines and markers [px]
+  static constexpr double ANTIALIAS_MARGIN = 1.;
+
+public:
+  QcOverlayLayer(QObject * parent = nullptr);
+  ~QcOverlayLayer();
+
+  // Return the item id, paths having less than two vertexes are not drawn
+  int add_path(const QcPathDouble & path, const QcOverlayStyle & style = QcOverlayStyle());
+  int add_marker(const QcVectorDouble & coordinate, const QcOverlayStyle & style = QcOverlayStyle());
+  void remove(int item_id);
+  void clear();
+
+  bool contains(int item_id) const { return m_items.contains(item_id); }
+  int number_of_items() const { return m_items.size(); }
+
+  QcOverlayStyle style(int item_id) const;
+  void set_style(int item_id, const QcOverlayStyle & style);
+
+  const QVector<QcOverlayPathChunk> & path_chunks() const { return m_path_chunks; }
+  const QVector<QcOverlayMarkerChunk> & marker_chunks() const { return m_marker_chunks; }
+
+signals:
+  void changed();
+
+private:
+  // Range of a path within a chunk
+  struct PathPiece
+  {
+    int chunk;
+    int vertex_offset;
+    int index_offset;
+    int number_of_segments;
+  };
+
+  struct Item
+  {
+    bool is_marker;
+    QcOverlayStyle style;
+    QVector<PathPiece> pieces; // path
+    int chunk; // marker
+    int slot; // marker
+  };
+
+  int allocate_path_chunk(int number_of_segments);
+  void compact_path_chunk(int chunk_index);
+  void set_path_style(const Item & item);
+  void set_marker_style(const Item & item);
+
+private:
+  int m_next_item_id;
+  int m_revision; // never reset, cf. chunk revision
+  QHash<int, Item> m_items;
+  QVector<QcOverlayPathChunk> m_path_chunks;
+  QVector<QcOverlayMarkerChunk> m_marker_chunks;
+  QVector<QPair<int, int>> m_free_marker_slots; // chunk, slot
+};
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/**************************************************************************************************/
+
+#endif /* __OVERLAY_LAYER_H__ */
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -346,7 +346,7 @@ QcViewport::set_viewport_size(const QSize & size, float device_pixel_ratio)
   update_zoom_level_interval();
 
   update_area_size();
-  update_area();
+  update_area(SizeChange);
 }
 
 void
@@ -411,7 +411,7 @@ QcViewport::set_center(const QcWgsCoordinate & coordinate)
   if (coordinate != m_state.coordinate()) {
     begin_state_transaction();
     m_state.set_coordinate(coordinate);
-    update_area(); // move polygon
+    update_area(TranslationChange); // move polygon
     end_state_transaction();
   }
 }
@@ -422,7 +422,7 @@ QcViewport::set_bearing(double bearing)
   if (bearing != m_state.bearing()) {
     begin_state_transaction();
     m_state.set_bearing(bearing);
-    update_area(); // rotate polygon
+    update_area(BearingChange); // rotate polygon
     end_state_transaction();
   }
 }
@@ -435,7 +435,7 @@ QcViewport::set_zoom_level(unsigned int zoom_level)
     begin_state_transaction();
     m_state.set_zoom_level(zoom_level);
     update_area_size();
-    update_area(); // scale polygon
+    update_area(ZoomChange); // scale polygon
     end_state_transaction();
   }
 }
@@ -456,7 +456,9 @@ QcViewport::zoom_at(const QcWgsCoordinate & coordinate, unsigned int zoom_level)
   if (zoom_level != m_state.zoom_level() and m_zoom_level_interval.contains(zoom_level)) {
     begin_state_transaction();
     m_state.set_zoom_level(zoom_level);
-    set_center(coordinate); // move and scale polygon
+    m_state.set_coordinate(coordinate);
+    update_area_size();
+    update_area(ZoomChange | TranslationChange); // move and scale polygon
     end_state_transaction();
   }
 }
@@ -583,7 +585,7 @@ QcViewport::adjust_center()
 }
 
 void
-QcViewport::update_area()
+QcViewport::update_area(ChangeFlags changes)
 {
   // Fixme: to_px truncate to int, thus we have an incertitude of 1 px, ok ?
 
@@ -730,7 +732,49 @@ QcViewport::update_area()
   //         << "East part" << m_east_part << '\n'
   //         << "Number of full maps" << m_number_of_full_maps;
 
-  emit viewport_changed();
+  mark_changed(changes);
+}
+
+void
+QcViewport::mark_changed(ChangeFlags changes)
+{
+  bool was_pending = m_pending_changes != NoChange;
+  m_pending_changes |= changes;
+  if (was_pending)
+    return;
+
+  if (m_frame_driven)
+    emit frame_requested();
+  else if (!m_flush_queued) {
+    m_flush_queued = true;
+    QMetaObject::invokeMethod(this, "flush_changes", Qt::QueuedConnection);
+  }
+}
+
+void
+QcViewport::set_frame_driven(bool frame_driven)
+{
+  m_frame_driven = frame_driven;
+  if (m_pending_changes != NoChange) {
+    ChangeFlags changes = m_pending_changes;
+    m_pending_changes = NoChange;
+    mark_changed(changes); // reschedule
+  }
+}
+
+/*! Notify the changes accumulated since the last call, e.g. a touch move and a flick animation
+ *  step that occurred during the same frame.
+ */
+void
+QcViewport::flush_changes()
+{
+  m_flush_queued = false;
+  if (m_pending_changes == NoChange)
+    return;
+
+  ChangeFlags changes = m_pending_changes;
+  m_pending_changes = NoChange;
+  emit viewport_changed(changes);
 }
 
 const QcViewportPart *
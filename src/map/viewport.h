@@ -232,6 +232,18 @@ class QC_EXPORT QcViewport : public QObject
 {
   Q_OBJECT
 
+ public:
+  // What changed since the last viewport_changed signal
+  enum ChangeFlag {
+    NoChange = 0x00,
+    TranslationChange = 0x01,
+    ZoomChange = 0x02,
+    BearingChange = 0x04,
+    SizeChange = 0x08,
+    AllChanges = 0xFF
+  };
+  Q_DECLARE_FLAGS(ChangeFlags, ChangeFlag)
+
  public:
   static QcInterval2DDouble interval_from_center_and_size(const QcVectorDouble & center, const QcVectorDouble & size);
 
@@ -303,16 +315,31 @@ class QC_EXPORT QcViewport : public QObject
 
   QcMapScale make_scale(unsigned int max_length_px);
 
+  /* Changes are coalesced and notified once by flush_changes.
+   *
+   * When the viewport is frame driven, the owner must call flush_changes once per frame, else
+   * the flush is queued to the event loop.
+   */
+  bool is_frame_driven() const { return m_frame_driven; }
+  void set_frame_driven(bool frame_driven);
+  ChangeFlags pending_changes() const { return m_pending_changes; }
+
+ public slots:
+  void flush_changes();
+
  signals:
-  void viewport_changed();
+  void viewport_changed(QcViewport::ChangeFlags changes);
+  // Emitted when a change is pending and the viewport is frame driven
+  void frame_requested();
 
  private:
   const QcTiledZoomLevel & tiled_zoom_level() const { return m_state.tiled_zoom_level(); }
   void update_zoom_level_interval();
   void update_area_size();
   QcVectorDouble inf_point() const;
-  void update_area();
+  void update_area(ChangeFlags changes);
   const QcViewportPart * find_part(const QcVectorDouble & projected_coordinate) const;
+  void mark_changed(ChangeFlags changes);
   void begin_state_transaction();
   void end_state_transaction();
   QcPolygon compute_polygon() const;
@@ -348,8 +375,14 @@ class QC_EXPORT QcViewport : public QObject
   bool m_cross_west_line;
   bool m_cross_east_line;
   int m_number_of_full_maps;
+
+  ChangeFlags m_pending_changes = NoChange;
+  bool m_frame_driven = false;
+  bool m_flush_queued = false;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(QcViewport::ChangeFlags)
+
 /**************************************************************************************************/
 
 #endif /* __VIEWPORT_H__ */
@@ -29,17 +29,128 @@
 #include "map_scene.h"
 #include "map_scene_private.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include <QSGTextureMaterial>
+
 /**************************************************************************************************/
 
 // QC_BEGIN_NAMESPACE
 
 /**************************************************************************************************/
 
+// Deepest ancestor drawn on a tile waiting for its upload
+constexpr int MAXIMUM_ANCESTOR_DEPTH = 4;
+
+/**************************************************************************************************/
+
+bool
+QcMapSideNode::update_origin(int level_, const QcVectorDouble & position)
+{
+  if (level_ == level and
+      qAbs(position.x() - origin.x()) < MAXIMUM_ORIGIN_DISTANCE and
+      qAbs(position.y() - origin.y()) < MAXIMUM_ORIGIN_DISTANCE)
+    return false;
+
+  level = level_;
+  origin = QcVectorDouble(std::floor(position.x()), std::floor(position.y()));
+  return true;
+}
+
+QSGGeometryNode *
+QcMapSideNode::page_node(QcTileAtlasPage * page, QSGGeometry * shared_geometry)
+{
+  QSGGeometryNode * node = page_nodes.value(page, nullptr);
+  if (node)
+    return node;
+
+  node = new QSGGeometryNode();
+  if (shared_geometry)
+    node->setGeometry(shared_geometry);
+  else {
+    QSGGeometry * geometry = new QSGGeometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 0, 0, GL_UNSIGNED_SHORT);
+    geometry->setDrawingMode(GL_TRIANGLES);
+    node->setGeometry(geometry);
+    node->setFlag(QSGNode::OwnsGeometry);
+  }
+
+  // Same materials as QSGSimpleTextureNode
+  QSGTextureMaterial * material = new QSGTextureMaterial();
+  material->setTexture(page);
+  material->setFiltering(QSGTexture::Linear);
+  node->setMaterial(material);
+  node->setFlag(QSGNode::OwnsMaterial);
+  QSGOpaqueTextureMaterial * opaque_material = new QSGOpaqueTextureMaterial();
+  opaque_material->setTexture(page);
+  opaque_material->setFiltering(QSGTexture::Linear);
+  node->setOpaqueMaterial(opaque_material);
+  node->setFlag(QSGNode::OwnsOpaqueMaterial);
+
+  page_nodes.insert(page, node);
+  appendChildNode(node);
+  return node;
+}
+
 void
-QcMapSideNode::add_child(const QcTileSpec & tile_spec, QSGSimpleTextureNode * texture_node)
+QcMapSideNode::update_page_node(QcTileAtlasPage * page, const QcTileQuadList & quads)
 {
-  texture_nodes.insert(tile_spec, texture_node);
-  appendChildNode(texture_node);
+  QSGGeometryNode * node = page_node(page);
+  QSGGeometry * geometry = node->geometry();
+  int number_of_vertexes = quads.size();
+  size_t vertex_data_size = number_of_vertexes * sizeof(QSGGeometry::TexturedPoint2D);
+
+  // Pan at the same level, the batch renderer doesn't need to upload the same vertexes
+  if (geometry->vertexCount() == number_of_vertexes and
+      memcmp(geometry->vertexData(), quads.constData(), vertex_data_size) == 0)
+    return;
+
+  if (geometry->vertexCount() != number_of_vertexes) {
+    int number_of_quads = number_of_vertexes / 4;
+    geometry->allocate(number_of_vertexes, 6 * number_of_quads);
+    quint16 * indexes = geometry->indexDataAsUShort();
+    for (int i = 0; i < number_of_quads; i++) {
+      quint16 base = 4 * i;
+      // Vertex order is top left, bottom left, top right and bottom right
+      quint16 * quad_indexes = indexes + 6 * i;
+      quad_indexes[0] = base;
+      quad_indexes[1] = base + 1;
+      quad_indexes[2] = base + 2;
+      quad_indexes[3] = base + 2;
+      quad_indexes[4] = base + 1;
+      quad_indexes[5] = base + 3;
+    }
+  }
+  memcpy(geometry->vertexData(), quads.constData(), vertex_data_size);
+  node->markDirty(QSGNode::DirtyGeometry);
+  dirty_geometry = true;
+}
+
+void
+QcMapSideNode::remove_page_node(QcTileAtlasPage * page)
+{
+  delete page_nodes.take(page);
+}
+
+void
+QcMapSideNode::share_pages(const QcMapSideNode * source)
+{
+  // The source must be updated before its clones, a removed page node deletes its geometry
+  for (auto it = page_nodes.begin(); it != page_nodes.end();) {
+    QSGGeometryNode * source_node = source->page_nodes.value(it.key(), nullptr);
+    if (!source_node or source_node->geometry() != it.value()->geometry()) {
+      delete it.value();
+      it = page_nodes.erase(it);
+    } else
+      ++it;
+  }
+
+  for (auto it = source->page_nodes.constBegin(); it != source->page_nodes.constEnd(); ++it) {
+    bool exists = page_nodes.contains(it.key());
+    QSGGeometryNode * node = page_node(it.key(), it.value()->geometry());
+    if (exists and source->dirty_geometry)
+      node->markDirty(QSGNode::DirtyGeometry);
+  }
 }
 
 /**************************************************************************************************/
@@ -51,7 +162,8 @@ QcMapLayerRootNode::QcMapLayerRootNode(const QcTileMatrixSet & tile_matrix_set,
     // grid_node(new QcGridNode(tile_matrix_set, viewport)),
     west_map_node(new QcMapSideNode()),
     central_map_node(new QcMapSideNode()),
-    east_map_node(new QcMapSideNode())
+    east_map_node(new QcMapSideNode()),
+    atlas(new QcTileAtlas(tile_matrix_set.tile_size()))
 {
   // qInfo();
 
@@ -65,7 +177,7 @@ QcMapLayerRootNode::QcMapLayerRootNode(const QcTileMatrixSet & tile_matrix_set,
 
 QcMapLayerRootNode::~QcMapLayerRootNode()
 {
-  qDeleteAll(textures);
+  delete atlas;
 }
 
 void
@@ -77,6 +189,7 @@ QcMapLayerRootNode::update_central_maps()
     qInfo() << "remove clone";
     auto * node = central_map_nodes.takeLast();
     removeChildNode(node);
+    delete node;
   }
   if (number_of_clones) {
     while (central_map_nodes.size() < number_of_clones) {
@@ -92,98 +205,182 @@ QcMapLayerRootNode::update_central_maps()
 void
 QcMapLayerRootNode::update_tiles(QcMapLayerScene * map_scene,
                                  QcMapSideNode * map_side_node,
-                                 const QcTileSpecSet & visible_tiles,
+                                 const QcTileBitSet & visible_tiles,
                                  const QcPolygon & polygon,
                                  const QcViewportPart & part)
 {
   // float width = map_scene->width();
   // float height = map_scene->height();
 
+  QcVectorDouble position = part_position(polygon);
+  bool origin_changed = map_side_node->update_origin(m_viewport->zoom_level(), position);
+  update_matrix(map_side_node, position, part);
+
+  map_side_node->dirty_geometry = false;
+  if (!origin_changed and !map_scene->is_dirty_geometry())
+    return;
+
+  const QcVectorDouble & origin = map_side_node->origin;
+
+  for (auto & quads : m_page_quads)
+    quads.resize(0); // keep the capacity
+
+  // Fallbacks are drawn first, thus below the exact tiles
+  add_fallback_tiles(map_scene, visible_tiles, origin);
+
+  QSGGeometry::TexturedPoint2D vertexes[4];
+  const QcWmtsPluginLayer * plugin_layer = map_scene->plugin_layer();
+  int level = visible_tiles.level();
+  visible_tiles.for_each([&](int x, int y) {
+      QcTileSpec tile_spec = plugin_layer->create_tile_spec(level, x, y);
+      const QcTileAtlasSlot * slot = atlas->use(tile_spec);
+      // && qgeotiledmapscene_isTileInViewport(v, map_side_node->matrix())
+      if (slot and map_scene->build_geometry(tile_spec, vertexes, origin))
+        add_quad(slot, vertexes);
+    });
+
+  // qInfo() << "Offset" << x_offset << "visible_tiles" << visible_tiles;
+
+  for (auto it = m_page_quads.constBegin(); it != m_page_quads.constEnd(); ++it)
+    if (it.value().isEmpty())
+      map_side_node->remove_page_node(it.key());
+    else
+      map_side_node->update_page_node(it.key(), it.value());
+}
+
+void
+QcMapLayerRootNode::update_clone(QcMapSideNode * clone, const QcPolygon & polygon, const QcViewportPart & part)
+{
+  clone->level = central_map_node->level;
+  clone->origin = central_map_node->origin;
+  update_matrix(clone, part_position(polygon), part);
+  clone->share_pages(central_map_node);
+}
+
+void
+QcMapLayerRootNode::remove_released_pages()
+{
+  const QList<QcTileAtlasPage *> & pages = atlas->released_pages();
+  if (pages.isEmpty())
+    return;
+
+  for (auto * page : pages) {
+    // Clones share the geometry of the central node
+    for (auto * clone : central_map_nodes)
+      clone->remove_page_node(page);
+    for (auto * map_side_node : {west_map_node, central_map_node, east_map_node})
+      map_side_node->remove_page_node(page);
+    m_page_quads.remove(page);
+  }
+  atlas->delete_released_pages();
+}
+
+//! Return the position of the viewport part in the pixel space of the level
+QcVectorDouble
+QcMapLayerRootNode::part_position(const QcPolygon & polygon) const
+{
+  double resolution = m_tile_matrix_set[m_viewport->zoom_level()].resolution(); // [m/px]
+  const QcInterval2DDouble & interval = polygon.interval();
+  return QcVectorDouble(interval.x().inf() / resolution, interval.y().inf() / resolution);
+}
+
+//! Apply the pan and the offset of the part using the matrix of the node
+void
+QcMapLayerRootNode::update_matrix(QcMapSideNode * map_side_node, const QcVectorDouble & position, const QcViewportPart & part)
+{
   QMatrix4x4 space_matrix;
   space_matrix.setToIdentity();
   const QcInterval2DDouble & screen_interval = part.screen_interval();
-  double x_offset = screen_interval.x().inf();
-  double y_offset = screen_interval.y().inf();
+  const QcVectorDouble & origin = map_side_node->origin;
+  double x_offset = screen_interval.x().inf() + origin.x() - position.x();
+  double y_offset = screen_interval.y().inf() + origin.y() - position.y();
   space_matrix.translate(x_offset, y_offset);
   map_side_node->setMatrix(space_matrix);
   // qInfo() << "map side space matrix" << space_matrix;
+}
 
-  QcTileSpecSet tiles_in_scene = QcTileSpecSet::fromList(map_side_node->texture_nodes.keys()); // Fixme: cf. textured_tiles
-  QcTileSpecSet to_remove = tiles_in_scene - visible_tiles;
-  QcTileSpecSet to_add = visible_tiles - tiles_in_scene;
-
-  // qInfo() << "Offset" << x_offset
-  //         << "tiles_in_scene" << tiles_in_scene
-  //         << "\nvisible_tiles" << visible_tiles
-  //         << "\nto_remove" << to_remove
-  //         << "\nto_add" << to_add;
-
-  for (const auto & tile_spec : to_remove)
-    delete map_side_node->texture_nodes.take(tile_spec);
+//! Append the vertexes of a tile to the quads of its atlas page
+void
+QcMapLayerRootNode::add_quad(const QcTileAtlasSlot * slot, QSGGeometry::TexturedPoint2D * vertexes)
+{
+  if (vertexes[0].x == vertexes[3].x or
+      vertexes[0].y == vertexes[3].y) // top-left == bottom-right => invalid
+    return;
+
+  // Map the texture coordinates to the slot
+  const QRectF & texture_rect = slot->texture_rect;
+  QcTileQuadList & quads = m_page_quads[slot->page];
+  if (quads.size() + 4 > 0xFFFF) { // ushort indexes
+    qWarning() << "Too many tiles in an atlas page";
+    return;
+  }
+  for (int i = 0; i < 4; i++) {
+    QSGGeometry::TexturedPoint2D vertex = vertexes[i];
+    vertex.tx = texture_rect.x() + vertex.tx * texture_rect.width();
+    vertex.ty = texture_rect.y() + vertex.ty * texture_rect.height();
+    quads << vertex;
+  }
+}
 
-  // Update tile geometries
-  // for (auto * texture_node : map_side_node->texture_nodes) {
-  for (QHash<QcTileSpec, QSGSimpleTextureNode *>::iterator it = map_side_node->texture_nodes.begin();
-       it != map_side_node->texture_nodes.end(); ) {
+/*! Fill the tiles in flight with the fallback textures
+ *
+ * An ancestor is drawn as a sub-rectangle of its texture on the missing tile, whereas a child is
+ * drawn on its quarter of the missing tile.  The fallbacks are dropped as soon as the exact tile
+ * is in the atlas.
+ *
+ * A received tile which was not uploaded due to the upload budget is covered by its nearest
+ * ancestor already in the atlas.
+ */
+void
+QcMapLayerRootNode::add_fallback_tiles(QcMapLayerScene * map_scene,
+                                       const QcTileBitSet & visible_tiles,
+                                       const QcVectorDouble & origin)
+{
+  QSGGeometry::TexturedPoint2D vertexes[4];
+  const QHash<QcTileSpec, QcTileTextureList> & fallback_textures = map_scene->m_fallback_textures;
+  for (auto it = fallback_textures.constBegin(); it != fallback_textures.constEnd(); ++it) {
     const QcTileSpec & tile_spec = it.key();
-    QSGSimpleTextureNode * texture_node = it.value();
-    // qInfo() << "texture nodes loop" << tile_spec;
-
-    // Compute new geometry
-    QSGGeometry visual_geometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 4);
-    QSGGeometry::TexturedPoint2D * vertexes = visual_geometry.vertexDataAsTexturedPoint2D();
-    bool ok = map_scene->build_geometry(tile_spec, vertexes, polygon); // && qgeotiledmapscene_isTileInViewport(v, map_side_node->matrix())
-
-    QSGNode::DirtyState dirty_bits = 0;
-    // Check and handle changes to vertex data.
-    if (ok && memcmp(texture_node->geometry()->vertexData(), vertexes, 4 * sizeof(QSGGeometry::TexturedPoint2D)) != 0) {
-      if (vertexes[0].x == vertexes[3].x ||
-          vertexes[0].y == vertexes[3].y) { // top-left == bottom-right => invalid => remove
-        ok = false;
-      } else {
-        // void *memcpy(void *dest, const void *src, int n);
-        // qInfo() << "update geometry" << tile_spec;
-        memcpy(texture_node->geometry()->vertexData(), vertexes, 4 * sizeof(QSGGeometry::TexturedPoint2D));
-        dirty_bits |= QSGNode::DirtyGeometry;
-      }
-    }
-
-    if (ok) {
-      if (dirty_bits != 0)
-        texture_node->markDirty(dirty_bits);
-      it++;
-    } else {
-      it = map_side_node->texture_nodes.erase(it);
-      delete texture_node;
+    if (!visible_tiles.contains(tile_spec) or atlas->contains(tile_spec))
+      continue;
+    for (const auto & tile_texture : it.value()) {
+      const QcTileSpec & source_tile_spec = tile_texture->tile_spec;
+      // The area is the missing tile or one of its children
+      const QcTileSpec & area = source_tile_spec.level() > tile_spec.level() ? source_tile_spec : tile_spec;
+      const QcTileAtlasSlot * slot = atlas->use(source_tile_spec);
+      if (slot and map_scene->build_geometry(area, source_tile_spec, vertexes, origin))
+        add_quad(slot, vertexes);
     }
   }
 
-  for (const auto & tile_spec : to_add) {
-    // Fixme: code !!!
-    QcTileTexture * tile_texture = map_scene->m_tile_textures.value(tile_spec).data(); // Fixme: m_tile_textures public
-    // qInfo() << "texture to add" << tile_spec << tile_texture;
-    if (tile_texture && !tile_texture->image.isNull()) {
-      // qInfo() << "create texture" << tile_spec;
-      QSGSimpleTextureNode * tile_node = new QSGSimpleTextureNode();
-      // note: setTexture will update coordinates so do it here, before we buildGeometry
-      tile_node->setTexture(textures.value(tile_spec));
-      if (map_scene->build_geometry(tile_spec, tile_node->geometry()->vertexDataAsTexturedPoint2D(), polygon)) {
-        // && qgeotiledmapscene_isTileInViewport(tileNode->geometry()->vertexDataAsTexturedPoint2D(), map_side_node->matrix())
-        tile_node->setFiltering(QSGTexture::Linear);
-        map_side_node->add_child(tile_spec, tile_node);
-      } else
-        delete tile_node;
-    }
-  }
+  const QcWmtsPluginLayer * plugin_layer = map_scene->plugin_layer();
+  int level = visible_tiles.level();
+  visible_tiles.for_each([&](int x, int y) {
+      QcTileSpec tile_spec = plugin_layer->create_tile_spec(level, x, y);
+      if (atlas->contains(tile_spec) or fallback_textures.contains(tile_spec))
+        return;
+      for (int depth = 1; depth <= MAXIMUM_ANCESTOR_DEPTH and depth <= level; depth++) {
+        QcTileSpec ancestor = plugin_layer->create_tile_spec(level - depth, x >> depth, y >> depth);
+        const QcTileAtlasSlot * slot = atlas->use(ancestor);
+        if (slot) {
+          if (map_scene->build_geometry(tile_spec, ancestor, vertexes, origin))
+            add_quad(slot, vertexes);
+          break;
+        }
+      }
+    });
 }
 
 /**************************************************************************************************/
 
-QcMapLayerScene::QcMapLayerScene(const QcWmtsPluginLayer * plugin_layer, const QcViewport * viewport, QObject * parent)
+QcMapLayerScene::QcMapLayerScene(const QcWmtsPluginLayer * plugin_layer, const QcViewport * viewport,
+                                 QcFrameStatistics * frame_statistics, QObject * parent)
   : QObject(parent),
     m_plugin_layer(plugin_layer),
     m_viewport(viewport),
+    m_frame_statistics(frame_statistics),
+    m_name(plugin_layer->hash_name()),
     m_tile_matrix_set(plugin_layer->plugin()->tile_matrix_set()),
+    m_dirty_geometry(true),
     m_opacity(1.),
     m_scene_graph_node(nullptr)
 {
@@ -198,6 +395,9 @@ QcMapLayerScene::add_tile(const QcTileSpec & tile_spec, QSharedPointer<QcTileTex
 {
   if (m_visible_tiles.contains(tile_spec)) { // Don't add the geometry if it isn't visible
     m_tile_textures.insert(tile_spec, texture);
+    // The exact tile replaces the fallback
+    m_fallback_textures.remove(tile_spec);
+    m_dirty_geometry = true;
     // qInfo() << "add_tile" << tile_spec << "inserted";
   }
   // else
@@ -205,64 +405,120 @@ QcMapLayerScene::add_tile(const QcTileSpec & tile_spec, QSharedPointer<QcTileTex
 }
 
 void
-QcMapLayerScene::set_visible_tiles(const QcTileSpecSet & tile_specs,
-                                   const QcTileSpecSet & west_tile_specs,
-                                   const QcTileSpecSet & central_tile_specs,
-                                   const QcTileSpecSet & east_tile_specs)
+QcMapLayerScene::add_fallback_tile(const QcTileSpec & tile_spec, const QcTileTextureList & textures)
 {
-  QcTileSpecSet to_remove = m_visible_tiles - tile_specs;
-  if (!to_remove.isEmpty())
-    remove_tiles(to_remove);
-  m_visible_tiles = tile_specs;
-  // Fixme: better ?
-  m_west_visible_tiles = west_tile_specs;
-  m_central_visible_tiles = central_tile_specs;
-  m_east_visible_tiles = east_tile_specs;
+  if (m_visible_tiles.contains(tile_spec) and !m_tile_textures.contains(tile_spec)) {
+    m_fallback_textures.insert(tile_spec, textures);
+    m_dirty_geometry = true;
+  }
+}
+
+void
+QcMapLayerScene::set_visible_tiles(const QcTileBitSet & tiles,
+                                   const QcTileBitSet & west_tiles,
+                                   const QcTileBitSet & central_tiles,
+                                   const QcTileBitSet & east_tiles)
+{
+  assign_visible_tiles(tiles, west_tiles, central_tiles, east_tiles);
+  remove_hidden_tiles();
+  m_dirty_geometry = true;
+}
+
+void
+QcMapLayerScene::update_visible_tiles(const QcTileSpecSetDiff & tiles_diff,
+                                      const QcTileBitSet & tiles,
+                                      const QcTileBitSet & west_tiles,
+                                      const QcTileBitSet & central_tiles,
+                                      const QcTileBitSet & east_tiles)
+{
+  if (!tiles_diff.removed.isEmpty())
+    remove_tiles(tiles_diff.removed);
+  assign_visible_tiles(tiles, west_tiles, central_tiles, east_tiles);
+  m_dirty_geometry = true;
+}
+
+//! Copy the tile sets, their buffers are reused
+void
+QcMapLayerScene::assign_visible_tiles(const QcTileBitSet & tiles,
+                                      const QcTileBitSet & west_tiles,
+                                      const QcTileBitSet & central_tiles,
+                                      const QcTileBitSet & east_tiles)
+{
+  m_visible_tiles.assign(tiles);
+  m_west_visible_tiles.assign(west_tiles);
+  m_central_visible_tiles.assign(central_tiles);
+  m_east_visible_tiles.assign(east_tiles);
 }
 
 void
 QcMapLayerScene::remove_tiles(const QcTileSpecSet & old_tiles)
 {
   // qInfo() << old_tiles;
-  for (auto tile_spec : old_tiles)
+  for (auto tile_spec : old_tiles) {
     m_tile_textures.remove(tile_spec);
+    m_fallback_textures.remove(tile_spec);
+  }
 }
 
-QcTileSpecSet
-QcMapLayerScene::textured_tiles() const
+//! Remove the textures of the tiles which are no longer visible
+void
+QcMapLayerScene::remove_hidden_tiles()
 {
-  return QcTileSpecSet::fromList(m_tile_textures.keys());
+  for (auto it = m_tile_textures.begin(); it != m_tile_textures.end();)
+    if (m_visible_tiles.contains(it.key()))
+      ++it;
+    else
+      it = m_tile_textures.erase(it);
+  for (auto it = m_fallback_textures.begin(); it != m_fallback_textures.end();)
+    if (m_visible_tiles.contains(it.key()))
+      ++it;
+    else
+      it = m_fallback_textures.erase(it);
 }
 
 bool
-QcMapLayerScene::build_geometry(const QcTileSpec & tile_spec, QSGGeometry::TexturedPoint2D * vertices, const QcPolygon & polygon)
+QcMapLayerScene::build_geometry(const QcTileSpec & tile_spec, QSGGeometry::TexturedPoint2D * vertices, const QcVectorDouble & origin)
 {
+  return build_geometry(tile_spec, tile_spec, vertices, origin);
+}
+
+/*! Build the geometry of the tile area using the texture of the source tile.
+ *
+ * The area can be at a higher level than the viewport, e.g. a child, and the source must contain
+ * the area, e.g. an ancestor, in this case the texture coordinates span a sub-rectangle.
+ */
+bool
+QcMapLayerScene::build_geometry(const QcTileSpec & tile_spec, const QcTileSpec & source_tile_spec,
+                                QSGGeometry::TexturedPoint2D * vertices, const QcVectorDouble & origin)
+{
+  int level_delta = tile_spec.level() - source_tile_spec.level();
+  if (level_delta < 0)
+    return false;
+
   int tile_size = m_tile_matrix_set.tile_size();
-  const QcTileMatrix & tile_matrix = m_tile_matrix_set[m_viewport->zoom_level()];
-  // double tile_length_m = tile_matrix.tile_length_m();
-  double resolution = tile_matrix.resolution(); // [m/px]
 
-  const QcInterval2DDouble & interval = polygon.interval();
-  double x_inf_m = interval.x().inf();
-  double y_inf_m = interval.y().inf();
-  // double y_sup_m = interval.y().sup();
-  double x_inf_px = x_inf_m / resolution;
-  double y_inf_px = y_inf_m / resolution;
-  //double y_sup_px = y_sup_m / resolution;
+  // Size of the area at the viewport level
+  double area_size = std::ldexp(double(tile_size), m_viewport->zoom_level() - tile_spec.level());
+  double x = tile_spec.x() * area_size;
+  double y = tile_spec.y() * area_size;
 
-  double x = tile_spec.x() * tile_size;
-  double y = tile_spec.y() * tile_size;
+  double x1 = x - origin.x();
+  double y1 = y - origin.y();
+  double x2 = x1 + area_size;
+  double y2 = y1 + area_size;
 
-  double x1 = (x - x_inf_px) * 1;
-  double y1 = (y - y_inf_px) * 1;
-  double x2 = x1 + 1.0 * tile_size * 1;
-  double y2 = y1 + 1.0 * tile_size * 1;
+  // Position of the area in the source texture
+  int number_of_areas = 1 << level_delta;
+  float u1 = float(tile_spec.x() - (source_tile_spec.x() << level_delta)) / number_of_areas;
+  float v1 = float(tile_spec.y() - (source_tile_spec.y() << level_delta)) / number_of_areas;
+  float u2 = u1 + 1.f / number_of_areas;
+  float v2 = v1 + 1.f / number_of_areas;
 
   // Texture coordinate order for veritcal flip of texture
-  vertices[0].set(x1, y1, 0, 0);
-  vertices[1].set(x1, y2, 0, 1);
-  vertices[2].set(x2, y1, 1, 0);
-  vertices[3].set(x2, y2, 1, 1);
+  vertices[0].set(x1, y1, u1, v1);
+  vertices[1].set(x1, y2, u1, v2);
+  vertices[2].set(x2, y1, u2, v1);
+  vertices[3].set(x2, y2, u2, v2);
 
   // qInfo() << "geometry" << tile_spec << "x" << x1 << x2 << "  y" << y1 << y2;
 
@@ -289,31 +545,85 @@ QcMapLayerScene::transform_polygon(const QcPolygon & polygon) const
   return transformed_polygon;
 }
 
-void
+/*! Update the layer node, return true if textures are left to upload on the next frames.
+ */
+bool
 QcMapLayerScene::update_scene_graph(QcMapLayerRootNode * map_root_node, QQuickWindow * window)
 {
   // qInfo();
 
+  QcStageTimer layer_timer(m_frame_statistics, QcFrameStatistics::LayerSceneGraphUpdate, m_name);
+
   if (map_root_node->opacity() != m_opacity)
     map_root_node->setOpacity(m_opacity);
   // dirty
 
-  // Fixme: duplicated code?
-  QcTileSpecSet textures_in_scene = QcTileSpecSet::fromList(map_root_node->textures.keys()); // cf. textured_tiles
-  QcTileSpecSet to_remove = textures_in_scene - m_visible_tiles;
-  QcTileSpecSet to_add = m_visible_tiles - textures_in_scene;
-  // qInfo() << "textures in scene" << textures_in_scene
-  //         << "to remove:" << to_remove
-  //         << "to add" << to_add;
-  for (const auto & tile_spec : to_remove)
-    map_root_node->textures.take(tile_spec)->deleteLater();
-  for (const auto & tile_spec : to_add) {
-    QcTileTexture * tile_texture = m_tile_textures.value(tile_spec).data();
-    if (tile_texture && !tile_texture->image.isNull()) {
-      // qInfo() << "create texture from image" << tile_spec;
-      QSGTexture * texture = window->createTextureFromImage(tile_texture->image);
-      map_root_node->textures.insert(tile_spec, texture);
-    }
+  // The atlas uploads the textures itself
+  Q_UNUSED(window);
+
+  // Pack the textures of the visible tiles and of their fallbacks, the tiles already in the atlas
+  // are marked as used first so as to not be evicted
+  QcTileAtlas * atlas = map_root_node->atlas;
+  atlas->begin_frame();
+
+  // Uploads are ordered by screen centrality
+  QcVectorDouble center = (m_viewport->projected_center_coordinate() - m_tile_matrix_set.origin()) * m_tile_matrix_set.scale();
+  auto distance_to_center = [this, &center](const QcTileSpec & tile_spec) {
+    double tile_length_m = m_tile_matrix_set[tile_spec.level()].tile_length_m();
+    QcVectorDouble tile_center = QcVectorDouble(tile_spec.x() + .5, tile_spec.y() + .5) * tile_length_m;
+    return (tile_center - center).magnitude();
+  };
+
+  typedef QPair<double, QcTileTexture *> Upload;
+  QVector<Upload> fallback_uploads;
+  QVector<Upload> tile_uploads;
+  int level = m_visible_tiles.level();
+  m_visible_tiles.for_each([&](int x, int y) {
+      QcTileSpec tile_spec = m_plugin_layer->create_tile_spec(level, x, y);
+      if (!atlas->use(tile_spec)) {
+        QcTileTexture * tile_texture = m_tile_textures.value(tile_spec).data();
+        if (tile_texture and !tile_texture->image.isNull())
+          tile_uploads << Upload(distance_to_center(tile_spec), tile_texture);
+      }
+    });
+  for (const auto & fallback : m_fallback_textures)
+    for (const auto & tile_texture : fallback)
+      if (!atlas->use(tile_texture->tile_spec) and !tile_texture->image.isNull())
+        fallback_uploads << Upload(distance_to_center(tile_texture->tile_spec), tile_texture.data());
+  auto by_distance = [](const Upload & upload1, const Upload & upload2) { return upload1.first < upload2.first; };
+  std::sort(fallback_uploads.begin(), fallback_uploads.end(), by_distance);
+  std::sort(tile_uploads.begin(), tile_uploads.end(), by_distance);
+
+  // Fallbacks come first since they cover several tiles, the tiles beyond the budget are drawn
+  // using a fallback or are left empty until a next frame
+  bool has_pending_uploads = false;
+  {
+    QcStageTimer upload_timer(m_frame_statistics, QcFrameStatistics::TextureUpload, m_name);
+    for (const QVector<Upload> * uploads : {&fallback_uploads, &tile_uploads})
+      for (const Upload & upload : *uploads) {
+        QcTileTexture * tile_texture = upload.second;
+        if (atlas->contains(tile_texture->tile_spec)) // ancestors are shared
+          continue;
+        if (!atlas->has_upload_budget()) {
+          has_pending_uploads = true;
+          break;
+        }
+        // qInfo() << "pack texture" << tile_texture->tile_spec;
+        // An insertion can evict a slot, thus the geometry must be rebuilt
+        m_dirty_geometry = true;
+        if (atlas->insert(tile_texture->tile_spec, tile_texture->image))
+          tile_texture->texture_bound = true;
+      }
+    atlas->upload();
+  }
+  // The decoded images are kept until their tiles leave the viewport, since a new root node has an
+  // empty atlas and must pack them again
+
+  // Free the pages having no tile drawn for a while, the geometry is then rebuilt
+  atlas->release_unused_pages();
+  if (!atlas->released_pages().isEmpty()) {
+    map_root_node->remove_released_pages();
+    m_dirty_geometry = true;
   }
 
   const QcTileMatrix & tile_matrix = m_tile_matrix_set[m_viewport->zoom_level()];
@@ -341,11 +651,7 @@ QcMapLayerScene::update_scene_graph(QcMapLayerRootNode * map_root_node, QQuickWi
   const QList<QcViewportPart> & clone_parts = m_viewport->central_part_clones();
   for (auto * node : map_root_node->central_map_nodes) {
     // qInfo() << "clone" << east_offset;
-    map_root_node->update_tiles(this,
-                                node,
-                                m_central_visible_tiles,
-                                transformed_central_polygon,
-                                clone_parts[clone_index++]);
+    map_root_node->update_clone(node, transformed_central_polygon, clone_parts[clone_index++]);
   }
 
   // qInfo() << "east" << east_offset;
@@ -355,6 +661,9 @@ QcMapLayerScene::update_scene_graph(QcMapLayerRootNode * map_root_node, QQuickWi
                               m_east_visible_tiles,
                               transform_polygon(east_part.polygon()),
                               east_part);
+  m_dirty_geometry = false;
+
+  return has_pending_uploads;
 }
 
 /**************************************************************************************************/
@@ -29,6 +29,7 @@
 #include "map_scene.h"
 #include "map_scene_private.h"
 
+#include <QThreadPool>
 #include <QtDebug>
 
 /**************************************************************************************************/
@@ -37,12 +38,63 @@
 
 /**************************************************************************************************/
 
+QcPathPyramidBuilder::QcPathPyramidBuilder(const QcPathDouble & path, double coarsest_tolerance, int number_of_levels)
+  : QObject(),
+    QRunnable(),
+    m_path(path),
+    m_coarsest_tolerance(coarsest_tolerance),
+    m_number_of_levels(number_of_levels)
+{
+  setAutoDelete(false); // deleted by the scene
+}
+
+void
+QcPathPyramidBuilder::run()
+{
+  m_pyramid.reset(new QcPathPyramid(m_path, m_coarsest_tolerance, m_number_of_levels));
+  emit finished();
+}
+
+/**************************************************************************************************/
+
+QcPolygonTriangulationBuilder::QcPolygonTriangulationBuilder(const QcPathDouble & path)
+  : QObject(),
+    QRunnable(),
+    m_path(path)
+{
+  setAutoDelete(false); // deleted by the scene
+}
+
+void
+QcPolygonTriangulationBuilder::run()
+{
+  m_triangulation.reset(new QcPolygonTriangulation(m_path));
+  emit finished();
+}
+
+/**************************************************************************************************/
+
 QcMapScene::QcMapScene(const QcViewport * viewport,
                        const QcLocationCircleData & location_circle_data,
+                       const QcOverlayLayer & overlay_layer,
+                       QcFrameStatistics * frame_statistics,
                        QObject * parent)
   : QObject(parent),
     m_viewport(viewport),
-    m_location_circle_data(location_circle_data)
+    m_frame_statistics(frame_statistics),
+    m_viewport_changes(QcViewport::AllChanges),
+    m_path(nullptr),
+    m_dirty_path(false),
+    m_path_pyramid_builder(nullptr),
+    m_outdated_path_pyramid(false),
+    m_path_level(-1),
+    m_polygon_triangulation_builder(nullptr),
+    m_outdated_polygon_triangulation(false),
+    m_dirty_polygon(false),
+    m_location_circle_data(location_circle_data),
+    m_overlay_layer(overlay_layer),
+    m_dirty_overlay(true),
+    m_pending_uploads(false)
 {
   // connect(&m_location_circle_data, QcLocationCircleData::horizontal_precisionChanged,
   //         this, QcMapScene::set_location_circle_data_dirty);
@@ -54,6 +106,9 @@ QcMapScene::QcMapScene(const QcViewport * viewport,
           this, &QcMapScene::set_location_circle_data_dirty);
   connect(&m_location_circle_data, &QcLocationCircleData::bearing_changed,
           this, &QcMapScene::set_location_circle_data_dirty);
+
+  connect(&m_overlay_layer, &QcOverlayLayer::changed,
+          this, &QcMapScene::set_overlay_dirty);
 }
 
 QcMapScene::~QcMapScene()
@@ -62,7 +117,7 @@ QcMapScene::~QcMapScene()
 QcMapLayerScene *
 QcMapScene::add_layer(const QcWmtsPluginLayer * plugin_layer)
 {
-  QcMapLayerScene * layer = new QcMapLayerScene(plugin_layer, m_viewport);
+  QcMapLayerScene * layer = new QcMapLayerScene(plugin_layer, m_viewport, m_frame_statistics);
   m_layers << layer;
   m_layer_map.insert(plugin_layer->hash_name(), layer);
   return layer;
@@ -81,10 +136,85 @@ QcMapScene::remove_layer(const QcWmtsPluginLayer * plugin_layer)
   }
 }
 
+/* The path is drawn as is and its fill is removed until the builds are done.
+ *
+ * A builder copies the path, thus a single build of each kind runs at once.  An edit during a build
+ * marks its result as outdated, and the build is run again on the last path once it finishes, thus
+ * a burst of edits costs at most two builds.
+ */
 void
 QcMapScene::update_path(const QcDecoratedPathDouble * path) {
   m_path = path;
   m_dirty_path = true;
+  m_path_pyramid.clear();
+  m_polygon_triangulation.clear();
+  m_dirty_polygon = true;
+
+  update_polygon_triangulation();
+  update_path_pyramid();
+}
+
+void
+QcMapScene::update_path_pyramid()
+{
+  if (m_path_pyramid_builder) {
+    m_outdated_path_pyramid = true;
+    return;
+  }
+  m_outdated_path_pyramid = false;
+
+  if (!m_path or m_path->number_of_vertexes() < MINIMUM_NUMBER_OF_PYRAMID_VERTEXES)
+    return;
+
+  // Tolerance is half a pixel at zoom level 0
+  const QcTiledZoomLevel & tiled_zoom_level = m_viewport->tiled_zoom_level();
+  double coarsest_tolerance = .5 * tiled_zoom_level.map_size() / tiled_zoom_level.tile_size();
+  auto * builder = new QcPathPyramidBuilder(*m_path, coarsest_tolerance, NUMBER_OF_PYRAMID_LEVELS);
+  m_path_pyramid_builder = builder;
+  connect(builder, &QcPathPyramidBuilder::finished, builder, &QObject::deleteLater);
+  connect(builder, &QcPathPyramidBuilder::finished, this, [this, builder]() {
+      m_path_pyramid_builder = nullptr;
+      if (m_outdated_path_pyramid) {
+        update_path_pyramid();
+        return;
+      }
+      m_path_pyramid = builder->pyramid();
+      m_dirty_path = true;
+      emit scene_graph_changed();
+    });
+  QThreadPool::globalInstance()->start(builder);
+}
+
+/* The fill of a closed path is triangulated once per edit, the node then reuses the index buffer
+ * whatever the viewport.
+ */
+void
+QcMapScene::update_polygon_triangulation()
+{
+  if (m_polygon_triangulation_builder) {
+    m_outdated_polygon_triangulation = true;
+    return;
+  }
+  m_outdated_polygon_triangulation = false;
+
+  if (!m_path or !m_path->closed() or m_path->number_of_vertexes() < 3 or
+      m_path->number_of_vertexes() > QcPolygonTriangulation::MAXIMUM_NUMBER_OF_VERTEXES)
+    return;
+
+  auto * builder = new QcPolygonTriangulationBuilder(*m_path);
+  m_polygon_triangulation_builder = builder;
+  connect(builder, &QcPolygonTriangulationBuilder::finished, builder, &QObject::deleteLater);
+  connect(builder, &QcPolygonTriangulationBuilder::finished, this, [this, builder]() {
+      m_polygon_triangulation_builder = nullptr;
+      if (m_outdated_polygon_triangulation) {
+        update_polygon_triangulation();
+        return;
+      }
+      m_polygon_triangulation = builder->triangulation();
+      m_dirty_polygon = true;
+      emit scene_graph_changed();
+    });
+  QThreadPool::globalInstance()->start(builder);
 }
 
 void
@@ -100,11 +230,20 @@ QcMapScene::set_location_circle_data_dirty()
   m_dirty_location_circle = true;
 }
 
+void
+QcMapScene::set_overlay_dirty()
+{
+  m_dirty_overlay = true;
+  emit scene_graph_changed();
+}
+
 QSGNode *
 QcMapScene::update_scene_graph(QSGNode * old_node, QQuickWindow * window)
 {
   // qInfo() << old_node;
 
+  QcStageTimer frame_timer(m_frame_statistics, QcFrameStatistics::Frame);
+
   // QSize viewport_size = m_viewport->viewport_size();
   float width = m_viewport->width();
   float height = m_viewport->height();
@@ -115,10 +254,15 @@ QcMapScene::update_scene_graph(QSGNode * old_node, QQuickWindow * window)
     return nullptr;
   }
 
+  // A frame can be requested by a tile, the path and overlay nodes are then left as is
+  QcViewport::ChangeFlags viewport_changes = m_viewport_changes;
+  m_viewport_changes = QcViewport::NoChange;
+
   QcMapRootNode * map_root_node = static_cast<QcMapRootNode *>(old_node);
   if (!map_root_node) {
     // qInfo() << "map_root_node is null";
     map_root_node = new QcMapRootNode(m_viewport);
+    viewport_changes = QcViewport::AllChanges;
   }
 
   // Fixme: ok ?
@@ -139,23 +283,53 @@ QcMapScene::update_scene_graph(QSGNode * old_node, QQuickWindow * window)
     map_root_node->root->removeChildNode(node);
   m_scene_graph_nodes_to_remove.clear();
 
+  m_pending_uploads = false;
   for (auto * layer : m_layers) {
-    QcMapLayerRootNode * layer_node = nullptr;
-    QString name = layer->name();
-    if (map_root_node->layers.contains(name))
-      layer_node = map_root_node->layers[name];
-    else {
+    const QString & name = layer->name();
+    QcMapLayerRootNode * layer_node = map_root_node->layers.value(name, nullptr);
+    if (!layer_node) {
       layer_node = layer->make_node();
       map_root_node->layers.insert(name, layer_node);
       map_root_node->root->insertChildNodeBefore(layer_node, map_root_node->location_circle_node);
     }
-    layer->update_scene_graph(layer_node, window);
+    if (layer->update_scene_graph(layer_node, window))
+      m_pending_uploads = true;
   }
 
-  if (m_dirty_path) {
-    // Fixme: m_path is null
-    map_root_node->path_node->update(m_path);
-    m_dirty_path = false;
+  {
+    QcStageTimer path_timer(m_frame_statistics, QcFrameStatistics::PathUpdate);
+    bool path_changed = m_dirty_path or m_dirty_polygon;
+    // Draw the pyramid level having a tolerance lower than half a pixel, it only depends on the zoom
+    if (m_dirty_path or viewport_changes.testFlag(QcViewport::ZoomChange)) {
+      int path_level = -1;
+      if (m_path_pyramid)
+        path_level = m_path_pyramid->level_for_tolerance(.5 * m_viewport->resolution());
+      if (m_dirty_path or path_level != m_path_level) {
+        // Fixme: m_path is null
+        const QVector<int> * indexes = path_level >= 0 ? &m_path_pyramid->level(path_level) : nullptr;
+        map_root_node->path_node->update(m_path, indexes);
+        m_path_level = path_level;
+        m_dirty_path = false;
+        path_changed = true;
+      }
+    }
+    if (m_dirty_polygon) {
+      map_root_node->path_node->update_polygon(m_polygon_triangulation.data());
+      m_dirty_polygon = false;
+    }
+    if (path_changed or viewport_changes)
+      map_root_node->path_node->update_viewport();
+  }
+
+  {
+    QcStageTimer overlay_timer(m_frame_statistics, QcFrameStatistics::OverlayUpdate);
+    bool overlay_changed = m_dirty_overlay;
+    if (m_dirty_overlay) {
+      map_root_node->overlay_node->update(m_overlay_layer);
+      m_dirty_overlay = false;
+    }
+    if (overlay_changed or viewport_changes)
+      map_root_node->overlay_node->update_viewport();
   }
 
   if (m_dirty_location_circle) {
@@ -176,6 +350,7 @@ QcMapRootNode::QcMapRootNode(const QcViewport * viewport)
     geometry(QSGGeometry::defaultAttributes_Point2D(), 4),
     root(new QSGTransformNode()),
     location_circle_node(new QcLocationCircleNode(viewport)),
+    overlay_node(new QcOverlayNode(viewport)),
     path_node(new QcPathNode(viewport))
 {
   // qInfo();
@@ -184,6 +359,7 @@ QcMapRootNode::QcMapRootNode(const QcViewport * viewport)
   appendChildNode(root);
 
   root->appendChildNode(location_circle_node);
+  root->appendChildNode(overlay_node);
   root->appendChildNode(path_node);
 }
 
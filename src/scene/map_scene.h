@@ -34,9 +34,14 @@
 /**************************************************************************************************/
 
 #include "cache/file_tile_cache.h"
+#include "geometry/path.h"
+#include "geometry/path_pyramid.h"
 #include "map/decorated_path.h"
 #include "map/location_circle_data.h"
+#include "map/overlay_layer.h"
 #include "map/viewport.h"
+#include "tools/frame_statistics.h"
+#include "wmts/tile_bit_set.h"
 #include "wmts/tile_matrix_set.h"
 #include "wmts/tile_spec.h"
 #include "wmts/wmts_plugin.h"
@@ -44,6 +49,7 @@
 #include <QHash>
 #include <QObject>
 #include <QQuickWindow>
+#include <QRunnable>
 #include <QSGNode>
 #include <QString>
 
@@ -63,6 +69,8 @@
 
 class QcMapLayerRootNode;
 
+typedef QList<QSharedPointer<QcTileTexture> > QcTileTextureList;
+
 /**************************************************************************************************/
 
 class QcMapLayerScene : public QObject
@@ -70,11 +78,13 @@ class QcMapLayerScene : public QObject
   Q_OBJECT
 
 public:
-  QcMapLayerScene(const QcWmtsPluginLayer * plugin_layer, const QcViewport * viewport, QObject * parent = nullptr);
+  QcMapLayerScene(const QcWmtsPluginLayer * plugin_layer, const QcViewport * viewport,
+                  QcFrameStatistics * frame_statistics = nullptr, QObject * parent = nullptr);
   ~QcMapLayerScene();
 
-  QString name() const { return m_plugin_layer->hash_name(); }
+  const QString & name() const { return m_name; }
   const QcWmtsPluginLayer * plugin_layer() const { return m_plugin_layer; }
+  QcFrameStatistics * frame_statistics() const { return m_frame_statistics; }
 
   float width() { return m_viewport->width(); }
   float height() { return m_viewport->height(); }
@@ -84,37 +94,61 @@ public:
 
   void add_tile(const QcTileSpec & tile_spec, QSharedPointer<QcTileTexture> texture);
 
-  void set_visible_tiles(const QcTileSpecSet & tile_specs,
-                         const QcTileSpecSet & west_tile_specs,
-                         const QcTileSpecSet & central_tile_specs,
-                         const QcTileSpecSet & east_tile_specs);
-  const QcTileSpecSet & visible_tiles() const { return m_visible_tiles; };
-  QcTileSpecSet textured_tiles() const;
+  // Textures of an ancestor or of children drawn in place of a tile in flight
+  void add_fallback_tile(const QcTileSpec & tile_spec, const QcTileTextureList & textures);
+  bool has_fallback(const QcTileSpec & tile_spec) const { return m_fallback_textures.contains(tile_spec); }
+
+  void set_visible_tiles(const QcTileBitSet & tiles,
+                         const QcTileBitSet & west_tiles,
+                         const QcTileBitSet & central_tiles,
+                         const QcTileBitSet & east_tiles);
+  // Apply the tiles entering and leaving the viewport
+  void update_visible_tiles(const QcTileSpecSetDiff & tiles_diff,
+                            const QcTileBitSet & tiles,
+                            const QcTileBitSet & west_tiles,
+                            const QcTileBitSet & central_tiles,
+                            const QcTileBitSet & east_tiles);
+  const QcTileBitSet & visible_tiles() const { return m_visible_tiles; };
+  bool has_texture(const QcTileSpec & tile_spec) const { return m_tile_textures.contains(tile_spec); }
 
   QcMapLayerRootNode * make_node();
-  void update_scene_graph(QcMapLayerRootNode * map_root_node, QQuickWindow * window);
+  bool update_scene_graph(QcMapLayerRootNode * map_root_node, QQuickWindow * window);
   QcPolygon transform_polygon(const QcPolygon & polygon) const;
-  bool build_geometry(const QcTileSpec & tile_spec, QSGGeometry::TexturedPoint2D * vertices, const QcPolygon & polygon);
+  // Vertexes are given in the pixel space of the viewport level relatively to an origin
+  bool build_geometry(const QcTileSpec & tile_spec, QSGGeometry::TexturedPoint2D * vertices, const QcVectorDouble & origin);
+  bool build_geometry(const QcTileSpec & tile_spec, const QcTileSpec & source_tile_spec,
+                      QSGGeometry::TexturedPoint2D * vertices, const QcVectorDouble & origin);
+  // True if the tiles, their textures or the atlas changed since the last scene graph update
+  bool is_dirty_geometry() const { return m_dirty_geometry; }
 
   // Fixme: protected
   QcMapLayerRootNode * scene_graph_node() { return m_scene_graph_node; }
 
 private:
+  void assign_visible_tiles(const QcTileBitSet & tiles,
+                            const QcTileBitSet & west_tiles,
+                            const QcTileBitSet & central_tiles,
+                            const QcTileBitSet & east_tiles);
   void remove_tiles(const QcTileSpecSet & old_tiles);
+  void remove_hidden_tiles();
 
 public:
   QHash<QcTileSpec, QSharedPointer<QcTileTexture> > m_tile_textures;
+  QHash<QcTileSpec, QcTileTextureList> m_fallback_textures;
 
 private:
   const QcWmtsPluginLayer * m_plugin_layer;
   const QcViewport * m_viewport; // Fixme: &
+  QcFrameStatistics * m_frame_statistics;
+  QString m_name; // hash name is looked up at each frame
 
   const QcTileMatrixSet & m_tile_matrix_set;
 
-  QcTileSpecSet m_visible_tiles;
-  QcTileSpecSet m_west_visible_tiles;
-  QcTileSpecSet m_central_visible_tiles;
-  QcTileSpecSet m_east_visible_tiles;
+  QcTileBitSet m_visible_tiles;
+  QcTileBitSet m_west_visible_tiles;
+  QcTileBitSet m_central_visible_tiles;
+  QcTileBitSet m_east_visible_tiles;
+  bool m_dirty_geometry;
 
   float m_opacity;
 
@@ -123,17 +157,79 @@ private:
 
 /**************************************************************************************************/
 
+/*! Build the simplification pyramid of a path in the thread pool.
+ *
+ * The vertexes are copied, thus the path can be modified in the meantime.
+ */
+class QcPathPyramidBuilder : public QObject, public QRunnable
+{
+  Q_OBJECT
+
+public:
+  QcPathPyramidBuilder(const QcPathDouble & path, double coarsest_tolerance, int number_of_levels);
+
+  void run() override;
+
+  QSharedPointer<QcPathPyramid> pyramid() const { return m_pyramid; }
+
+signals:
+  void finished();
+
+private:
+  QcPathDouble m_path;
+  double m_coarsest_tolerance;
+  int m_number_of_levels;
+  QSharedPointer<QcPathPyramid> m_pyramid;
+};
+
+/**************************************************************************************************/
+
+/*! Triangulate the fill of a closed path in the thread pool.
+ *
+ * The vertexes are copied, thus the path can be modified in the meantime.
+ */
+class QcPolygonTriangulationBuilder : public QObject, public QRunnable
+{
+  Q_OBJECT
+
+public:
+  QcPolygonTriangulationBuilder(const QcPathDouble & path);
+
+  void run() override;
+
+  QSharedPointer<QcPolygonTriangulation> triangulation() const { return m_triangulation; }
+
+signals:
+  void finished();
+
+private:
+  QcPathDouble m_path;
+  QSharedPointer<QcPolygonTriangulation> m_triangulation;
+};
+
+/**************************************************************************************************/
+
 class QcMapScene : public QObject
 {
   Q_OBJECT
 
+public:
+  // Paths having less vertexes are drawn as is
+  static constexpr int MINIMUM_NUMBER_OF_PYRAMID_VERTEXES = 1000;
+  // One level per zoom level
+  static constexpr int NUMBER_OF_PYRAMID_LEVELS = 21;
+
 public:
   QcMapScene(const QcViewport * viewport,
              const QcLocationCircleData & location_circle_data,
+             const QcOverlayLayer & overlay_layer,
+             QcFrameStatistics * frame_statistics = nullptr,
              QObject * parent = nullptr);
   ~QcMapScene();
 
   QSGNode * update_scene_graph(QSGNode * old_node, QQuickWindow * window);
+  // Textures are uploaded within a budget per frame, thus a scene can require several frames
+  bool has_pending_uploads() const { return m_pending_uploads; }
 
   QcMapLayerScene * add_layer(const QcWmtsPluginLayer * plugin_layer);
   void remove_layer(const QcWmtsPluginLayer * plugin_layer);
@@ -141,24 +237,48 @@ public:
   void update_path(const QcDecoratedPathDouble * path);
   void set_dirty_path(); // Fixme: name
 
+  // Accumulate the viewport changes up to the next scene graph update
+  void add_viewport_changes(QcViewport::ChangeFlags changes) { m_viewport_changes |= changes; }
+
+signals:
+  void scene_graph_changed();
+
 private:
   float width() { return m_viewport->width(); }
   float height() { return m_viewport->height(); }
+  void update_path_pyramid();
+  void update_polygon_triangulation();
 
 private slots:
   void set_location_circle_data_dirty();
+  void set_overlay_dirty();
 
 private:
   const QcViewport * m_viewport; // Fixme: &
+  QcFrameStatistics * m_frame_statistics;
   QList<QcMapLayerScene *> m_layers;
   QHash<QString, QcMapLayerScene *> m_layer_map;
   QList<QSGNode *> m_scene_graph_nodes_to_remove;
+  QcViewport::ChangeFlags m_viewport_changes; // since the last scene graph update
 
   const QcDecoratedPathDouble * m_path;
   bool m_dirty_path;
+  QcPathPyramidBuilder * m_path_pyramid_builder; // running build
+  bool m_outdated_path_pyramid; // the path was edited during the build
+  QSharedPointer<QcPathPyramid> m_path_pyramid;
+  int m_path_level; // pyramid level drawn by the path node, -1 for the path
+  QcPolygonTriangulationBuilder * m_polygon_triangulation_builder; // running build
+  bool m_outdated_polygon_triangulation;
+  QSharedPointer<QcPolygonTriangulation> m_polygon_triangulation;
+  bool m_dirty_polygon;
 
   const QcLocationCircleData & m_location_circle_data;
   bool m_dirty_location_circle;
+
+  const QcOverlayLayer & m_overlay_layer;
+  bool m_dirty_overlay;
+
+  bool m_pending_uploads;
 };
 
 /**************************************************************************************************/
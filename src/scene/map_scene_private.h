@@ -34,7 +34,9 @@
 /**************************************************************************************************/
 
 #include "location_circle_node.h"
+#include "overlay_node.h"
 #include "path_node.h"
+#include "tile_atlas.h"
 
 /**************************************************************************************************/
 
@@ -42,12 +44,36 @@
 
 /**************************************************************************************************/
 
+typedef QVector<QSGGeometry::TexturedPoint2D> QcTileQuadList;
+
+/* The tile geometry is expressed in the pixel space of the level, relatively to an origin which
+ * keeps the float coordinates small.  A pan only changes the matrix of the node, the geometry is
+ * rebuilt when the level changes or when the tiles change.
+ */
 class QcMapSideNode : public QSGTransformNode
 {
 public:
-  void add_child(const QcTileSpec & tile_spec, QSGSimpleTextureNode * node);
+  // Origin is moved when it is farther than this distance from the viewport part [px]
+  static constexpr double MAXIMUM_ORIGIN_DISTANCE = 1 << 16;
 
-  QHash<QcTileSpec, QSGSimpleTextureNode *> texture_nodes;
+public:
+  QcMapSideNode() : level(-1), dirty_geometry(false) {}
+
+  // Update the level and the origin, return true if the geometry must be rebuilt
+  bool update_origin(int level, const QcVectorDouble & position);
+
+  // The tiles of a page are drawn by a single geometry node, a world-wrap clone reuses the
+  // geometry of the central node
+  QSGGeometryNode * page_node(QcTileAtlasPage * page, QSGGeometry * shared_geometry = nullptr);
+  void update_page_node(QcTileAtlasPage * page, const QcTileQuadList & quads);
+  void remove_page_node(QcTileAtlasPage * page);
+  // Reference the page geometries of the source node
+  void share_pages(const QcMapSideNode * source);
+
+  QHash<QcTileAtlasPage *, QSGGeometryNode *> page_nodes;
+  int level;
+  QcVectorDouble origin; // [px]
+  bool dirty_geometry; // set if a geometry was changed during the last update
 };
 
 /**************************************************************************************************/
@@ -60,12 +86,23 @@ public:
 
   void update_central_maps();
   void update_tiles(QcMapLayerScene * map_scene,
-                    QcMapSideNode * map_side_node, const QcTileSpecSet & visible_tiles, const QcPolygon & polygon,
+                    QcMapSideNode * map_side_node, const QcTileBitSet & visible_tiles, const QcPolygon & polygon,
                     const QcViewportPart & part);
+  // A clone only differs from the central node by its matrix
+  void update_clone(QcMapSideNode * clone, const QcPolygon & polygon, const QcViewportPart & part);
+  // Remove the page nodes of the pages released by the atlas, then delete these pages
+  void remove_released_pages();
+
+private:
+  QcVectorDouble part_position(const QcPolygon & polygon) const;
+  void update_matrix(QcMapSideNode * map_side_node, const QcVectorDouble & position, const QcViewportPart & part);
+  void add_fallback_tiles(QcMapLayerScene * map_scene, const QcTileBitSet & visible_tiles, const QcVectorDouble & origin);
+  void add_quad(const QcTileAtlasSlot * slot, QSGGeometry::TexturedPoint2D * vertexes);
 
 private:
   const QcTileMatrixSet & m_tile_matrix_set;
   const QcViewport * m_viewport;
+  QHash<QcTileAtlasPage *, QcTileQuadList> m_page_quads; // reused from one part to the next
 
 public:
   // QcGridNode * grid_node;
@@ -73,7 +110,7 @@ public:
   QcMapSideNode * central_map_node;
   QcMapSideNode * east_map_node;
   QList<QcMapSideNode *> central_map_nodes;
-  QHash<QcTileSpec, QSGTexture *> textures;
+  QcTileAtlas * atlas;
 };
 
 /**************************************************************************************************/
@@ -94,6 +131,7 @@ public:
   QSGGeometry geometry;
   QSGTransformNode * root;
   QcLocationCircleNode * location_circle_node;
+  QcOverlayNode * overlay_node;
   QcPathNode * path_node;
   QHash<QString, QcMapLayerRootNode *> layers;
 };
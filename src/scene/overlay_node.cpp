@@ -0,0 +1,207 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include "overlay_node.h"
+#include "overlay_path_material_shader.h"
+#include "path_node.h"
+#include "point_material_shader.h"
+
+#include <cstring>
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+QSGGeometry::Attribute OverlayPathVertex_Attributes[] = {
+  QSGGeometry::Attribute::create(0, 2, GL_FLOAT, true),          // xy
+  QSGGeometry::Attribute::create(1, 2, GL_SHORT, false),         // offset
+  QSGGeometry::Attribute::create(2, 4, GL_UNSIGNED_BYTE, false), // colour
+  QSGGeometry::Attribute::create(3, 2, GL_SHORT, false)          // v half_width
+};
+
+QSGGeometry::AttributeSet OverlayPathVertex_AttributeSet = {
+  4, // count
+  sizeof(QcOverlayPathVertex), // stride
+  OverlayPathVertex_Attributes
+};
+
+QSGGeometry::Attribute OverlayMarkerVertex_Attributes[] = {
+  QSGGeometry::Attribute::create(0, 2, GL_FLOAT, true),          // xy
+  QSGGeometry::Attribute::create(1, 4, GL_UNSIGNED_BYTE, false), // colour
+  QSGGeometry::Attribute::create(2, 2, GL_UNSIGNED_BYTE, false)  // radius size
+};
+
+QSGGeometry::AttributeSet OverlayMarkerVertex_AttributeSet = {
+  3, // count
+  sizeof(QcOverlayMarkerVertex), // stride
+  OverlayMarkerVertex_Attributes
+};
+
+/**************************************************************************************************/
+
+QcOverlayNode::QcOverlayNode(const QcViewport * viewport)
+  : QSGNode(),
+    m_viewport(viewport)
+{}
+
+QSGGeometryNode *
+QcOverlayNode::make_path_node()
+{
+  QSGGeometryNode * node = new QSGGeometryNode();
+
+  QSGGeometry * geometry = new QSGGeometry(OverlayPathVertex_AttributeSet, 0, 0, GL_UNSIGNED_SHORT);
+  geometry->setDrawingMode(GL_TRIANGLES);
+  node->setGeometry(geometry);
+  node->setFlag(QSGNode::OwnsGeometry);
+
+  QSGSimpleMaterial<QcOverlayPathMaterialShaderState> * material = QcOverlayPathMaterialShader::createMaterial();
+  material->setFlag(QSGMaterial::Blending);
+  node->setMaterial(material);
+  node->setFlag(QSGNode::OwnsMaterial);
+
+  appendChildNode(node);
+  return node;
+}
+
+QSGGeometryNode *
+QcOverlayNode::make_marker_node()
+{
+  QSGGeometryNode * node = new QSGGeometryNode();
+
+  QSGGeometry * geometry = new QSGGeometry(OverlayMarkerVertex_AttributeSet, 0);
+  geometry->setDrawingMode(GL_POINTS);
+  node->setGeometry(geometry);
+  node->setFlag(QSGNode::OwnsGeometry);
+
+  QSGSimpleMaterial<QcPointMaterialShaderState> * material = QcPointMaterialShader::createMaterial();
+  material->setFlag(QSGMaterial::Blending);
+  node->setMaterial(material);
+  node->setFlag(QSGNode::OwnsMaterial);
+
+  appendChildNode(node);
+  return node;
+}
+
+//! Copy the chunks changed since the last update
+void
+QcOverlayNode::update(const QcOverlayLayer & layer)
+{
+  const QVector<QcOverlayPathChunk> & path_chunks = layer.path_chunks();
+  int number_of_path_chunks = path_chunks.size();
+  while (m_path_nodes.size() > number_of_path_chunks) {
+    QSGGeometryNode * node = m_path_nodes.takeLast();
+    removeChildNode(node);
+    delete node;
+  }
+  m_path_revisions.resize(number_of_path_chunks);
+  m_path_origins.resize(number_of_path_chunks);
+  for (int i = 0; i < number_of_path_chunks; i++) {
+    const QcOverlayPathChunk & chunk = path_chunks[i];
+    if (i == m_path_nodes.size()) {
+      m_path_nodes << make_path_node();
+      m_path_revisions[i] = -1;
+    }
+    if (m_path_revisions[i] == chunk.revision)
+      continue;
+    QSGGeometryNode * node = m_path_nodes[i];
+    QSGGeometry * geometry = node->geometry();
+    geometry->allocate(chunk.vertexes.size(), chunk.indexes.size());
+    std::memcpy(geometry->vertexData(), chunk.vertexes.constData(),
+                chunk.vertexes.size() * sizeof(QcOverlayPathVertex));
+    std::memcpy(geometry->indexDataAsUShort(), chunk.indexes.constData(),
+                chunk.indexes.size() * sizeof(quint16));
+    node->markDirty(QSGNode::DirtyGeometry);
+    m_path_revisions[i] = chunk.revision;
+    m_path_origins[i] = chunk.origin;
+  }
+
+  const QVector<QcOverlayMarkerChunk> & marker_chunks = layer.marker_chunks();
+  int number_of_marker_chunks = marker_chunks.size();
+  while (m_marker_nodes.size() > number_of_marker_chunks) {
+    QSGGeometryNode * node = m_marker_nodes.takeLast();
+    removeChildNode(node);
+    delete node;
+  }
+  m_marker_revisions.resize(number_of_marker_chunks);
+  m_marker_origins.resize(number_of_marker_chunks);
+  for (int i = 0; i < number_of_marker_chunks; i++) {
+    const QcOverlayMarkerChunk & chunk = marker_chunks[i];
+    if (i == m_marker_nodes.size()) {
+      m_marker_nodes << make_marker_node();
+      m_marker_revisions[i] = -1;
+    }
+    if (m_marker_revisions[i] == chunk.revision)
+      continue;
+    QSGGeometryNode * node = m_marker_nodes[i];
+    QSGGeometry * geometry = node->geometry();
+    geometry->allocate(chunk.vertexes.size());
+    std::memcpy(geometry->vertexData(), chunk.vertexes.constData(),
+                chunk.vertexes.size() * sizeof(QcOverlayMarkerVertex));
+    node->markDirty(QSGNode::DirtyGeometry);
+    m_marker_revisions[i] = chunk.revision;
+    m_marker_origins[i] = chunk.origin;
+  }
+}
+
+//! Update the matrix of the materials
+void
+QcOverlayNode::update_viewport()
+{
+  for (int i = 0; i < m_path_nodes.size(); i++) {
+    QSGGeometryNode * node = m_path_nodes[i];
+    auto * state = static_cast<QSGSimpleMaterial<QcOverlayPathMaterialShaderState> *>(node->material())->state();
+    QMatrix4x4 map_matrix = QcPathNode::map_matrix(m_viewport, m_path_origins[i]);
+    if (state->map_matrix != map_matrix) {
+      state->map_matrix = map_matrix;
+      node->markDirty(QSGNode::DirtyMaterial);
+    }
+  }
+
+  for (int i = 0; i < m_marker_nodes.size(); i++) {
+    QSGGeometryNode * node = m_marker_nodes[i];
+    auto * state = static_cast<QSGSimpleMaterial<QcPointMaterialShaderState> *>(node->material())->state();
+    QMatrix4x4 map_matrix = QcPathNode::map_matrix(m_viewport, m_marker_origins[i]);
+    if (state->map_matrix != map_matrix) {
+      state->map_matrix = map_matrix;
+      node->markDirty(QSGNode::DirtyMaterial);
+    }
+  }
+}
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -0,0 +1,91 @@
+// -*- mode: c++ -*-
+
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#ifndef __OVERLAY_NODE_H__
+#define __OVERLAY_NODE_H__
+
+/**************************************************************************************************/
+
+#include "map/overlay_layer.h"
+#include "map/viewport.h"
+
+#include <QSGGeometryNode>
+#include <QSGNode>
+#include <QVector>
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+/*! Scene graph of an overlay layer.
+ *
+ * Each chunk of the layer is drawn by a geometry node, thus by one draw call.  The vertexes of a
+ * chunk are only copied when its revision changed, a viewport change only updates the matrix of
+ * the materials.
+ */
+class QcOverlayNode : public QSGNode
+{
+public:
+  QcOverlayNode(const QcViewport * viewport);
+
+  void update(const QcOverlayLayer & layer);
+  // Must be called when the viewport changed
+  void update_viewport();
+
+private:
+  QSGGeometryNode * make_path_node();
+  QSGGeometryNode * make_marker_node();
+
+private:
+  const QcViewport * m_viewport; // Fixme: &
+  QVector<QSGGeometryNode *> m_path_nodes;
+  QVector<QSGGeometryNode *> m_marker_nodes;
+  QVector<int> m_path_revisions;
+  QVector<int> m_marker_revisions;
+  QVector<QcVectorDouble> m_path_origins;
+  QVector<QcVectorDouble> m_marker_origins;
+};
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/**************************************************************************************************/
+
+#endif /* __OVERLAY_NODE_H__ */
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
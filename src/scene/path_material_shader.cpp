@@ -53,18 +53,20 @@ QcPathMaterialShader::attributes() const
 {
   return QList<QByteArray>()
     << "a_vertex"
+    << "a_offset"
     << "a_tex_coord"
     << "a_line_length"
-    << "a_line_width"
-    << "a_cap"
-    << "a_colour";
+    << "a_cap";
 }
 
 void
 QcPathMaterialShader::updateState(const QcPathMaterialShaderState * state,
                                   const QcPathMaterialShaderState *)
 {
-  // program()->setUniformValue("colour", state->r, state->g, state->b, state->a);
+  program()->setUniformValue("map_matrix", state->map_matrix);
+  program()->setUniformValue("scale", state->scale);
+  program()->setUniformValue("line_width", state->line_width);
+  program()->setUniformValue("colour", state->colour);
   // program()->setUniformValue("cap_type", state->cap_type);
   // program()->setUniformValue("line_join", state->line_join);
   // program()->setUniformValue("antialias_diameter", state->antialias_diameter);
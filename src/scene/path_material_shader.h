@@ -33,6 +33,8 @@
 
 /**************************************************************************************************/
 
+#include <QColor>
+#include <QMatrix4x4>
 #include <QSGSimpleMaterialShader>
 
 /**************************************************************************************************/
@@ -43,7 +45,10 @@
 
 struct QcPathMaterialShaderState
 {
-  // float r, g, b, a;
+  QMatrix4x4 map_matrix; // from the path referential to the item
+  float scale = 1; // [px/m]
+  float line_width = 1; // [px]
+  QColor colour;
   // int cap_type;
   // int line_join;
   // float antialias_diameter;
@@ -33,100 +33,115 @@
 #include <QSGFlatColorMaterial>
 #include <QtDebug>
 
+#include <algorithm>
+#include <cmath>
+
 /**************************************************************************************************/
 
 // QC_BEGIN_NAMESPACE
 
 /**************************************************************************************************/
 
+/* Pixel quantities are stored as fixed point numbers in 1/16 px, thus within ±2048 px.  The
+ * scene graph normalises the integer attributes, the shaders scale them back.
+ */
+constexpr double PIXEL_UNIT = 16;
+
+static inline qint16
+to_fixed_point(double x)
+{
+  return qint16(qBound(-32767., std::round(x * PIXEL_UNIT), 32767.));
+}
+
+/* The position is given in the projected coordinate system relatively to the path origin, y axis
+ * pointing down, whereas the extrusion offset is in pixel.  The abscissa along the segment is the
+ * segment length in metre at the end of the segment, plus a pixel part, the shader combines them
+ * using the current scale.  The colour and the line width are uniforms of the material.
+ */
 struct PathPoint2D {
   float x;
   float y;
-  float u;
-  float v;
+  qint16 offset_x;
+  qint16 offset_y;
+  qint16 u_px;
+  qint16 v;
   float line_length;
-  float line_width;
-  float cap;
-  float r;
-  float g;
-  float b;
-  float a;
+  quint8 cap; // cap + 1
+  quint8 end; // 1 at the end of the segment
+  quint8 padding[2];
 
   void set(const QcVectorDouble & point,
-           const QcVectorDouble & uv,
+           const QcVectorDouble & offset,
+           bool _end,
+           float _u_px,
+           float _v,
            float _line_length,
-           float _line_width,
-           float _cap,
-           const QColor & colour
+           int _cap
            ) {
     x = point.x();
     y = point.y();
-    u = uv.x();
-    v = uv.y();
+    offset_x = to_fixed_point(offset.x());
+    offset_y = to_fixed_point(offset.y());
+    u_px = to_fixed_point(_u_px);
+    v = to_fixed_point(_v);
     line_length = _line_length;
-    line_width = _line_width;
-    cap = _cap;
-    r = colour.redF();
-    g = colour.greenF();
-    b = colour.blueF();
-    a = colour.alphaF();
+    cap = _cap + 1;
+    end = _end;
   }
 };
 
 QSGGeometry::Attribute PathPoint2D_Attributes[] = {
-  QSGGeometry::Attribute::create(0, 2, GL_FLOAT, true),  // xy
-  QSGGeometry::Attribute::create(1, 2, GL_FLOAT, false), // uv
-  QSGGeometry::Attribute::create(2, 1, GL_FLOAT, false), // line_length
-  QSGGeometry::Attribute::create(3, 1, GL_FLOAT, false), // line_width
-  QSGGeometry::Attribute::create(4, 1, GL_FLOAT, false), // cap
-  QSGGeometry::Attribute::create(5, 4, GL_FLOAT, false)  // colour
+  QSGGeometry::Attribute::create(0, 2, GL_FLOAT, true),         // xy
+  QSGGeometry::Attribute::create(1, 2, GL_SHORT, false),        // offset
+  QSGGeometry::Attribute::create(2, 2, GL_SHORT, false),        // u_px v
+  QSGGeometry::Attribute::create(3, 1, GL_FLOAT, false),        // line_length
+  QSGGeometry::Attribute::create(4, 2, GL_UNSIGNED_BYTE, false) // cap end
 };
 
 QSGGeometry::AttributeSet PathPoint2D_AttributeSet = {
-    6, // count Fixme: ???
+    5, // count Fixme: ???
     sizeof(PathPoint2D), // stride
     PathPoint2D_Attributes
 };
 
 /**************************************************************************************************/
 
+// A point marker is drawn as a point sprite
 struct CirclePoint2D {
   float x;
   float y;
-  float u;
-  float v;
-  float radius;
-  float r;
-  float g;
-  float b;
-  float a;
+  quint8 r;
+  quint8 g;
+  quint8 b;
+  quint8 a;
+  quint8 radius; // [px]
+  quint8 size; // half size of the sprite [px]
+  quint8 padding[2];
 
   void set(const QcVectorDouble & point,
-           const QcVectorDouble & uv,
            float _radius,
+           float _size,
            const QColor & colour
            ) {
     x = point.x();
     y = point.y();
-    u = uv.x();
-    v = uv.y();
-    radius = _radius;
     r = colour.red();
     g = colour.green();
     b = colour.blue();
     a = colour.alpha();
+    radius = qBound(0, qRound(_radius), 255);
+    size = qBound(0, qRound(_size), 255);
   }
 };
 
 QSGGeometry::Attribute CirclePoint2D_Attributes[] = {
-  QSGGeometry::Attribute::create(0, 2, GL_FLOAT, true),  // xy
-  QSGGeometry::Attribute::create(1, 2, GL_FLOAT, false), // uv
-  QSGGeometry::Attribute::create(2, 1, GL_FLOAT, false), // radius
-  QSGGeometry::Attribute::create(3, 4, GL_FLOAT, false)  // colour
+  QSGGeometry::Attribute::create(0, 2, GL_FLOAT, true),          // xy
+  QSGGeometry::Attribute::create(1, 4, GL_UNSIGNED_BYTE, false), // colour
+  QSGGeometry::Attribute::create(2, 2, GL_UNSIGNED_BYTE, false)  // radius size
 };
 
 QSGGeometry::AttributeSet CirclePoint2D_AttributeSet = {
-  4, // count Fixme: ???
+  3, // count Fixme: ???
   sizeof(CirclePoint2D), // stride
   CirclePoint2D_Attributes
 };
@@ -165,8 +180,11 @@ QcPathNode::QcPathNode(const QcViewport * viewport)
   : QSGOpacityNode(),
     m_viewport(viewport),
     m_path_geometry_node(new QSGGeometryNode()),
+    m_polygon_transform_node(new QSGTransformNode()),
     m_polygon_geometry_node(new QSGGeometryNode()),
-    m_point_geometry_node(new QSGGeometryNode())
+    m_point_geometry_node(new QSGGeometryNode()),
+    m_closed(false),
+    m_dirty_geometry(false)
 {
   setOpacity(1.); // 1. black
 
@@ -182,7 +200,9 @@ QcPathNode::QcPathNode(const QcViewport * viewport)
   m_polygon_geometry_node->setMaterial(polygon_material);
   m_polygon_geometry_node->setFlag(QSGNode::OwnsMaterial);
 
-  appendChildNode(m_polygon_geometry_node);
+  // The fill geometry doesn't depend on the viewport
+  m_polygon_transform_node->appendChildNode(m_polygon_geometry_node);
+  appendChildNode(m_polygon_transform_node);
 
   // Path
   QSGGeometry * path_geometry = new QSGGeometry(PathPoint2D_AttributeSet, 0); // Fixme:
@@ -207,7 +227,7 @@ QcPathNode::QcPathNode(const QcViewport * viewport)
 
   // Point
   QSGGeometry * point_geometry = new QSGGeometry(CirclePoint2D_AttributeSet, 0); // Fixme:
-  point_geometry->setDrawingMode(GL_TRIANGLE_STRIP);
+  point_geometry->setDrawingMode(GL_POINTS);
   m_point_geometry_node->setGeometry(point_geometry);
   m_point_geometry_node->setFlag(QSGNode::OwnsGeometry);
 
@@ -227,15 +247,13 @@ QcPathNode::QcPathNode(const QcViewport * viewport)
 
 void
 QcPathNode::set_path_points(PathPoint2D * path_points,
-                            int i,
-                            QcVectorDouble & point0,
-                            QcVectorDouble & point1,
-                            QcVectorDouble & point2,
-                            QcVectorDouble & point3,
-                            double line_width,
-                            double half_width,
-                            const QColor & colour)
+                            const QcVectorDouble & point0,
+                            const QcVectorDouble & point1,
+                            const QcVectorDouble & point2,
+                            const QcVectorDouble & point3,
+                            double half_width)
 {
+  // Points are in metre, but the directions don't depend on the scale
   QcVectorDouble dir1 = point2 - point1;
   double segment_length = dir1.magnitude();
   dir1.normalise();
@@ -243,190 +261,281 @@ QcPathNode::set_path_points(PathPoint2D * path_points,
   QcVectorDouble tangential_offset1 = dir1 * half_width;
   QcVectorDouble normal_offset1 = normal1 * half_width;
 
-  QcVectorDouble vertex;
-  int j = 4*i;
-
-  double cap1 = 0;
+  int cap1 = 0;
   if (point0 == point1) {
     cap1 = -1;
-    point1 -= tangential_offset1;
-
-    vertex = point1 - normal_offset1;
-    // qInfo() << "1   0 == 1" << vertex;
-    // path_points[j].set(vertex.x(), vertex.y());
-    path_points[j].set(vertex, QcVectorDouble(-half_width, -half_width), segment_length, line_width, cap1, colour);
-    vertex = point1 + normal_offset1;
-    // qInfo() << "2   0 == 1" << vertex;
-    path_points[j+1].set(vertex, QcVectorDouble(-half_width, half_width), segment_length, line_width, cap1, colour);
+    path_points[0].set(point1, - tangential_offset1 - normal_offset1,
+                       false, -half_width, -half_width, segment_length, cap1);
+    path_points[1].set(point1, - tangential_offset1 + normal_offset1,
+                       false, -half_width, half_width, segment_length, cap1);
   } else {
     QcVectorDouble dir0 = point1 - point0;
     dir0.normalise();
     double u1;
     QcVectorDouble offset1 = compute_offsets(dir0, dir1, half_width, u1);
     // qInfo() << "offset1" << offset1;
-
-    vertex = point1 - offset1;
-    // qInfo() << "1" << vertex;
-    path_points[j].set(vertex, QcVectorDouble(-u1, -half_width), segment_length, line_width, cap1, colour);
-    vertex = point1 + offset1;
-    // qInfo() << "2" << vertex;
-    path_points[j+1].set(vertex, QcVectorDouble(u1, half_width), segment_length, line_width, cap1, colour);
+    path_points[0].set(point1, - offset1, false, -u1, -half_width, segment_length, cap1);
+    path_points[1].set(point1, offset1, false, u1, half_width, segment_length, cap1);
   }
 
-  double cap2 = 0;
+  int cap2 = 0;
   if (point2 == point3) {
     cap2 = 1;
-    point2 += tangential_offset1;
-    double u = segment_length + half_width;
-
-    vertex = point2 - normal_offset1;
-    // qInfo() << "3   2 == 3" << vertex;
-    path_points[j+2].set(vertex, QcVectorDouble(u, -half_width), segment_length, line_width, cap2, colour);
-    vertex = point2 + normal_offset1;
-    // qInfo() << "4   2 == 3"  << vertex;
-    path_points[j+3].set(vertex, QcVectorDouble(u, half_width), segment_length, line_width, cap2, colour);
+    path_points[2].set(point2, tangential_offset1 - normal_offset1,
+                       true, half_width, -half_width, segment_length, cap2);
+    path_points[3].set(point2, tangential_offset1 + normal_offset1,
+                       true, half_width, half_width, segment_length, cap2);
   } else {
     QcVectorDouble dir2 = point3 - point2;
     dir2.normalise();
     double u2;
     QcVectorDouble offset2 = compute_offsets(dir1, dir2, half_width, u2);
     // qInfo() << "offset2" << offset2;
+    path_points[2].set(point2, - offset2, true, u2, -half_width, segment_length, cap2);
+    path_points[3].set(point2, offset2, true, -u2, half_width, segment_length, cap2);
+  }
+}
 
-    vertex = point2 - offset2;
-    // qInfo() << "3" << vertex;
-    path_points[j+2].set(vertex, QcVectorDouble(segment_length + u2, -half_width), segment_length, line_width, cap2, colour);
-    vertex = point2 + offset2;
-    // qInfo() << "4" << vertex;
-    path_points[j+3].set(vertex, QcVectorDouble(segment_length - u2,  half_width), segment_length, line_width, cap2, colour);
+/*! Set the path to draw.
+ *
+ * If indexes is not null, only these vertexes are drawn, e.g. a level of the path pyramid.  The
+ * geometry is built on the next viewport update.
+ */
+void
+QcPathNode::update(const QcDecoratedPathDouble * path, const QVector<int> * indexes)
+{
+  m_vertexes.resize(0);
+  m_attributes.resize(0);
+  m_closed = false;
+  if (path and path->number_of_vertexes()) {
+    const QcInterval2DDouble & interval = path->interval();
+    m_origin = QcVectorDouble(interval.x().center(), interval.y().center());
+    const QcDecoratedPathDouble::VertexListType & vertexes = path->vertexes();
+    int number_of_vertexes = indexes ? indexes->size() : vertexes.size();
+    m_vertexes.reserve(number_of_vertexes);
+    m_attributes.reserve(number_of_vertexes);
+    for (int i = 0; i < number_of_vertexes; i++) {
+      int index = indexes ? (*indexes)[i] : i;
+      m_vertexes << vertexes[index];
+      m_attributes << path->attribute_at(index);
+    }
+    m_closed = number_of_vertexes >= 3 and path->closed();
   }
+
+  m_segment_index.build(m_vertexes, m_closed);
+  m_dirty_geometry = true;
 }
 
+/*! Set the fill of a closed path, a null or empty triangulation removes it.
+ *
+ * The vertexes and the index buffer are built once in the projected coordinate system, the
+ * viewport only changes the matrix of the transform node.
+ */
 void
-QcPathNode::update(const QcDecoratedPathDouble * path)
+QcPathNode::update_polygon(const QcPolygonTriangulation * triangulation)
 {
-  QList<QcVectorDouble> path_vertexes;
-  // Fixme:
-  if (path)
-    for (const auto & vertex : path->vertexes()) {
-      QcVectorDouble screen_position = m_viewport->coordinate_to_screen(vertex);
-      // qInfo() << vertex << screen_position;
-      path_vertexes << screen_position;
+  QSGGeometry * polygon_geometry = m_polygon_geometry_node->geometry();
+  if (triangulation and !triangulation->is_empty()) {
+    const QcPathDouble & path = triangulation->path();
+    const QcInterval2DDouble & interval = path.interval();
+    m_polygon_origin = QcVectorDouble(interval.x().center(), interval.y().center());
+    QVector<quint16> indexes = triangulation->index_buffer();
+    polygon_geometry->allocate(path.number_of_vertexes(), indexes.size());
+    QSGGeometry::Point2D * points = polygon_geometry->vertexDataAsPoint2D();
+    for (const auto & vertex : path.vertexes()) {
+      QcVectorDouble relative_vertex = (vertex - m_polygon_origin).mirror_y();
+      points++->set(relative_vertex.x(), relative_vertex.y());
     }
-  int number_of_path_vertexes = path_vertexes.size();
-  int number_of_vertexes = 0;
+    std::copy(indexes.cbegin(), indexes.cend(), polygon_geometry->indexDataAsUShort());
+  } else
+    polygon_geometry->allocate(0, 0);
+  m_polygon_geometry_node->markDirty(QSGNode::DirtyGeometry);
 
-  bool path_closed = number_of_path_vertexes >= 3 and path->closed();
+  m_polygon_transform_node->setMatrix(map_matrix(m_viewport, m_polygon_origin));
+}
 
-  const QColor path_colour(0, 0, 255, 255);
-  const QColor selected_colour(255, 0, 0, 255);
+/*! Update the node for the current viewport.
+ *
+ * The geometry covers the visible segments plus a margin of one viewport, thus it is only rebuilt
+ * when the viewport leaves this area.  Otherwise only the transform of the shaders is updated.
+ */
+void
+QcPathNode::update_viewport()
+{
+  double resolution = m_viewport->resolution();
+  double margin = MARKER_MARGIN * resolution;
+  double culling_margin = qMax(m_viewport->width(), m_viewport->height()) * resolution;
+
+  m_visible_intervals.resize(0);
+  for (const QcViewportPart * part : {&m_viewport->west_part(), &m_viewport->central_part(), &m_viewport->east_part()})
+    if (*part) {
+      QcInterval2DDouble interval = part->interval();
+      interval.enlarge(margin);
+      m_visible_intervals << interval;
+    }
 
-  // Polygon
-  /*
-  QSGGeometry * polygon_geometry;
-  if (path_closed) {
-    // QcPolygonTriangulation triangulation = path.triangulate();
-    QcPathDouble screen_path(path_vertexes, path_closed);
-    QcPolygonTriangulation triangulation(screen_path);
-    QList<QcTriangleVertex> triangles = triangulation.triangle_vertexes();
-    number_of_vertexes = triangles.size() * 3;
-
-    polygon_geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), number_of_vertexes);
-    QSGGeometry::Point2D * path_points = static_cast<QSGGeometry::Point2D *>(polygon_geometry->vertexData());
-    int i = 0;
-    for (const auto & triangle : triangles) {
-      int j = i*3;
-      const QcVectorDouble & p1 = triangle.p1;
-      path_points[j].set(p1.x(), p1.y());
-      const QcVectorDouble & p2 = triangle.p2;
-      path_points[j+1].set(p2.x(), p2.y());
-      const QcVectorDouble & p3 = triangle.p3;
-      path_points[j+2].set(p3.x(), p3.y());
-      qInfo() << i << p1 << p2 << p3;
-      i++;
+  bool covered = !m_culling_intervals.isEmpty();
+  for (const auto & interval : m_visible_intervals) {
+    bool included = false;
+    for (const auto & culling_interval : m_culling_intervals)
+      // Rebuild when zooming in since the covered area becomes too large
+      if (interval.is_included_in(culling_interval) and
+          culling_interval.x_length() < interval.x_length() + 4 * culling_margin) {
+        included = true;
+        break;
+      }
+    if (!included) {
+      covered = false;
+      break;
     }
-  } else
-    // Fixme: better
-    polygon_geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 0);
-  polygon_geometry->setDrawingMode(GL_TRIANGLES);
-  m_polygon_geometry_node->setGeometry(polygon_geometry);
-  m_polygon_geometry_node->setFlag(QSGNode::OwnsGeometry);
-  */
+  }
+
+  if (m_dirty_geometry or !covered) {
+    m_culling_intervals = m_visible_intervals;
+    for (auto & interval : m_culling_intervals)
+      interval.enlarge(culling_margin);
+    m_segment_ranges.resize(0);
+    m_segment_index.query(m_culling_intervals, m_segment_ranges);
+    build_geometry();
+    m_dirty_geometry = false;
+  }
+
+  update_transform();
+}
+
+//! Build the geometry of the segments within the culling area
+void
+QcPathNode::build_geometry()
+{
+  int number_of_path_vertexes = m_vertexes.size();
+
+  // Vertexes are given relatively to the origin
+  m_relative_vertexes.resize(number_of_path_vertexes);
+  for (int i = 0; i < number_of_path_vertexes; i++)
+    m_relative_vertexes[i] = (m_vertexes[i] - m_origin).mirror_y();
+
+  const QColor path_colour(0, 0, 255, 255);
+  const QColor selected_colour(255, 0, 0, 255);
 
   // Path
-  int number_of_segments = (number_of_path_vertexes) ? number_of_path_vertexes -1 : 0;
-  if (path_closed)
-    number_of_segments += 1;
-  number_of_vertexes = number_of_segments * 4;
-  QSGGeometry * path_geometry = new QSGGeometry(PathPoint2D_AttributeSet, number_of_vertexes);
-  path_geometry->setDrawingMode(GL_TRIANGLE_STRIP);
-  m_path_geometry_node->setGeometry(path_geometry);
-  m_path_geometry_node->setFlag(QSGNode::OwnsGeometry);
+  // The ranges are joined by degenerated triangles, thus two vertexes are inserted between them
+  int number_of_segments = 0;
+  for (const auto & range : m_segment_ranges)
+    number_of_segments += range.length();
+  int number_of_ranges = m_segment_ranges.size();
+  int number_of_vertexes = number_of_segments * 4;
+  if (number_of_ranges)
+    number_of_vertexes += (number_of_ranges -1) * 2;
+  QSGGeometry * path_geometry = m_path_geometry_node->geometry();
+  path_geometry->allocate(number_of_vertexes);
+  constexpr double line_width = 10;
   if (number_of_segments) {
-    constexpr double line_width = 10;
     constexpr double antialias_diameter = 1.; // Fixme: according shader !
     // Fixme: linewidth/2.0 + 1.5*antialias;
     double half_width = ceil(1.25*antialias_diameter + line_width) * .5;
 
     PathPoint2D * path_points = static_cast<PathPoint2D *>(path_geometry->vertexData());
-    int last_i = number_of_path_vertexes -2;
-    for (int i = 0; i <= last_i; i++) {
-      QcVectorDouble point1 = path_vertexes[i];
-      QcVectorDouble point2 = path_vertexes[i+1];
-      // Fixme: optimise
-      QcVectorDouble point0 = i > 0      ? path_vertexes[i-1] : point1;
-      QcVectorDouble point3 = i < last_i ? path_vertexes[i+2] : point2;
-      // qInfo() << i << point0 << point1 << point2 << point3;
-      set_path_points(path_points, i, point0, point1, point2, point3, line_width, half_width, path_colour);
-    }
-    if (path_closed) {
-      QcVectorDouble point0 = path_vertexes[last_i];
-      QcVectorDouble point1 = path_vertexes[last_i +1];
-      QcVectorDouble point2 = path_vertexes[0];
-      QcVectorDouble point3 = path_vertexes[1];
-      set_path_points(path_points, number_of_segments -1, point0, point1, point2, point3, line_width, half_width, path_colour);
+    const QVector<QcVectorDouble> & vertexes = m_relative_vertexes;
+    int n = number_of_path_vertexes;
+    int j = 0;
+    bool first_range = true;
+    for (const auto & range : m_segment_ranges) {
+      int degenerated_index = j;
+      if (!first_range)
+        j += 2;
+      for (int i = range.inf(); i <= range.sup(); i++) {
+        const QcVectorDouble & point1 = vertexes[i];
+        const QcVectorDouble & point2 = vertexes[(i+1) % n];
+        const QcVectorDouble & point0 = (i > 0 or m_closed) ? vertexes[(i-1+n) % n] : point1;
+        const QcVectorDouble & point3 = (i+2 < n or m_closed) ? vertexes[(i+2) % n] : point2;
+        // qInfo() << i << point0 << point1 << point2 << point3;
+        set_path_points(path_points + j, point0, point1, point2, point3, half_width);
+        j += 4;
+      }
+      if (!first_range) {
+        path_points[degenerated_index] = path_points[degenerated_index -1];
+        path_points[degenerated_index +1] = path_points[degenerated_index +2];
+      }
+      first_range = false;
     }
   }
-
-  // Points
-  number_of_vertexes = number_of_path_vertexes * 6;
-  QSGGeometry * point_geometry = new QSGGeometry(CirclePoint2D_AttributeSet, number_of_vertexes);
-  point_geometry->setDrawingMode(GL_TRIANGLES);
-  m_point_geometry_node->setGeometry(point_geometry);
-  m_point_geometry_node->setFlag(QSGNode::OwnsGeometry);
-  if (number_of_path_vertexes) {
+  // The colour and the line width are shared by the vertexes
+  auto * path_state = static_cast<QSGSimpleMaterial<QcPathMaterialShaderState> *>(m_path_geometry_node->material())->state();
+  path_state->colour = path_colour;
+  path_state->line_width = line_width;
+  m_path_geometry_node->markDirty(QSGNode::DirtyGeometry | QSGNode::DirtyMaterial);
+
+  // Points of the visible segments
+  int number_of_points = 0;
+  for (const auto & range : m_segment_ranges)
+    number_of_points += range.length() + 1;
+  if (!number_of_segments and number_of_path_vertexes == 1)
+    number_of_points = 1; // a single vertex has no segment
+  QSGGeometry * point_geometry = m_point_geometry_node->geometry();
+  point_geometry->allocate(number_of_points);
+  if (number_of_points) {
     CirclePoint2D * circle_points = static_cast<CirclePoint2D *>(point_geometry->vertexData());
     constexpr float point_radius = 10; // Fixme: setting
     constexpr float margin = 10;
-    int path_vertex_index = 0;
     int vertex_index = 0;
-    for (const auto & vertex : path_vertexes) {
-      QcDecoratedPathDouble::AttributeType attribute_type = path->attribute_at(path_vertex_index);
+    auto add_point = [&](int path_vertex_index) {
+      const QcVectorDouble & vertex = m_relative_vertexes[path_vertex_index];
+      QcDecoratedPathDouble::AttributeType attribute_type = m_attributes[path_vertex_index];
       QColor colour = test_bit(attribute_type, QcDecoratedPathDouble::AttributeType::Selected) ? selected_colour : path_colour;
       float radius = point_radius;
       if (test_bit(attribute_type, QcDecoratedPathDouble::AttributeType::Touched))
         // Fixme: set larger than a finger 2cm
         radius *= 4;
       float size = radius + margin;
-      double x = vertex.x();
-      double y = vertex.y();
-      QcVectorDouble point1(x - size, y - size);
-      QcVectorDouble point2(x - size, y + size);
-      QcVectorDouble point3(x + size, y - size);
-      QcVectorDouble point4(x + size, y + size);
-      QcVectorDouble uv1(-size, -size);
-      QcVectorDouble uv2(-size,  size);
-      QcVectorDouble uv3( size, -size);
-      QcVectorDouble uv4( size,  size);
-      circle_points[vertex_index    ].set(point1, uv1, radius, colour);
-      circle_points[vertex_index + 1].set(point2, uv2, radius, colour);
-      circle_points[vertex_index + 2].set(point3, uv3, radius, colour);
-      circle_points[vertex_index + 3].set(point2, uv2, radius, colour);
-      circle_points[vertex_index + 4].set(point4, uv4, radius, colour);
-      circle_points[vertex_index + 5].set(point3, uv3, radius, colour);
-      path_vertex_index++;
-      vertex_index += 6;
-    }
+      circle_points[vertex_index++].set(vertex, radius, size, colour);
+    };
+    if (number_of_segments)
+      for (const auto & range : m_segment_ranges)
+        for (int i = range.inf(); i <= range.sup() + 1; i++)
+          add_point(i % number_of_path_vertexes);
+    else
+      add_point(0);
   }
+  m_point_geometry_node->markDirty(QSGNode::DirtyGeometry);
+}
+
+QMatrix4x4
+QcPathNode::map_matrix(const QcViewport * viewport, const QcVectorDouble & origin)
+{
+  const QcViewportPart & part = viewport->central_part();
+  double scale = 1. / viewport->resolution(); // [px/m]
+  QcVectorDouble offset = (origin - part.inf_position()).mirror_y() * scale;
+  const QcInterval2DDouble & screen_interval = part.screen_interval();
+
+  QMatrix4x4 matrix;
+  matrix.translate(screen_interval.x().inf() + offset.x(), screen_interval.y().inf() + offset.y());
+  matrix.scale(scale, scale);
+  return matrix;
+}
+
+/*! Update the viewport transform of the shaders and of the fill.
+ *
+ * The map matrix maps the vertexes from the origin relative projected coordinate system to the
+ * screen, the extrusion is applied afterwards so as to keep a constant width in pixel.
+ */
+void
+QcPathNode::update_transform()
+{
+  QMatrix4x4 polygon_matrix = map_matrix(m_viewport, m_polygon_origin);
+  if (m_polygon_transform_node->matrix() != polygon_matrix)
+    m_polygon_transform_node->setMatrix(polygon_matrix);
+
+  QMatrix4x4 path_matrix = map_matrix(m_viewport, m_origin);
+  auto * path_state = static_cast<QSGSimpleMaterial<QcPathMaterialShaderState> *>(m_path_geometry_node->material())->state();
+  auto * point_state = static_cast<QSGSimpleMaterial<QcPointMaterialShaderState> *>(m_point_geometry_node->material())->state();
+  if (path_state->map_matrix == path_matrix)
+    return;
+
+  path_state->map_matrix = path_matrix;
+  path_state->scale = 1. / m_viewport->resolution(); // [px/m]
+  point_state->map_matrix = path_matrix;
+  m_path_geometry_node->markDirty(QSGNode::DirtyMaterial);
+  m_point_geometry_node->markDirty(QSGNode::DirtyMaterial);
 }
 
 /**************************************************************************************************/
@@ -34,10 +34,13 @@
 
 /**************************************************************************************************/
 
+#include "geometry/path.h"
+#include "geometry/path_segment_index.h"
 #include "map/decorated_path.h"
 #include "map/viewport.h"
 
 #include <QSGOpacityNode>
+#include <QSGTransformNode>
 
 /**************************************************************************************************/
 
@@ -49,27 +52,49 @@ struct PathPoint2D;
 
 class QcPathNode : public QSGOpacityNode
 {
+public:
+  // Largest extent of the path and its markers around a vertex [px]
+  static constexpr double MARKER_MARGIN = 50;
+
+public:
+  // Return the matrix mapping the vertexes relative to origin, y axis pointing down, to the item
+  static QMatrix4x4 map_matrix(const QcViewport * viewport, const QcVectorDouble & origin);
+
 public:
   QcPathNode(const QcViewport * viewport);
 
-  void update(const QcDecoratedPathDouble * path);
+  void update(const QcDecoratedPathDouble * path, const QVector<int> * indexes = nullptr);
+  void update_polygon(const QcPolygonTriangulation * triangulation);
+  // Must be called when the viewport changed
+  void update_viewport();
 
 private:
+  void build_geometry();
+  void update_transform();
   void set_path_points(PathPoint2D * path_points,
-                       int i,
-                       QcVectorDouble & point0,
-                       QcVectorDouble & point1,
-                       QcVectorDouble & point2,
-                       QcVectorDouble & point3,
-                       double line_width,
-                       double half_width,
-                       const QColor & colour);
+                       const QcVectorDouble & point0,
+                       const QcVectorDouble & point1,
+                       const QcVectorDouble & point2,
+                       const QcVectorDouble & point3,
+                       double half_width);
 
 private:
   const QcViewport * m_viewport; // Fixme: &
   QSGGeometryNode * m_path_geometry_node;
+  QSGTransformNode * m_polygon_transform_node;
   QSGGeometryNode * m_polygon_geometry_node;
   QSGGeometryNode * m_point_geometry_node;
+  QcVectorDouble m_origin; // in projected coordinate system
+  QVector<QcVectorDouble> m_vertexes; // in projected coordinate system
+  QVector<QcDecoratedPathDouble::AttributeType> m_attributes;
+  bool m_closed;
+  QcPathSegmentIndex m_segment_index;
+  bool m_dirty_geometry;
+  QVector<QcInterval2DDouble> m_visible_intervals;
+  QVector<QcInterval2DDouble> m_culling_intervals; // area covered by the geometry
+  QVector<QcIntervalInt> m_segment_ranges;
+  QVector<QcVectorDouble> m_relative_vertexes;
+  QcVectorDouble m_polygon_origin; // in projected coordinate system
 };
 
 /**************************************************************************************************/
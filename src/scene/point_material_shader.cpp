@@ -28,6 +28,17 @@
 
 #include "point_material_shader.h"
 
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+
+// Desktop OpenGL requires to enable the point size and the point sprites
+#ifndef GL_VERTEX_PROGRAM_POINT_SIZE
+#define GL_VERTEX_PROGRAM_POINT_SIZE 0x8642
+#endif
+#ifndef GL_POINT_SPRITE
+#define GL_POINT_SPRITE 0x8861
+#endif
+
 /**************************************************************************************************/
 
 // QC_BEGIN_NAMESPACE
@@ -51,13 +62,38 @@ QcPointMaterialShader::fragmentShader() const
 QList<QByteArray>
 QcPointMaterialShader::attributes() const
 {
-  return QList<QByteArray>() << "a_vertex" << "a_tex_coord" << "a_radius" << "a_colour";
+  return QList<QByteArray>() << "a_vertex" << "a_colour" << "a_size";
+}
+
+void
+QcPointMaterialShader::activate()
+{
+  QSGSimpleMaterialShader<QcPointMaterialShaderState>::activate();
+  QOpenGLContext * context = QOpenGLContext::currentContext();
+  if (!context->isOpenGLES()) {
+    QOpenGLFunctions * functions = context->functions();
+    functions->glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+    functions->glEnable(GL_POINT_SPRITE);
+  }
+}
+
+void
+QcPointMaterialShader::deactivate()
+{
+  QOpenGLContext * context = QOpenGLContext::currentContext();
+  if (!context->isOpenGLES()) {
+    QOpenGLFunctions * functions = context->functions();
+    functions->glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
+    functions->glDisable(GL_POINT_SPRITE);
+  }
+  QSGSimpleMaterialShader<QcPointMaterialShaderState>::deactivate();
 }
 
 void
 QcPointMaterialShader::updateState(const QcPointMaterialShaderState * state,
                                             const QcPointMaterialShaderState *)
 {
+  program()->setUniformValue("map_matrix", state->map_matrix);
   // program()->setUniformValue("colour", state->r, state->g, state->b, state->a);
 }
 
@@ -33,6 +33,7 @@
 
 /**************************************************************************************************/
 
+#include <QMatrix4x4>
 #include <QSGSimpleMaterialShader>
 
 /**************************************************************************************************/
@@ -43,6 +44,7 @@
 
 struct QcPointMaterialShaderState
 {
+  QMatrix4x4 map_matrix; // from the path referential to the item
   // float r, g, b, a;
 };
 
@@ -54,6 +56,8 @@ public:
   const char * vertexShader() const Q_DECL_OVERRIDE ;
   const char * fragmentShader() const Q_DECL_OVERRIDE ;
   QList<QByteArray> attributes() const Q_DECL_OVERRIDE ;
+  void activate() Q_DECL_OVERRIDE ;
+  void deactivate() Q_DECL_OVERRIDE ;
   void updateState(const QcPointMaterialShaderState * state,
                    const QcPointMaterialShaderState *) Q_DECL_OVERRIDE ;
 };
@@ -0,0 +1,38 @@
+/* *********************************************************************************************** */
+
+const float antialias_diameter = 1.;
+
+/* *********************************************************************************************** */
+
+uniform lowp float qt_Opacity;
+
+/* *********************************************************************************************** */
+
+varying highp vec2 tex_coord;
+varying lowp vec4 colour;
+
+/* *********************************************************************************************** */
+
+void main()
+{
+  // If colour is fully transparent we just discard the fragment
+  if (colour.a <= .0)
+    discard;
+
+  // Anti-alias test, distance to border
+  float d = abs(tex_coord.x) - (tex_coord.y - antialias_diameter);
+  float alpha = colour.a;
+  if (d > .0) {
+    d /= antialias_diameter;
+    alpha *= exp(-d*d);
+  }
+
+  // The scene graph expects a premultiplied colour
+  gl_FragColor = vec4(colour.rgb * alpha, alpha) * qt_Opacity;
+}
+
+/* *********************************************************************************************** *
+ *
+ * End
+ *
+ * *********************************************************************************************** */
@@ -0,0 +1,37 @@
+/* *********************************************************************************************** */
+
+uniform highp mat4 qt_Matrix;
+// Map the vertexes from the chunk referential to the item
+uniform highp mat4 map_matrix;
+
+// The scene graph normalises the integer attributes, pixel quantities are stored in 1/16 px
+const highp float pixel_unit = 32767. / 16.;
+
+/* *********************************************************************************************** */
+
+attribute highp vec2 a_vertex; // [m]
+attribute highp vec2 a_offset; // extrusion [1/16 px]
+attribute lowp vec4 a_colour;
+attribute highp vec2 a_tex_coord; // distance to the centre line, half line width [1/16 px]
+
+/* *********************************************************************************************** */
+
+varying highp vec2 tex_coord;
+varying lowp vec4 colour;
+
+/* *********************************************************************************************** */
+
+void main() {
+  tex_coord = a_tex_coord * pixel_unit;
+  colour = a_colour;
+
+  // The extrusion is applied in pixel thus the line width doesn't depend on the zoom level
+  vec2 offset = a_offset * pixel_unit;
+  gl_Position = qt_Matrix * (map_matrix * vec4(a_vertex, 0., 1.) + vec4(offset, 0., 0.));
+}
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
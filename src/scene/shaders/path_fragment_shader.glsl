@@ -14,14 +14,14 @@ const float antialias_diameter = 1.;
 /* *********************************************************************************************** */
 
 uniform lowp float qt_Opacity;
+uniform highp float line_width; // [px]
+uniform lowp vec4 colour;
 
 /* *********************************************************************************************** */
 
 varying highp vec2 uv;
 varying highp float line_length;
-varying highp float line_width;
 varying lowp float cap;
-varying lowp vec4 colour;
 
 /* *********************************************************************************************** */
 
@@ -1,36 +1,38 @@
 /* *********************************************************************************************** */
 
 uniform highp mat4 qt_Matrix;
+// Map the vertexes from the path referential to the item
+uniform highp mat4 map_matrix;
+uniform highp float scale; // [px/m]
+
+// The scene graph normalises the integer attributes, pixel quantities are stored in 1/16 px
+const highp float pixel_unit = 32767. / 16.;
 
 /* *********************************************************************************************** */
 
-// attribute highp vec2 a_vertex;
-attribute highp vec4 a_vertex;
-attribute highp vec2 a_tex_coord;
-attribute highp float a_line_length;
-attribute highp float a_line_width;
-attribute lowp float a_cap;
-attribute lowp vec4 a_colour;
+attribute highp vec2 a_vertex; // [m]
+attribute highp vec2 a_offset; // extrusion [1/16 px]
+attribute highp vec2 a_tex_coord; // u [1/16 px], v [1/16 px]
+attribute highp float a_line_length; // [m]
+attribute mediump vec2 a_cap; // cap + 1, 1 at the end of the segment
 
 /* *********************************************************************************************** */
 
 varying highp vec2 uv;
 varying highp float line_length;
-varying highp float line_width;
 varying lowp float cap;
-varying lowp vec4 colour;
 
 /* *********************************************************************************************** */
 
 void main() {
-  uv = a_tex_coord;
-  line_length = a_line_length;
-  line_width = a_line_width;
-  cap = a_cap;
-  colour = a_colour;
-
-  gl_Position = qt_Matrix * a_vertex;
-  // gl_Position = qt_Matrix * vec4(a_vertex.xy, 0, 1);
+  line_length = a_line_length * scale;
+  uv = a_tex_coord * pixel_unit;
+  uv.x += floor(a_cap.y * 255. + .5) * line_length;
+  cap = floor(a_cap.x * 255. + .5) - 1.;
+
+  // The extrusion is applied in pixel thus the line width doesn't depend on the zoom level
+  vec2 offset = a_offset * pixel_unit;
+  gl_Position = qt_Matrix * (map_matrix * vec4(a_vertex, 0., 1.) + vec4(offset, 0., 0.));
 }
 
 /***************************************************************************************************
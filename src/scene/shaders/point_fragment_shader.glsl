@@ -14,8 +14,8 @@ uniform lowp float qt_Opacity;
 
 /**************************************************************************************************/
 
-varying highp vec2 tex_coord;
 varying highp float radius;
+varying highp float size;
 varying lowp vec4 colour;
 
 /**************************************************************************************************/
@@ -112,6 +112,8 @@ marker_ring(vec2 P, float radius)
 
 void
 main() {
+  // Offset to the point [px]
+  vec2 tex_coord = (gl_PointCoord * 2. - 1.) * size;
   float d = marker_ring(tex_coord, radius);
   vec4 frag_colour = filled(d, linewidth, antialias, colour);
 
@@ -1,27 +1,30 @@
 /* *********************************************************************************************** */
 
 uniform highp mat4 qt_Matrix;
+// Map the vertexes from the path referential to the item
+uniform highp mat4 map_matrix;
 
 /* *********************************************************************************************** */
 
-attribute highp vec4 a_vertex;
-attribute highp vec2 a_tex_coord;
-attribute highp float a_radius;
+attribute highp vec2 a_vertex; // [m]
 attribute lowp vec4 a_colour;
+attribute highp vec2 a_size; // radius, half size of the sprite [px], normalised unsigned byte
 
 /* *********************************************************************************************** */
 
-varying highp vec2 tex_coord;
 varying highp float radius;
+varying highp float size;
 varying lowp vec4 colour;
 
 /* *********************************************************************************************** */
 
 void main() {
-  tex_coord = a_tex_coord;
-  radius = a_radius;
+  // The marker is drawn as a point sprite
+  radius = floor(a_size.x * 255. + .5);
+  size = floor(a_size.y * 255. + .5);
   colour = a_colour;
-  gl_Position = qt_Matrix * a_vertex;
+  gl_PointSize = 2. * size;
+  gl_Position = qt_Matrix * (map_matrix * vec4(a_vertex, 0., 1.));
 }
 
 /* *********************************************************************************************** */
@@ -0,0 +1,388 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include "tile_atlas.h"
+
+#include "cache/file_tile_cache.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QtDebug>
+
+#include <algorithm>
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+template <typename Pixel>
+static void
+copy_to_slot(const QImage & image, QImage & slot_image, int tile_size)
+{
+  int slot_size = tile_size + 2;
+  for (int y = 0; y < slot_size; y++) {
+    int source_y = qBound(0, y - 1, tile_size - 1);
+    const Pixel * source = reinterpret_cast<const Pixel *>(image.constScanLine(source_y));
+    Pixel * destination = reinterpret_cast<Pixel *>(slot_image.scanLine(y));
+    destination[0] = source[0];
+    memcpy(destination + 1, source, tile_size * sizeof(Pixel));
+    destination[slot_size - 1] = source[tile_size - 1];
+  }
+}
+
+// Copy the tile in the centre of a slot and repeat its edges on the border
+static QImage
+make_slot_image(const QImage & tile_image, int tile_size, QImage::Format format)
+{
+  QImage image = tile_image;
+  if (image.width() != tile_size or image.height() != tile_size)
+    image = image.scaled(tile_size, tile_size);
+  // No-op for the images decoded by the tile cache
+  if (image.format() != format)
+    image = image.convertToFormat(format);
+
+  int slot_size = tile_size + 2;
+  QImage slot_image(slot_size, slot_size, format);
+  if (format == QImage::Format_RGB16)
+    copy_to_slot<quint16>(image, slot_image, tile_size);
+  else
+    copy_to_slot<quint32>(image, slot_image, tile_size);
+
+  return slot_image;
+}
+
+/**************************************************************************************************/
+
+QcTileAtlasPage::QcTileAtlasPage(int page_size, int slot_size, QImage::Format format)
+  : QSGDynamicTexture(),
+    m_page_size(page_size),
+    m_slot_size(slot_size),
+    m_slots_per_row(page_size / slot_size),
+    m_format(format),
+    m_texture_id(0)
+{
+  setFiltering(QSGTexture::Linear);
+}
+
+QcTileAtlasPage::~QcTileAtlasPage()
+{
+  QOpenGLContext * context = QOpenGLContext::currentContext();
+  if (m_texture_id and context)
+    context->functions()->glDeleteTextures(1, &m_texture_id);
+}
+
+QRect
+QcTileAtlasPage::slot_rect(int slot) const
+{
+  int x = (slot % m_slots_per_row) * m_slot_size;
+  int y = (slot / m_slots_per_row) * m_slot_size;
+  return QRect(x, y, m_slot_size, m_slot_size);
+}
+
+QRectF
+QcTileAtlasPage::texture_rect(int slot) const
+{
+  QRect rect = slot_rect(slot).adjusted(1, 1, -1, -1);
+  double scale = 1. / m_page_size;
+  return QRectF(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
+}
+
+void
+QcTileAtlasPage::upload(int slot, const QImage & image)
+{
+  m_uploads << Upload({slot_rect(slot).topLeft(), image});
+}
+
+void
+QcTileAtlasPage::bind()
+{
+  QOpenGLFunctions * gl = QOpenGLContext::currentContext()->functions();
+
+  // RGB565 is supported by OpenGL ES 2
+  bool is_16_bit = m_format == QImage::Format_RGB16;
+  GLenum format = is_16_bit ? GL_RGB : GL_RGBA;
+  GLenum type = is_16_bit ? GL_UNSIGNED_SHORT_5_6_5 : GL_UNSIGNED_BYTE;
+
+  bool created = false;
+  if (!m_texture_id) {
+    gl->glGenTextures(1, &m_texture_id);
+    gl->glBindTexture(GL_TEXTURE_2D, m_texture_id);
+    gl->glTexImage2D(GL_TEXTURE_2D, 0, format, m_page_size, m_page_size, 0, format, type, nullptr);
+    created = true;
+  } else
+    gl->glBindTexture(GL_TEXTURE_2D, m_texture_id);
+
+  // Rows of a QImage are aligned on 4 bytes, as the default unpack alignment
+  for (const Upload & upload : m_uploads)
+    gl->glTexSubImage2D(GL_TEXTURE_2D, 0,
+                        upload.position.x(), upload.position.y(),
+                        upload.image.width(), upload.image.height(),
+                        format, type, upload.image.constBits());
+  m_uploads.clear();
+
+  updateBindOptions(created);
+}
+
+bool
+QcTileAtlasPage::updateTexture()
+{
+  bool changed = !m_texture_id or !m_uploads.isEmpty();
+  bind();
+  return changed;
+}
+
+/**************************************************************************************************/
+
+QcTileAtlas::QcTileAtlas(int tile_size, int page_size)
+  : m_tile_size(tile_size),
+    m_page_size(page_size),
+    m_frame(0),
+    m_upload_budget(DEFAULT_UPLOAD_BUDGET),
+    m_uploaded_bytes(0)
+{
+  QOpenGLContext * context = QOpenGLContext::currentContext();
+  if (context) {
+    GLint maximum_texture_size = 0;
+    context->functions()->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maximum_texture_size);
+    if (maximum_texture_size > 0)
+      m_page_size = qMin(m_page_size, int(maximum_texture_size));
+  }
+  // A page must hold at least a slot
+  m_page_size = qMax(m_page_size, tile_size + 2);
+}
+
+QcTileAtlas::~QcTileAtlas()
+{
+  qDeleteAll(m_pages);
+  qDeleteAll(m_released_pages);
+}
+
+const QcTileAtlasSlot *
+QcTileAtlas::use(const QcTileSpec & tile_spec)
+{
+  auto it = m_slots.find(tile_spec);
+  if (it == m_slots.end())
+    return nullptr;
+  it->last_frame = m_frame;
+  return &it.value();
+}
+
+QImage::Format
+QcTileAtlas::upload_format(const QImage & image)
+{
+  if (image.format() == QcTileTexture::FORMAT_16_BIT)
+    return QcTileTexture::FORMAT_16_BIT;
+  else
+    return QcTileTexture::FORMAT;
+}
+
+void
+QcTileAtlas::add_page(QImage::Format format)
+{
+  QcTileAtlasPage * page = new QcTileAtlasPage(m_page_size, m_tile_size + 2, format);
+  m_pages << page;
+  // Fill the page from the top left corner
+  QVector<QcTileAtlasSlot> & free_slots = m_free_slots[format];
+  for (int i = page->number_of_slots() - 1; i >= 0; i--) {
+    QcTileAtlasSlot free_slot;
+    free_slot.page = page;
+    free_slot.index = i;
+    free_slot.texture_rect = page->texture_rect(i);
+    free_slots << free_slot;
+  }
+}
+
+//! Evict the least recently used tile of a page having the format, return false if all are used
+bool
+QcTileAtlas::evict_lru_slot(QImage::Format format)
+{
+  const QcTileSpec * lru_tile_spec = nullptr;
+  int lru_frame = m_frame;
+  for (auto it = m_slots.constBegin(); it != m_slots.constEnd(); ++it)
+    if (it->last_frame < lru_frame and it->page->format() == format) {
+      lru_frame = it->last_frame;
+      lru_tile_spec = &it.key();
+    }
+  if (!lru_tile_spec)
+    return false;
+  // qInfo() << "evict" << *lru_tile_spec;
+  remove(QcTileSpec(*lru_tile_spec));
+  return true;
+}
+
+/*! Find a slot for a tile in the format.
+ *
+ * A slot not used during the current frame is evicted before a new page is opened, thus a page
+ * costs its memory only when the tiles of a frame don't fit in the current pages.
+ */
+bool
+QcTileAtlas::allocate(QcTileAtlasSlot & slot, QImage::Format format)
+{
+  if (m_free_slots[format].isEmpty() and !evict_lru_slot(format)) {
+    // The page cap is shared by the formats
+    if (m_pages.size() < MAXIMUM_NUMBER_OF_PAGES or release_lru_page(format))
+      add_page(format);
+    else
+      return false;
+  }
+
+  slot = m_free_slots[format].takeLast();
+  return true;
+}
+
+bool
+QcTileAtlas::insert(const QcTileSpec & tile_spec, const QImage & image)
+{
+  QImage::Format format = upload_format(image);
+
+  QcTileAtlasSlot slot;
+  auto it = m_slots.find(tile_spec);
+  if (it != m_slots.end() and it->page->format() == format)
+    slot = it.value();
+  else {
+    if (it != m_slots.end())
+      remove(tile_spec);
+    if (!allocate(slot, format)) {
+      qWarning() << "Tile atlas is full";
+      return false;
+    }
+  }
+
+  slot.last_frame = m_frame;
+  QImage slot_image = make_slot_image(image, m_tile_size, format);
+  m_uploaded_bytes += slot_image.bytesPerLine() * slot_image.height();
+  slot.page->upload(slot.index, slot_image);
+  m_slots.insert(tile_spec, slot);
+  return true;
+}
+
+void
+QcTileAtlas::remove(const QcTileSpec & tile_spec)
+{
+  auto it = m_slots.find(tile_spec);
+  if (it != m_slots.end()) {
+    QcTileAtlasSlot slot = it.value();
+    slot.last_frame = -1;
+    m_free_slots[slot.page->format()] << slot;
+    m_slots.erase(it);
+  }
+}
+
+void
+QcTileAtlas::upload()
+{
+  for (auto * page : m_pages)
+    if (page->has_pending_uploads())
+      page->bind();
+}
+
+//! Evict the tiles of the page and move it to the released pages
+void
+QcTileAtlas::release_page(QcTileAtlasPage * page)
+{
+  for (auto it = m_slots.begin(); it != m_slots.end();)
+    if (it->page == page)
+      it = m_slots.erase(it);
+    else
+      ++it;
+
+  QVector<QcTileAtlasSlot> & free_slots = m_free_slots[page->format()];
+  free_slots.erase(std::remove_if(free_slots.begin(), free_slots.end(),
+                                  [page](const QcTileAtlasSlot & slot) { return slot.page == page; }),
+                   free_slots.end());
+
+  m_pages.removeOne(page);
+  m_released_pages << page;
+}
+
+//! Compute the frame of the last use per page, last_frames must hold MAXIMUM_NUMBER_OF_PAGES
+void
+QcTileAtlas::compute_page_last_frames(int * last_frames) const
+{
+  for (int i = 0; i < m_pages.size(); i++)
+    last_frames[i] = -1;
+  for (const auto & slot : m_slots) {
+    int i = m_pages.indexOf(slot.page);
+    last_frames[i] = qMax(last_frames[i], slot.last_frame);
+  }
+}
+
+/*! Release the least recently used page having another format than format.
+ *
+ * Return false if all these pages are used during the current frame.
+ */
+bool
+QcTileAtlas::release_lru_page(QImage::Format format)
+{
+  int last_frames[MAXIMUM_NUMBER_OF_PAGES];
+  compute_page_last_frames(last_frames);
+
+  int lru_page = -1;
+  int lru_frame = m_frame;
+  for (int i = 0; i < m_pages.size(); i++)
+    if (m_pages[i]->format() != format and last_frames[i] < lru_frame) {
+      lru_frame = last_frames[i];
+      lru_page = i;
+    }
+  if (lru_page < 0)
+    return false;
+
+  release_page(m_pages[lru_page]);
+  return true;
+}
+
+void
+QcTileAtlas::release_unused_pages()
+{
+  int last_frames[MAXIMUM_NUMBER_OF_PAGES];
+  compute_page_last_frames(last_frames);
+
+  for (int i = m_pages.size() - 1; i >= 0; i--)
+    if (last_frames[i] < m_frame - PAGE_RELEASE_AGE)
+      release_page(m_pages[i]);
+}
+
+void
+QcTileAtlas::delete_released_pages()
+{
+  qDeleteAll(m_released_pages);
+  m_released_pages.clear();
+}
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
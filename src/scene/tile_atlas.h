@@ -0,0 +1,205 @@
+// -*- mode: c++ -*-
+
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#ifndef __TILE_ATLAS_H__
+#define __TILE_ATLAS_H__
+
+/**************************************************************************************************/
+
+#include "wmts/tile_spec.h"
+
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QRectF>
+#include <QSGDynamicTexture>
+#include <QVector>
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+/*! Texture of an atlas, tile images are uploaded in its slots when it is bound.
+ *
+ * Slots have a one pixel border which repeats the edges of the tile, so as to not sample the
+ * neighbour tiles with a linear filtering.
+ */
+class QcTileAtlasPage : public QSGDynamicTexture
+{
+  Q_OBJECT
+
+public:
+  QcTileAtlasPage(int page_size, int slot_size, QImage::Format format);
+  ~QcTileAtlasPage();
+
+  QImage::Format format() const { return m_format; }
+
+  int number_of_slots() const { return m_slots_per_row * m_slots_per_row; }
+  QRect slot_rect(int slot) const; // with border
+  QRectF texture_rect(int slot) const; // normalised, without border
+
+  void upload(int slot, const QImage & image);
+  bool has_pending_uploads() const { return !m_uploads.isEmpty(); }
+
+  int textureId() const Q_DECL_OVERRIDE { return m_texture_id; }
+  QSize textureSize() const Q_DECL_OVERRIDE { return QSize(m_page_size, m_page_size); }
+  bool hasAlphaChannel() const Q_DECL_OVERRIDE { return m_format != QImage::Format_RGB16; }
+  bool hasMipmaps() const Q_DECL_OVERRIDE { return false; }
+  void bind() Q_DECL_OVERRIDE;
+  bool updateTexture() Q_DECL_OVERRIDE;
+
+private:
+  class Upload {
+  public:
+    QPoint position;
+    QImage image;
+  };
+
+  int m_page_size;
+  int m_slot_size;
+  int m_slots_per_row;
+  QImage::Format m_format;
+  unsigned int m_texture_id;
+  QList<Upload> m_uploads;
+};
+
+/**************************************************************************************************/
+
+class QcTileAtlasSlot
+{
+public:
+  QcTileAtlasPage * page = nullptr;
+  int index = -1;
+  QRectF texture_rect;
+  int last_frame = -1; // frame of the last use, for the LRU eviction
+};
+
+/*! Pack the tile textures of a layer in a few large textures.
+ *
+ * Tiles are drawn by a geometry node per atlas page, thus a viewport part which fits in a page is
+ * drawn with a single draw call.  Tiles are kept in the atlas until their slot is required, the
+ * least recently used slot which was not used during the current frame is evicted first.  A new
+ * page is only opened when all the slots are used during the current frame, thus the number of
+ * pages follows the number of tiles drawn.  A page having no tile drawn during PAGE_RELEASE_AGE
+ * frames is released.
+ *
+ * Released pages can still be referenced by the scene graph, the owner must remove the nodes
+ * drawing them before it calls delete_released_pages.
+ *
+ * A page stores either RGBA8888 or RGB565 tiles, the format of a tile is given by its image, see
+ * QcTileTexture.  Images in another format are converted at insertion.  When all the pages are
+ * opened, the least recently used page of the other format is released to open a page in the
+ * required format.
+ *
+ * Must be used on the render thread.
+ */
+class QcTileAtlas
+{
+public:
+  static constexpr int DEFAULT_PAGE_SIZE = 4096;
+  static constexpr int MAXIMUM_NUMBER_OF_PAGES = 4;
+  static constexpr int DEFAULT_UPLOAD_BUDGET = 4 * 1024 * 1024; // bytes per frame, 16 tiles of 256 px
+  static constexpr int PAGE_RELEASE_AGE = 120; // frames
+
+public:
+  QcTileAtlas(int tile_size, int page_size = DEFAULT_PAGE_SIZE);
+  ~QcTileAtlas();
+
+  int tile_size() const { return m_tile_size; }
+  int page_size() const { return m_page_size; }
+  int number_of_pages() const { return m_pages.size(); }
+  int number_of_tiles() const { return m_slots.size(); }
+
+  void begin_frame() {
+    m_frame++;
+    m_uploaded_bytes = 0;
+  }
+
+  /* Uploads are done during the synchronisation where the GUI thread is blocked, thus the bytes
+   * uploaded per frame are limited.  The tiles beyond the budget are packed on the next frames.
+   */
+  int upload_budget() const { return m_upload_budget; }
+  void set_upload_budget(int upload_budget) { m_upload_budget = upload_budget; }
+  bool has_upload_budget() const { return m_uploaded_bytes < m_upload_budget; }
+
+  bool contains(const QcTileSpec & tile_spec) const { return m_slots.contains(tile_spec); }
+  // Return the slot and mark it as used during this frame, nullptr if the tile isn't in the atlas
+  const QcTileAtlasSlot * use(const QcTileSpec & tile_spec);
+  // Copy the image in a free slot, return false if all the slots are used during this frame
+  bool insert(const QcTileSpec & tile_spec, const QImage & image);
+  // Format of the page storing the image
+  static QImage::Format upload_format(const QImage & image);
+  void remove(const QcTileSpec & tile_spec);
+
+  // Upload the new tiles, requires a current OpenGL context
+  void upload();
+
+  // Release the pages having no tile drawn during the last PAGE_RELEASE_AGE frames
+  void release_unused_pages();
+  const QList<QcTileAtlasPage *> & released_pages() const { return m_released_pages; }
+  // Requires a current OpenGL context
+  void delete_released_pages();
+
+private:
+  bool allocate(QcTileAtlasSlot & slot, QImage::Format format);
+  bool evict_lru_slot(QImage::Format format);
+  void add_page(QImage::Format format);
+  void compute_page_last_frames(int * last_frames) const;
+  bool release_lru_page(QImage::Format format);
+  void release_page(QcTileAtlasPage * page);
+
+private:
+  int m_tile_size;
+  int m_page_size;
+  int m_frame;
+  int m_upload_budget;
+  int m_uploaded_bytes;
+  QList<QcTileAtlasPage *> m_pages;
+  QList<QcTileAtlasPage *> m_released_pages; // to be deleted once the scene graph doesn't use them
+  QHash<QcTileSpec, QcTileAtlasSlot> m_slots;
+  QHash<int, QVector<QcTileAtlasSlot> > m_free_slots; // per page format
+};
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/**************************************************************************************************/
+
+#endif /* __TILE_ATLAS_H__ */
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -21,6 +21,8 @@ SOURCES += \
   cache/file_tile_cache.cpp \
   cache/offline_cache.cpp \
   cache/offline_cache_database.cpp \
+  cache/qoi_image.cpp \
+  cache/tile_buffer_pool.cpp \
   cache/tile_image.cpp
 
 SOURCES += \
@@ -42,8 +44,11 @@ SOURCES += \
 SOURCES += \
   geometry/line.cpp \
   geometry/path.cpp \
+  geometry/path_pyramid.cpp \
+  geometry/path_segment_index.cpp \
   geometry/polygon.cpp \
   geometry/polygon_seidler_triangulation.cpp \
+  geometry/tiled_corridor.cpp \
   geometry/vector.cpp
 
 SOURCES += \
@@ -51,6 +56,7 @@ SOURCES += \
   map/map_event_router.cpp \
   map/map_path_editor.cpp \
   map/map_view.cpp \
+  map/overlay_layer.cpp \
   map/path_property.cpp \
   map/viewport.cpp \
   map/decorated_path.cpp
@@ -65,12 +71,16 @@ SOURCES += \
   scene/location_circle_node.cpp \
   scene/map_layer_scene.cpp \
   scene/map_scene.cpp \
+  scene/overlay_node.cpp \
+  scene/overlay_path_material_shader.cpp \
   scene/path_material_shader.cpp \
   scene/path_node.cpp \
-  scene/point_material_shader.cpp
+  scene/point_material_shader.cpp \
+  scene/tile_atlas.cpp
 
 SOURCES += \
   tools/debug_data.cpp \
+  tools/frame_statistics.cpp \
   tools/logger.cpp \
   tools/platform.cpp
 
@@ -89,6 +99,8 @@ SOURCES += \
   wmts/providers/osm/osm_plugin.cpp \
   wmts/providers/spain/spain_plugin.cpp \
   wmts/providers/swiss_confederation/swiss_confederation_plugin.cpp \
+  wmts/tile_bit_set.cpp \
+  wmts/tile_layer_index.cpp \
   wmts/tile_matrix_index.cpp \
   wmts/tile_matrix_set.cpp \
   wmts/tile_spec.cpp \
@@ -105,6 +117,8 @@ HEADERS += \
   cache/file_tile_cache.h \
   cache/offline_cache.h \
   cache/offline_cache_database.h \
+  cache/qoi_image.h \
+  cache/tile_buffer_pool.h \
   cache/tile_image.h
 
 HEADERS += \
@@ -126,7 +140,10 @@ HEADERS += \
 HEADERS += \
   geometry/line.h \
   geometry/path.h \
+  geometry/path_pyramid.h \
+  geometry/path_segment_index.h \
   geometry/polygon.h \
+  geometry/tiled_corridor.h \
   geometry/vector.h
 
 HEADERS += \
@@ -134,6 +151,7 @@ HEADERS += \
   map/map_event_router.h \
   map/map_path_editor.h \
   map/map_view.h \
+  map/overlay_layer.h \
   map/path_property.h \
   map/viewport.h \
   map/decorated_path.h
@@ -147,12 +165,16 @@ HEADERS += \
   scene/location_circle_material_shader.h \
   scene/location_circle_node.h \
   scene/map_scene.h \
+  scene/overlay_node.h \
+  scene/overlay_path_material_shader.h \
   scene/path_material_shader.h \
   scene/path_node.h \
-  scene/point_material_shader.h
+  scene/point_material_shader.h \
+  scene/tile_atlas.h
 
 HEADERS += \
   tools/debug_data.h \
+  tools/frame_statistics.h \
   tools/logger.h \
   tools/platform.h
 
@@ -171,6 +193,8 @@ HEADERS += \
   wmts/providers/osm/osm_plugin.h \
   wmts/providers/spain/spain_plugin.h \
   wmts/providers/swiss_confederation/swiss_confederation_plugin.h \
+  wmts/tile_bit_set.h \
+  wmts/tile_layer_index.h \
   wmts/tile_matrix_index.h \
   wmts/tile_matrix_set.h \
   wmts/tile_spec.h \
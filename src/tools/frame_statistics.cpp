@@ -0,0 +1,189 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include "frame_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QMutexLocker>
+
+/**************************************************************************************************/
+
+constexpr double NANOSECONDS_PER_MILLISECOND = 1e6;
+
+QcStageStatistics::QcStageStatistics()
+  : m_samples(),
+    m_next(0),
+    m_count(0)
+{}
+
+void
+QcStageStatistics::add_sample(qint64 duration)
+{
+  if (m_samples.size() < NUMBER_OF_SAMPLES)
+    m_samples << duration;
+  else {
+    m_samples[m_next] = duration;
+    m_next = (m_next + 1) % NUMBER_OF_SAMPLES;
+  }
+  m_count++;
+}
+
+void
+QcStageStatistics::clear()
+{
+  m_samples.clear();
+  m_next = 0;
+  m_count = 0;
+}
+
+double
+QcStageStatistics::percentile(double p) const
+{
+  if (m_samples.isEmpty())
+    return .0;
+
+  // Nearest rank
+  int number_of_samples = m_samples.size();
+  int rank = std::ceil(qBound(.0, p, 100.) / 100. * number_of_samples);
+  int index = qBound(0, rank - 1, number_of_samples - 1);
+  QVector<qint64> samples = m_samples;
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index] / NANOSECONDS_PER_MILLISECOND;
+}
+
+double
+QcStageStatistics::maximum() const
+{
+  if (m_samples.isEmpty())
+    return .0;
+  return *std::max_element(m_samples.begin(), m_samples.end()) / NANOSECONDS_PER_MILLISECOND;
+}
+
+/**************************************************************************************************/
+
+QString
+QcFrameStatistics::stage_name(Stage stage)
+{
+  switch (stage) {
+  case Frame:
+    return QStringLiteral("frame");
+  case ViewLayerUpdate:
+    return QStringLiteral("view_layer_update");
+  case ViewLayerPreparation:
+    return QStringLiteral("view_layer_preparation");
+  case LayerSceneGraphUpdate:
+    return QStringLiteral("layer_scene_graph_update");
+  case TextureUpload:
+    return QStringLiteral("texture_upload");
+  case PathUpdate:
+    return QStringLiteral("path_update");
+  case OverlayUpdate:
+    return QStringLiteral("overlay_update");
+  case GridUpdate:
+    return QStringLiteral("grid_update");
+  }
+  return QString();
+}
+
+QString
+QcFrameStatistics::key(Stage stage, const QString & layer)
+{
+  if (layer.isEmpty())
+    return stage_name(stage);
+  else
+    return stage_name(stage) + '/' + layer;
+}
+
+QcFrameStatistics::QcFrameStatistics(QObject * parent)
+  : QObject(parent),
+    m_enabled(false),
+    m_mutex(),
+    m_statistics()
+{}
+
+QcFrameStatistics::~QcFrameStatistics()
+{}
+
+void
+QcFrameStatistics::set_enabled(bool enabled)
+{
+  if (enabled != m_enabled) {
+    m_enabled = enabled;
+    emit enabled_changed(enabled);
+  }
+}
+
+void
+QcFrameStatistics::add_sample(Stage stage, const QString & layer, qint64 duration)
+{
+  QMutexLocker locker(&m_mutex);
+  m_statistics[key(stage, QString())].add_sample(duration);
+  if (!layer.isEmpty())
+    m_statistics[key(stage, layer)].add_sample(duration);
+}
+
+QcStageStatistics
+QcFrameStatistics::statistics(Stage stage, const QString & layer) const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_statistics.value(key(stage, layer));
+}
+
+QVariantMap
+QcFrameStatistics::to_variant_map() const
+{
+  QMutexLocker locker(&m_mutex);
+  QVariantMap map;
+  for (auto it = m_statistics.cbegin(); it != m_statistics.cend(); ++it) {
+    const QcStageStatistics & statistics = it.value();
+    QVariantMap stage_map;
+    stage_map[QStringLiteral("count")] = statistics.count();
+    stage_map[QStringLiteral("p50")] = statistics.percentile(50);
+    stage_map[QStringLiteral("p90")] = statistics.percentile(90);
+    stage_map[QStringLiteral("p99")] = statistics.percentile(99);
+    stage_map[QStringLiteral("max")] = statistics.maximum();
+    map[it.key()] = stage_map;
+  }
+  return map;
+}
+
+void
+QcFrameStatistics::clear()
+{
+  QMutexLocker locker(&m_mutex);
+  m_statistics.clear();
+}
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
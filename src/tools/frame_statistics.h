@@ -0,0 +1,185 @@
+// -*- mode: c++ -*-
+
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#ifndef __FRAME_STATISTICS_H__
+#define __FRAME_STATISTICS_H__
+
+/**************************************************************************************************/
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+#include "qtcarto_global.h"
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+/*! Rolling window of the durations of a pipeline stage.
+ *
+ * Durations are recorded in nanoseconds and percentiles are returned in milliseconds.
+ */
+class QC_EXPORT QcStageStatistics
+{
+public:
+  static constexpr int NUMBER_OF_SAMPLES = 240; // 4 s at 60 fps
+
+public:
+  QcStageStatistics();
+
+  void add_sample(qint64 duration);
+  void clear();
+
+  // Number of samples added since the last clear
+  inline qint64 count() const { return m_count; }
+  inline int number_of_samples() const { return m_samples.size(); }
+
+  // Percentile p in [0, 100] of the window [ms]
+  double percentile(double p) const;
+  // Maximum of the window [ms]
+  double maximum() const;
+
+private:
+  QVector<qint64> m_samples;
+  int m_next; // slot overwritten by the next sample once the window is full
+  qint64 m_count;
+};
+
+/**************************************************************************************************/
+
+/*! Durations of the stages of the scene graph update, for the whole map and for each layer.
+ *
+ * The instrumentation is disabled by default, a disabled timer only tests a flag.  Samples are
+ * added from the render thread, thus the statistics are protected by a mutex.
+ */
+class QC_EXPORT QcFrameStatistics : public QObject
+{
+  Q_OBJECT
+  Q_PROPERTY(bool enabled READ is_enabled WRITE set_enabled NOTIFY enabled_changed)
+
+public:
+  enum Stage {
+    Frame, // QcMapScene::update_scene_graph
+    ViewLayerUpdate, // QcMapViewLayer::commit_scene
+    ViewLayerPreparation, // QcMapViewLayer::prepare_scene, run concurrently
+    LayerSceneGraphUpdate, // QcMapLayerScene::update_scene_graph
+    TextureUpload, // tiles packed in the atlas
+    PathUpdate, // QcPathNode::update
+    OverlayUpdate, // QcOverlayNode::update
+    GridUpdate, // QcGridNode::update
+  };
+  Q_ENUM(Stage)
+
+  static QString stage_name(Stage stage);
+
+public:
+  QcFrameStatistics(QObject * parent = nullptr);
+  ~QcFrameStatistics();
+
+  inline bool is_enabled() const { return m_enabled; }
+  void set_enabled(bool enabled);
+
+  // A sample of a layer is also accounted in the statistics of the stage
+  void add_sample(Stage stage, const QString & layer, qint64 duration);
+  QcStageStatistics statistics(Stage stage, const QString & layer = QString()) const;
+
+  /* Return a map "stage" or "stage/layer" -> {count, p50, p90, p99, max}, durations are in
+   * milliseconds.
+   */
+  Q_INVOKABLE QVariantMap to_variant_map() const;
+  Q_INVOKABLE void clear();
+
+signals:
+  void enabled_changed(bool enabled);
+
+private:
+  static QString key(Stage stage, const QString & layer);
+
+private:
+  bool m_enabled;
+  mutable QMutex m_mutex;
+  QHash<QString, QcStageStatistics> m_statistics;
+};
+
+/**************************************************************************************************/
+
+/*! Add the duration of the enclosing scope to the frame statistics.
+ *
+ * Nothing is measured if the statistics are null or disabled when the timer is created.
+ */
+class QcStageTimer
+{
+public:
+  QcStageTimer(QcFrameStatistics * statistics,
+               QcFrameStatistics::Stage stage,
+               const QString & layer = QString())
+    : m_statistics((statistics and statistics->is_enabled()) ? statistics : nullptr),
+      m_stage(stage)
+  {
+    if (m_statistics) {
+      m_layer = layer;
+      m_timer.start();
+    }
+  }
+
+  ~QcStageTimer()
+  {
+    if (m_statistics)
+      m_statistics->add_sample(m_stage, m_layer, m_timer.nsecsElapsed());
+  }
+
+private:
+  QcFrameStatistics * m_statistics;
+  QcFrameStatistics::Stage m_stage;
+  QString m_layer;
+  QElapsedTimer m_timer;
+};
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/**************************************************************************************************/
+
+#endif /* __FRAME_STATISTICS_H__ */
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -0,0 +1,239 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include "tile_bit_set.h"
+
+#include <algorithm>
+
+/**************************************************************************************************/
+
+QcTileBitSet::QcTileBitSet()
+  : m_level(-1),
+    m_mosaic_size(0),
+    m_x0(0),
+    m_width(0),
+    m_y0(0),
+    m_height(0),
+    m_words_per_row(0),
+    m_words()
+{}
+
+void
+QcTileBitSet::set_frame(int level, int mosaic_size, int x0, int width, int y0, int height)
+{
+  m_level = level;
+  m_mosaic_size = mosaic_size;
+  m_x0 = x0;
+  m_width = width;
+  m_y0 = y0;
+  m_height = height;
+  m_words_per_row = (width + BITS_PER_WORD - 1) / BITS_PER_WORD;
+  m_words.resize(m_words_per_row * height); // keep the capacity
+  clear();
+}
+
+void
+QcTileBitSet::set_frame(const QcTileBitSet & other)
+{
+  set_frame(other.m_level, other.m_mosaic_size, other.m_x0, other.m_width, other.m_y0, other.m_height);
+}
+
+void
+QcTileBitSet::reset()
+{
+  m_level = -1;
+  m_mosaic_size = m_x0 = m_width = m_y0 = m_height = m_words_per_row = 0;
+  m_words.resize(0);
+}
+
+bool
+QcTileBitSet::has_same_frame(const QcTileBitSet & other) const
+{
+  return
+    m_level == other.m_level and
+    m_mosaic_size == other.m_mosaic_size and
+    m_x0 == other.m_x0 and
+    m_width == other.m_width and
+    m_y0 == other.m_y0 and
+    m_height == other.m_height;
+}
+
+bool
+QcTileBitSet::frame_contains(int x, int y) const
+{
+  return
+    0 <= x and x < m_mosaic_size and
+    m_y0 <= y and y < m_y0 + m_height and
+    position(x) < m_width;
+}
+
+bool
+QcTileBitSet::frame_contains(const QcTiledPolygonRun & run) const
+{
+  const QcIntervalInt & interval = run.interval();
+  if (!frame_contains(interval.inf(), run.y()) or !frame_contains(interval.sup(), run.y()))
+    return false;
+  // The run could go round the frame
+  return position(interval.inf()) + interval.sup() - interval.inf() < m_width;
+}
+
+void
+QcTileBitSet::clear()
+{
+  std::fill(m_words.begin(), m_words.end(), 0);
+}
+
+bool
+QcTileBitSet::is_empty() const
+{
+  for (quint64 word : m_words)
+    if (word)
+      return false;
+  return true;
+}
+
+int
+QcTileBitSet::count() const
+{
+  int count = 0;
+  for (quint64 word : m_words)
+    count += qPopulationCount(word);
+  return count;
+}
+
+bool
+QcTileBitSet::contains(int x, int y) const
+{
+  if (!frame_contains(x, y))
+    return false;
+  int position = this->position(x);
+  return word(position, y) & mask(position);
+}
+
+void
+QcTileBitSet::insert(int x, int y)
+{
+  Q_ASSERT(frame_contains(x, y));
+  int position = this->position(x);
+  word(position, y) |= mask(position);
+}
+
+void
+QcTileBitSet::remove(int x, int y)
+{
+  if (!frame_contains(x, y))
+    return;
+  int position = this->position(x);
+  word(position, y) &= ~mask(position);
+}
+
+//! Set the bits from first to last position of a row, word by word
+void
+QcTileBitSet::set_bits(int y, int first_position, int last_position)
+{
+  int first_word = first_position / BITS_PER_WORD;
+  int last_word = last_position / BITS_PER_WORD;
+  quint64 first_mask = ~quint64(0) << (first_position % BITS_PER_WORD);
+  quint64 last_mask = ~quint64(0) >> (BITS_PER_WORD - 1 - last_position % BITS_PER_WORD);
+  quint64 * words = m_words.data() + (y - m_y0) * m_words_per_row;
+  if (first_word == last_word)
+    words[first_word] |= first_mask & last_mask;
+  else {
+    words[first_word] |= first_mask;
+    for (int i = first_word + 1; i < last_word; i++)
+      words[i] = ~quint64(0);
+    words[last_word] |= last_mask;
+  }
+}
+
+void
+QcTileBitSet::insert(const QcTiledPolygonRun & run)
+{
+  Q_ASSERT(frame_contains(run));
+  const QcIntervalInt & interval = run.interval();
+  int first_position = position(interval.inf());
+  set_bits(run.y(), first_position, first_position + interval.sup() - interval.inf());
+}
+
+void
+QcTileBitSet::assign(const QcTileBitSet & other)
+{
+  m_level = other.m_level;
+  m_mosaic_size = other.m_mosaic_size;
+  m_x0 = other.m_x0;
+  m_width = other.m_width;
+  m_y0 = other.m_y0;
+  m_height = other.m_height;
+  m_words_per_row = other.m_words_per_row;
+  // Don't share the buffer, else the next write would detach it
+  m_words.resize(other.m_words.size());
+  std::copy(other.m_words.constBegin(), other.m_words.constEnd(), m_words.begin());
+}
+
+QcTileBitSet &
+QcTileBitSet::operator|=(const QcTileBitSet & other)
+{
+  if (has_same_frame(other)) {
+    quint64 * words = m_words.data();
+    for (quint64 word : other.m_words)
+      *words++ |= word;
+  } else if (m_level == other.m_level)
+    other.for_each([this](int x, int y) {
+        if (frame_contains(x, y))
+          insert(x, y);
+      });
+  return *this;
+}
+
+QcTileBitSet &
+QcTileBitSet::operator-=(const QcTileBitSet & other)
+{
+  if (has_same_frame(other)) {
+    quint64 * words = m_words.data();
+    for (quint64 word : other.m_words)
+      *words++ &= ~word;
+  } else if (m_level == other.m_level)
+    for_each([this, &other](int x, int y) {
+        if (other.contains(x, y))
+          remove(x, y);
+      });
+  return *this;
+}
+
+bool
+QcTileBitSet::operator==(const QcTileBitSet & other) const
+{
+  return has_same_frame(other) and m_words == other.m_words;
+}
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
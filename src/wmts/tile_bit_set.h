@@ -0,0 +1,165 @@
+// -*- mode: c++ -*-
+
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#ifndef __TILE_BIT_SET_H__
+#define __TILE_BIT_SET_H__
+
+/**************************************************************************************************/
+
+#include <QVector>
+#include <QtGlobal>
+#include <QtAlgorithms>
+
+#include "geometry/polygon.h"
+#include "qtcarto_global.h"
+#include "wmts/tile_spec.h"
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+/*! Dense set of the tiles of a level lying within a frame.
+ *
+ * The frame is a rectangle of the tile matrix, the tile (x, y) is stored in the bit (x - x0, y - y0)
+ * of a row of 64-bit words.  The x axis wraps around the mosaic so as to cover a viewport which
+ * crosses the antimeridian using a narrow frame.
+ *
+ * The union and the difference of two sets having the same frame are done word by word, else they
+ * fall back to a test per tile.  Buffers keep their capacity, thus a set can be refilled without
+ * allocation.
+ */
+class QC_EXPORT QcTileBitSet
+{
+ public:
+  static constexpr int BITS_PER_WORD = 64;
+
+ public:
+  QcTileBitSet();
+
+  // A null set has no frame and is empty
+  inline bool is_null() const { return m_level < 0; }
+  inline int level() const { return m_level; }
+  inline int mosaic_size() const { return m_mosaic_size; }
+  inline int x0() const { return m_x0; }
+  inline int width() const { return m_width; }
+  inline int y0() const { return m_y0; }
+  inline int height() const { return m_height; }
+
+  // Set the frame and clear the set
+  void set_frame(int level, int mosaic_size, int x0, int width, int y0, int height);
+  void set_frame(const QcTileBitSet & other);
+  void reset();
+  bool has_same_frame(const QcTileBitSet & other) const;
+  bool frame_contains(int x, int y) const;
+  bool frame_contains(const QcTiledPolygonRun & run) const;
+
+  void clear();
+  bool is_empty() const;
+  int count() const;
+
+  bool contains(int x, int y) const;
+  inline bool contains(const QcTileSpec & tile_spec) const {
+    return tile_spec.level() == m_level and contains(tile_spec.x(), tile_spec.y());
+  }
+  // Tiles must lie within the frame
+  void insert(int x, int y);
+  void insert(const QcTiledPolygonRun & run);
+  void remove(int x, int y);
+
+  // Copy the frame and the tiles
+  void assign(const QcTileBitSet & other);
+  QcTileBitSet & operator|=(const QcTileBitSet & other);
+  QcTileBitSet & operator-=(const QcTileBitSet & other);
+  bool operator==(const QcTileBitSet & other) const;
+  inline bool operator!=(const QcTileBitSet & other) const { return !(*this == other); }
+
+  // Call function(x, y) for each tile, row by row
+  template <typename F>
+  void for_each(F function) const
+  {
+    const quint64 * words = m_words.constData();
+    for (int row = 0; row < m_height; row++) {
+      int y = m_y0 + row;
+      for (int i = 0; i < m_words_per_row; i++) {
+        quint64 word = *words++;
+        while (word) {
+          int position = i * BITS_PER_WORD + qCountTrailingZeroBits(word);
+          word &= word - 1;
+          function(x_at(position), y);
+        }
+      }
+    }
+  }
+
+ private:
+  inline int position(int x) const {
+    int position = x - m_x0;
+    return position < 0 ? position + m_mosaic_size : position;
+  }
+  inline int x_at(int position) const {
+    int x = m_x0 + position;
+    return x < m_mosaic_size ? x : x - m_mosaic_size;
+  }
+  inline quint64 & word(int position, int y) {
+    return m_words[(y - m_y0) * m_words_per_row + position / BITS_PER_WORD];
+  }
+  inline quint64 word(int position, int y) const {
+    return m_words[(y - m_y0) * m_words_per_row + position / BITS_PER_WORD];
+  }
+  static inline quint64 mask(int position) { return quint64(1) << (position % BITS_PER_WORD); }
+  void set_bits(int y, int first_position, int last_position);
+
+ private:
+  int m_level;
+  int m_mosaic_size;
+  int m_x0;
+  int m_width;
+  int m_y0;
+  int m_height;
+  int m_words_per_row;
+  QVector<quint64> m_words;
+};
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/**************************************************************************************************/
+
+#endif /* __TILE_BIT_SET_H__ */
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
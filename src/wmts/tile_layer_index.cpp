@@ -0,0 +1,156 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#include "tile_layer_index.h"
+
+#include <QtDebug>
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+bool
+QcMapViewLayerSmallSet::insert(QcMapViewLayer * layer)
+{
+  if (contains(layer))
+    return false;
+  append(layer);
+  return true;
+}
+
+bool
+QcMapViewLayerSmallSet::remove(QcMapViewLayer * layer)
+{
+  for (int i = 0; i < size(); i++)
+    if (at(i) == layer) {
+      // order doesn't matter
+      (*this)[i] = last();
+      removeLast();
+      return true;
+    }
+  return false;
+}
+
+/**************************************************************************************************/
+
+QcTileLayerIndex::QcTileLayerIndex()
+  : m_tile_hash(),
+    m_layer_hash()
+{}
+
+QcTileLayerIndex::~QcTileLayerIndex()
+{}
+
+bool
+QcTileLayerIndex::add(QcMapViewLayer * layer, const QcTileSpec & tile_spec)
+{
+  QcMapViewLayerSmallSet & layers = m_tile_hash[tile_spec];
+  bool is_new = layers.isEmpty();
+  if (layers.insert(layer))
+    m_layer_hash[layer].insert(tile_spec);
+  return is_new;
+}
+
+bool
+QcTileLayerIndex::remove(QcMapViewLayer * layer, const QcTileSpec & tile_spec)
+{
+  auto tile_it = m_tile_hash.find(tile_spec);
+  if (tile_it == m_tile_hash.end() or !tile_it.value().remove(layer))
+    return false;
+
+  auto layer_it = m_layer_hash.find(layer);
+  if (layer_it != m_layer_hash.end()) {
+    layer_it.value().remove(tile_spec);
+    if (layer_it.value().isEmpty())
+      m_layer_hash.erase(layer_it);
+  }
+
+  if (tile_it.value().isEmpty()) {
+    m_tile_hash.erase(tile_it);
+    return true;
+  } else
+    return false;
+}
+
+QcMapViewLayerSmallSet
+QcTileLayerIndex::take_tile(const QcTileSpec & tile_spec)
+{
+  QcMapViewLayerSmallSet layers = m_tile_hash.take(tile_spec);
+  for (QcMapViewLayer * layer : layers) {
+    auto layer_it = m_layer_hash.find(layer);
+    if (layer_it != m_layer_hash.end()) {
+      layer_it.value().remove(tile_spec);
+      if (layer_it.value().isEmpty())
+        m_layer_hash.erase(layer_it);
+    }
+  }
+  return layers;
+}
+
+QcTileSpecSet
+QcTileLayerIndex::release_layer(QcMapViewLayer * layer)
+{
+  QcTileSpecSet orphan_tiles;
+  QcTileSpecSet tiles = m_layer_hash.take(layer);
+  for (const QcTileSpec & tile_spec : tiles) {
+    auto tile_it = m_tile_hash.find(tile_spec);
+    if (tile_it == m_tile_hash.end())
+      continue;
+    tile_it.value().remove(layer);
+    if (tile_it.value().isEmpty()) {
+      m_tile_hash.erase(tile_it);
+      orphan_tiles.insert(tile_spec);
+    }
+  }
+  return orphan_tiles;
+}
+
+void
+QcTileLayerIndex::dump() const
+{
+  for (auto it = m_tile_hash.cbegin(); it != m_tile_hash.cend(); ++it) {
+    QDebug debug = qInfo();
+    debug << it.key() << "--->";
+    for (QcMapViewLayer * layer : it.value())
+      debug << static_cast<void *>(layer);
+  }
+  for (auto it = m_layer_hash.cbegin(); it != m_layer_hash.cend(); ++it)
+    qInfo() << static_cast<void *>(it.key()) << "--->" << it.value();
+}
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -0,0 +1,119 @@
+// -*- mode: c++ -*-
+
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#ifndef __TILE_LAYER_INDEX_H__
+#define __TILE_LAYER_INDEX_H__
+
+/**************************************************************************************************/
+
+#include <algorithm>
+
+#include <QHash>
+#include <QVarLengthArray>
+
+#include "qtcarto_global.h"
+#include "wmts/tile_spec.h"
+
+/**************************************************************************************************/
+
+// QC_BEGIN_NAMESPACE
+
+/**************************************************************************************************/
+
+class QcMapViewLayer;
+
+/*! Small set of layers stored inline, a tile is usually requested by one or two layers.
+ */
+class QC_EXPORT QcMapViewLayerSmallSet : public QVarLengthArray<QcMapViewLayer *, 2>
+{
+ public:
+  inline bool contains(QcMapViewLayer * layer) const {
+    return std::find(constBegin(), constEnd(), layer) != constEnd();
+  }
+
+  // Return false if the layer is already in the set
+  bool insert(QcMapViewLayer * layer);
+  // Return false if the layer is not in the set
+  bool remove(QcMapViewLayer * layer);
+};
+
+/**************************************************************************************************/
+
+/*! Many-to-many index between tiles and map view layers.
+ *
+ * Both directions are updated in place: an update costs O(changed tiles) and the release of a
+ * layer costs O(tiles of the layer).
+ */
+class QC_EXPORT QcTileLayerIndex
+{
+ public:
+  QcTileLayerIndex();
+  ~QcTileLayerIndex();
+
+  // Return true if the tile was not requested before
+  bool add(QcMapViewLayer * layer, const QcTileSpec & tile_spec);
+  // Return true if the tile is no longer requested
+  bool remove(QcMapViewLayer * layer, const QcTileSpec & tile_spec);
+
+  // Remove a tile and return the layers which requested it
+  QcMapViewLayerSmallSet take_tile(const QcTileSpec & tile_spec);
+
+  // Remove a layer and return the tiles which are no longer requested
+  QcTileSpecSet release_layer(QcMapViewLayer * layer);
+
+  inline bool contains(const QcTileSpec & tile_spec) const { return m_tile_hash.contains(tile_spec); }
+  inline bool contains(QcMapViewLayer * layer) const { return m_layer_hash.contains(layer); }
+
+  QcMapViewLayerSmallSet layers(const QcTileSpec & tile_spec) const { return m_tile_hash.value(tile_spec); }
+  QcTileSpecSet tiles(QcMapViewLayer * layer) const { return m_layer_hash.value(layer); }
+
+  inline int number_of_tiles() const { return m_tile_hash.size(); }
+  inline int number_of_layers() const { return m_layer_hash.size(); }
+
+  void dump() const;
+
+ private:
+  QHash<QcTileSpec, QcMapViewLayerSmallSet> m_tile_hash;
+  QHash<QcMapViewLayer *, QcTileSpecSet> m_layer_hash;
+};
+
+/**************************************************************************************************/
+
+// QC_END_NAMESPACE
+
+/**************************************************************************************************/
+
+#endif /* __TILE_LAYER_INDEX_H__ */
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -90,6 +90,17 @@ QC_EXPORT QDebug operator<<(QDebug, const QcTileSpec & tile_spec);
 
 typedef QSet<QcTileSpec> QcTileSpecSet;
 
+// Tiles entering and leaving a tile set
+class QcTileSpecSetDiff
+{
+ public:
+  inline bool is_empty() const { return added.isEmpty() && removed.isEmpty(); }
+
+ public:
+  QcTileSpecSet added;
+  QcTileSpecSet removed;
+};
+
 // QC_END_NAMESPACE
 
 Q_DECLARE_METATYPE(QcTileSpec)
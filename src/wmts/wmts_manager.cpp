@@ -132,48 +132,10 @@ QcWmtsManager::tile_cache()
   return m_tile_cache;
 }
 
-void
-QcWmtsManager::remove_tile_spec(const QcTileSpec & tile_spec)
-{
-  // Remove tile_spec in sets
-
-  QcMapViewLayerPointerSet map_view_layers = m_tile_hash.value(tile_spec);
-
-  // Fixme: inplace update ?
-  for (auto map_view_layer : map_view_layers) {
-    QcTileSpecSet tile_set = m_map_view_layer_hash.value(map_view_layer);
-    tile_set.remove(tile_spec);
-    if (tile_set.isEmpty())
-      m_map_view_layer_hash.remove(map_view_layer);
-    else
-      m_map_view_layer_hash.insert(map_view_layer, tile_set);
-  }
-
-  m_tile_hash.remove(tile_spec);
-}
-
 void
 QcWmtsManager::release_map(QcMapViewLayer * map_view_layer)
 {
-  m_map_view_layer_hash.remove(map_view_layer);
-
-  // Update m_tile_hash
-  QHash<QcTileSpec, QcMapViewLayerPointerSet > new_tile_hash = m_tile_hash;
-  // for (auto & tile_spec : m_tile_hash.keys())
-  typedef QHash<QcTileSpec, QcMapViewLayerPointerSet >::const_iterator hash_iterator;
-  hash_iterator iter = m_tile_hash.constBegin();
-  hash_iterator iter_end = m_tile_hash.constEnd();
-  for (; iter != iter_end; ++iter) { // Fixme: cxx11
-    QcMapViewLayerPointerSet map_view_layers = iter.value();
-    if (map_view_layers.contains(map_view_layer)) {
-      map_view_layers.remove(map_view_layer);
-      if (map_view_layers.isEmpty())
-	new_tile_hash.remove(iter.key());
-      else
-	new_tile_hash.insert(iter.key(), map_view_layers); // Fixme: inplace update ?
-    }
-  }
-  m_tile_hash = new_tile_hash;
+  m_tile_layer_index.release_layer(map_view_layer);
 }
 
 void
@@ -181,43 +143,22 @@ QcWmtsManager::update_tile_requests(QcMapViewLayer * map_view_layer,
 				    const QcTileSpecSet & tiles_added,
 				    const QcTileSpecSet & tiles_removed)
 {
-  typedef QcTileSpecSet::const_iterator tile_iter;
-  tile_iter iter, iter_end;
-
-  // add and remove tiles from tileset for this map_view_layer
-  QcTileSpecSet old_tiles = m_map_view_layer_hash.value(map_view_layer);
-  old_tiles += tiles_added;
-  old_tiles -= tiles_removed;
-  m_map_view_layer_hash.insert(map_view_layer, old_tiles);
-
-  // add and remove map from mapset for the tiles
-
-  // Fixme: duplicated code, inplace update ?
+  // Update the tile <-> map view layer index in place
   QcTileSpecSet canceled_tiles;
-  for (auto & tile_spec : tiles_removed) {
-    QcMapViewLayerPointerSet map_view_layer_set = m_tile_hash.value(tile_spec);
-    map_view_layer_set.remove(map_view_layer);
-    if (map_view_layer_set.isEmpty()) {
-      m_tile_hash.remove(tile_spec);
+  for (const auto & tile_spec : tiles_removed)
+    if (m_tile_layer_index.remove(map_view_layer, tile_spec))
       canceled_tiles.insert(tile_spec);
-    } else {
-      m_tile_hash.insert(tile_spec, map_view_layer_set);
-    }
-  }
 
   QcTileSpecSet requested_tiles;
-  for (auto & tile_spec : tiles_added) {
-    QcMapViewLayerPointerSet map_view_layer_set = m_tile_hash.value(tile_spec);
-    if (map_view_layer_set.isEmpty()) {
+  for (const auto & tile_spec : tiles_added)
+    if (m_tile_layer_index.add(map_view_layer, tile_spec))
       requested_tiles.insert(tile_spec);
-    }
-    map_view_layer_set.insert(map_view_layer);
-    m_tile_hash.insert(tile_spec, map_view_layer_set);
-  }
 
   // Fixme: why ?
   canceled_tiles -= requested_tiles;
 
+  emit tile_requests_updated(requested_tiles, canceled_tiles);
+
   // async call
   // qInfo() << "async call update_tile_requests +" << requested_tiles << "-" << canceled_tiles;
   QMetaObject::invokeMethod(m_tile_fetcher, "update_tile_requests",
@@ -235,23 +176,24 @@ QcWmtsManager::fetcher_tile_finished(const QcTileSpec & tile_spec, const QByteAr
 {
   // qInfo();
   // Is tile requested by a map view ?
-  if (m_tile_hash.contains(tile_spec)) {
-    QcMapViewLayerPointerSet map_view_layers = m_tile_hash.value(tile_spec);
-    remove_tile_spec(tile_spec);
+  if (m_tile_layer_index.contains(tile_spec)) {
+    QcMapViewLayerSmallSet map_view_layers = m_tile_layer_index.take_tile(tile_spec);
     tile_cache()->insert(tile_spec, bytes, format);
     for (QcMapViewLayer * map_view_layer : map_view_layers)
       map_view_layer->request_manager()->tile_fetched(tile_spec);
+    emit tile_received(tile_spec, bytes.size(), true);
+  }
+  else {
+    // qInfo() << "any client" << tile_spec;
+    emit tile_received(tile_spec, bytes.size(), false);
   }
-  // else
-  //   qInfo() << "any client" << tile_spec;
 }
 
 void
 QcWmtsManager::fetcher_tile_error(const QcTileSpec & tile_spec, const QString & error_string)
 {
   // qInfo();
-  QcMapViewLayerPointerSet map_view_layers = m_tile_hash.value(tile_spec);
-  remove_tile_spec(tile_spec);
+  QcMapViewLayerSmallSet map_view_layers = m_tile_layer_index.take_tile(tile_spec);
 
   for (QcMapViewLayer * map_view_layer : map_view_layers)
     map_view_layer->request_manager()->tile_error(tile_spec, error_string);
@@ -265,14 +207,17 @@ QcWmtsManager::get_tile_texture(const QcTileSpec & tile_spec)
   return m_tile_cache->get(tile_spec);
 }
 
+QSharedPointer<QcTileTexture>
+QcWmtsManager::get_decoded_tile_texture(const QcTileSpec & tile_spec)
+{
+  return tile_cache()->get_texture(tile_spec);
+}
+
 void
 QcWmtsManager::dump() const
 {
   qInfo() << "Dump";
-  for (auto & tile_spec : m_tile_hash.keys())
-    qInfo() << tile_spec << "--->" << m_tile_hash[tile_spec];
-  for (auto & map_view_layer : m_map_view_layer_hash.keys())
-    qInfo() << map_view_layer << "--->" << m_map_view_layer_hash[map_view_layer];
+  m_tile_layer_index.dump();
 }
 
 /**************************************************************************************************/
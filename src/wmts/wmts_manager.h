@@ -77,6 +77,7 @@
 
 #include "cache/file_tile_cache.h"
 #include "qtcarto_global.h"
+#include "wmts/tile_layer_index.h"
 #include "wmts/wmts_tile_fetcher.h"
 // #include "map_view.h" // circular
 
@@ -85,7 +86,6 @@
 /**************************************************************************************************/
 
 class QcMapViewLayer;
-typedef QSet<QcMapViewLayer *> QcMapViewLayerPointerSet;
 
 /**************************************************************************************************/
 
@@ -122,6 +122,7 @@ class QC_EXPORT QcWmtsManager : public QObject
 			    const QcTileSpecSet & tiles_removed);
 
   QSharedPointer<QcTileTexture> get_tile_texture(const QcTileSpec & tile_spec);
+  QSharedPointer<QcTileTexture> get_decoded_tile_texture(const QcTileSpec & tile_spec);
 
   void dump() const;
 
@@ -134,22 +135,23 @@ class QC_EXPORT QcWmtsManager : public QObject
   void tile_error(const QcTileSpec & tile_spec, const QString & error_string);
   void tile_version_changed();
 
+  // Instrumentation, e.g. for benchmarks
+  void tile_requests_updated(const QcTileSpecSet & requested_tiles, const QcTileSpecSet & canceled_tiles);
+  void tile_received(const QcTileSpec & tile_spec, int number_of_bytes, bool requested);
+
   // protected:
  public:
   void set_tile_fetcher(QcWmtsTileFetcher * tile_fetcher);
   void set_tile_cache(QcFileTileCache * cache);
 
  private:
-  void remove_tile_spec(const QcTileSpec & tile_spec);
-
   Q_DISABLE_COPY(QcWmtsManager);
 
   friend class QcWmtsTileFetcher;
 
  private:
   QString m_plugin_name; // needed by cache directory
-  QHash<QcMapViewLayer *, QcTileSpecSet > m_map_view_layer_hash;
-  QHash<QcTileSpec, QcMapViewLayerPointerSet > m_tile_hash;
+  QcTileLayerIndex m_tile_layer_index;
   QcFileTileCache * m_tile_cache;
   QcWmtsTileFetcher * m_tile_fetcher;
 };
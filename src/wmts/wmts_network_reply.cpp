@@ -28,6 +28,13 @@
 
 #include "wmts/wmts_network_reply.h"
 
+#include "cache/tile_buffer_pool.h"
+
+#include <QtDebug>
+
+#include <limits>
+#include <utility>
+
 /**************************************************************************************************/
 
 QcWmtsNetworkReply::QcWmtsNetworkReply(QNetworkReply * reply,
@@ -35,17 +42,62 @@ QcWmtsNetworkReply::QcWmtsNetworkReply(QNetworkReply * reply,
                                        const QString & format)
   : QcWmtsReply(reply, tile_spec),
     m_format(format)
-{}
+{
+  connect(reply, SIGNAL(readyRead()),
+	  this, SLOT(read_payload()));
+}
 
 QcWmtsNetworkReply::~QcWmtsNetworkReply()
 {}
 
+/*! Read the available bytes in a buffer acquired from the tile buffer pool
+ *
+ * The buffer capacity is given by the Content-Length header, thus the payload is read without any
+ * reallocation.  The pool clamps this capacity, a larger or unknown payload grows the buffer as
+ * usual.
+ */
+void
+QcWmtsNetworkReply::read_payload()
+{
+  QNetworkReply * reply = network_reply();
+  if (!reply)
+    return;
+
+  if (reply->bytesAvailable() <= 0)
+    return;
+
+  if (!m_buffer.capacity()) {
+    bool ok = false;
+    qint64 content_length = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong(&ok);
+    m_buffer = QcTileBufferPool::instance().acquire(ok ? content_length : reply->bytesAvailable());
+  }
+
+  // Read by chunks, the available bytes are not bounded by an int
+  qint64 number_of_bytes;
+  while ((number_of_bytes = reply->bytesAvailable()) > 0) {
+    int size = m_buffer.size();
+    int chunk_size = static_cast<int>(qMin(number_of_bytes, qint64(QcTileBufferPool::MAXIMUM_BUFFER_CAPACITY)));
+    if (chunk_size > std::numeric_limits<int>::max() - size) {
+      qWarning() << "Tile payload is too large" << tile_spec();
+      reply->abort();
+      return;
+    }
+    m_buffer.resize(size + chunk_size);
+    qint64 number_of_read_bytes = reply->read(m_buffer.data() + size, chunk_size);
+    m_buffer.resize(size + static_cast<int>(qMax(number_of_read_bytes, qint64(0))));
+    if (number_of_read_bytes <= 0)
+      break;
+  }
+}
+
 /*! Handle a successful request : store image data
  */
 void
 QcWmtsNetworkReply::process_payload()
 {
-  set_map_image_data(network_reply()->readAll());
+  read_payload();
+  // Hand over the buffer, it is then shared by the caches and the decoder
+  set_map_image_data(std::move(m_buffer));
   set_map_image_format(m_format);
 }
 
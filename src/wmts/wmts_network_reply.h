@@ -55,8 +55,13 @@ public:
 
   void process_payload();
 
+private slots:
+  void read_payload();
+
 private:
   QString m_format;
+  QByteArray m_buffer; // preallocated from Content-Length
+
 };
 
 /**************************************************************************************************/
@@ -77,6 +77,8 @@
 #include <QObject>
 #include <QString>
 
+#include <utility>
+
 /**************************************************************************************************/
 
 // QC_BEGIN_NAMESPACE
@@ -97,13 +99,14 @@ class QC_EXPORT QcWmtsReply : public QcNetworkReply // QcNetworkFuture
   QcTileSpec tile_spec() const { return m_tile_spec; }
 
   //!   Returns the tile image data.
-  QByteArray map_image_data() const { return m_map_image_data; }
+  const QByteArray & map_image_data() const { return m_map_image_data; }
   // Returns the format of the tile image.
   QString map_image_format() const { return m_map_image_format; }
 
  protected:
   //! Sets the tile image data to \a data.
   void set_map_image_data(const QByteArray & data) { m_map_image_data = data; }
+  void set_map_image_data(QByteArray && data) { m_map_image_data = std::move(data); }
   //! Sets the format of the tile image to \a format.
   void set_map_image_format(const QString & format) { m_map_image_format = format; }
 
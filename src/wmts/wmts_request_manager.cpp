@@ -91,8 +91,14 @@ QcRetryFuture::retry()
 
 QcWmtsRequestManager::QcWmtsRequestManager(QcMapViewLayer * map_view_layer, QcWmtsManager * wmts_manager)
   : m_map_view_layer(map_view_layer),
-    m_wmts_manager(wmts_manager)
-{}
+    m_wmts_manager(wmts_manager),
+    m_abandoned_timer()
+{
+  m_abandoned_timer.setSingleShot(true);
+  m_abandoned_timer.setInterval(ABANDONED_TILE_RETRY_INTERVAL);
+  connect(&m_abandoned_timer, SIGNAL(timeout()),
+          this, SLOT(retry_abandoned_tiles()));
+}
 
 QcWmtsRequestManager::~QcWmtsRequestManager()
 {}
@@ -113,7 +119,58 @@ QcWmtsRequestManager::request_tiles(const QcTileSpecSet & tile_specs)
 
   QcTileSpecSet canceled_tiles = m_requested - tile_specs;
   QcTileSpecSet requested_tiles = tile_specs - m_requested;
+  m_deferred.intersect(tile_specs);
+  requested_tiles -= m_deferred;
+  m_abandoned.intersect(tile_specs);
+  requested_tiles -= m_abandoned;
+
+  return request(requested_tiles, canceled_tiles);
+}
+
+/*! Update the requests using the tiles entering and leaving the map view.
+ *
+ *  Contrary to request_tiles, the cost only depends on the number of changed tiles.
+ *
+ *  If deferred is set, the tiles missing from the caches are not fetched until
+ *  request_deferred_tiles is called, thus the levels passed during a zoom are never fetched.
+ *
+ *  It returns cached tile textures.
+ */
+QList<QSharedPointer<QcTileTexture> >
+QcWmtsRequestManager::update_tile_requests(const QcTileSpecSet & tiles_added, const QcTileSpecSet & tiles_removed,
+                                           bool deferred)
+{
+  QcTileSpecSet canceled_tiles;
+  for (const auto & tile_spec : tiles_removed) {
+    if (m_requested.contains(tile_spec))
+      canceled_tiles.insert(tile_spec);
+    m_deferred.remove(tile_spec);
+    m_abandoned.remove(tile_spec);
+  }
+
+  QcTileSpecSet requested_tiles;
+  for (const auto & tile_spec : tiles_added)
+    if (!m_requested.contains(tile_spec) and !m_deferred.contains(tile_spec) and !m_abandoned.contains(tile_spec))
+      requested_tiles.insert(tile_spec);
 
+  return request(requested_tiles, canceled_tiles, deferred);
+}
+
+/*! Fetch the tiles deferred by update_tile_requests.
+ *
+ *  It returns the textures cached in the meantime.
+ */
+QList<QSharedPointer<QcTileTexture> >
+QcWmtsRequestManager::request_deferred_tiles()
+{
+  QcTileSpecSet requested_tiles;
+  requested_tiles.swap(m_deferred);
+  return request(requested_tiles, QcTileSpecSet());
+}
+
+QList<QSharedPointer<QcTileTexture> >
+QcWmtsRequestManager::request(QcTileSpecSet & requested_tiles, const QcTileSpecSet & canceled_tiles, bool deferred)
+{
   // Remove tiles in cache from request tiles
   QcTileSpecSet cached_tiles;
   QList<QSharedPointer<QcTileTexture> > cached_textures;
@@ -128,6 +185,11 @@ QcWmtsRequestManager::request_tiles(const QcTileSpecSet & tile_specs)
   }
   requested_tiles -= cached_tiles;
 
+  if (deferred) {
+    m_deferred += requested_tiles;
+    requested_tiles.clear();
+  }
+
   m_requested -= canceled_tiles;
   m_requested += requested_tiles;
 
@@ -158,12 +220,15 @@ QcWmtsRequestManager::tile_fetched(const QcTileSpec & tile_spec)
   // qInfo();
   m_map_view_layer->update_tile(tile_spec);
   m_requested.remove(tile_spec);
+  m_abandoned.remove(tile_spec);
   m_retries.remove(tile_spec);
   m_futures.remove(tile_spec);
 }
 
 /*! Retry to fetch an errored tile request.
  *
+ * A tile is given up after MAXIMUM_NUMBER_OF_RETRIES errors, it is then kept in the abandoned set
+ * until it leaves the map view, and requested again by retry_abandoned_tiles.
  */
 void
 QcWmtsRequestManager::tile_error(const QcTileSpec & tile_spec, const QString & error_string)
@@ -173,13 +238,17 @@ QcWmtsRequestManager::tile_error(const QcTileSpec & tile_spec, const QString & e
     int count = m_retries.value(tile_spec, 0);
     m_retries.insert(tile_spec, count + 1);
 
-    if (count >= 5) {
-      qWarning("QcWmtsRequestManager: Failed to fetch tile (%d,%d,%d) 5 times, giving up. "
+    if (count >= MAXIMUM_NUMBER_OF_RETRIES) {
+      qWarning("QcWmtsRequestManager: Failed to fetch tile (%d,%d,%d) %d times, giving up for now. "
 	       "Last error message was: '%s'",
-           tile_spec.x(), tile_spec.y(), tile_spec.level(), qPrintable(error_string));
+               tile_spec.x(), tile_spec.y(), tile_spec.level(), MAXIMUM_NUMBER_OF_RETRIES,
+               qPrintable(error_string));
       m_requested.remove(tile_spec);
       m_retries.remove(tile_spec);
       m_futures.remove(tile_spec);
+      m_abandoned.insert(tile_spec);
+      if (!m_abandoned_timer.isActive())
+        m_abandoned_timer.start();
     } else {
       qDebug() << "Retry x" << count << tile_spec;
       // Exponential time backoff when retrying
@@ -192,6 +261,20 @@ QcWmtsRequestManager::tile_error(const QcTileSpec & tile_spec, const QString & e
   }
 }
 
+/*! Request again the abandoned tiles which are still visible.
+ *
+ */
+void
+QcWmtsRequestManager::retry_abandoned_tiles()
+{
+  if (m_abandoned.isEmpty() or m_wmts_manager.isNull())
+    return;
+
+  m_requested += m_abandoned;
+  m_wmts_manager->update_tile_requests(m_map_view_layer, m_abandoned, QcTileSpecSet());
+  m_abandoned.clear();
+}
+
 /*! Get the tile texture from the WTMS Manager cache.
  *
  */
@@ -204,6 +287,19 @@ QcWmtsRequestManager::tile_texture(const QcTileSpec & tile_spec)
     return QSharedPointer<QcTileTexture>();
 }
 
+/*! Get the tile texture from the texture tier of the WTMS Manager cache.
+ *
+ * It neither hits the disk nor decodes, thus it can be used to look for fallback tiles.
+ */
+QSharedPointer<QcTileTexture>
+QcWmtsRequestManager::decoded_tile_texture(const QcTileSpec & tile_spec)
+{
+  if (m_wmts_manager)
+    return m_wmts_manager->get_decoded_tile_texture(tile_spec);
+  else
+    return QSharedPointer<QcTileTexture>();
+}
+
 /**************************************************************************************************/
 
 // #include "wmts_request_manager.moc"
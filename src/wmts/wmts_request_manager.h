@@ -80,6 +80,7 @@
 #include <QSet>
 #include <QSharedPointer>
 #include <QSize>
+#include <QTimer>
 
 /**************************************************************************************************/
 
@@ -115,16 +116,36 @@ class QcWmtsRequestManager : public QObject
 {
   Q_OBJECT;
 
+ public:
+  static constexpr int MAXIMUM_NUMBER_OF_RETRIES = 5;
+  // Tiles given up after too many errors are requested again after this interval if they are still visible
+  static constexpr int ABANDONED_TILE_RETRY_INTERVAL = 60 * 1000; // ms
+
  public:
   explicit QcWmtsRequestManager(QcMapViewLayer * map_view_layer, QcWmtsManager * wmts_manager);
   ~QcWmtsRequestManager();
 
   QList<QSharedPointer<QcTileTexture> > request_tiles(const QcTileSpecSet & tile_specs);
+  QList<QSharedPointer<QcTileTexture> > update_tile_requests(const QcTileSpecSet & tiles_added,
+                                                             const QcTileSpecSet & tiles_removed,
+                                                             bool deferred = false);
+  // Fetch the tiles deferred during a zoom
+  QList<QSharedPointer<QcTileTexture> > request_deferred_tiles();
+  bool has_deferred_tiles() const { return !m_deferred.isEmpty(); }
 
   void tile_fetched(const QcTileSpec & tile_spec);
   void tile_error(const QcTileSpec & tile_spec, const QString & error_string);
 
   QSharedPointer<QcTileTexture> tile_texture(const QcTileSpec & tile_spec);
+  // Look only in the texture tier, thus nothing is decoded
+  QSharedPointer<QcTileTexture> decoded_tile_texture(const QcTileSpec & tile_spec);
+
+ private slots:
+  void retry_abandoned_tiles();
+
+ private:
+  QList<QSharedPointer<QcTileTexture> > request(QcTileSpecSet & requested_tiles, const QcTileSpecSet & canceled_tiles,
+                                                bool deferred = false);
 
  private:
   Q_DISABLE_COPY(QcWmtsRequestManager)
@@ -135,6 +156,9 @@ class QcWmtsRequestManager : public QObject
   QHash<QcTileSpec, int> m_retries;
   QHash<QcTileSpec, QSharedPointer<QcRetryFuture> > m_futures;
   QcTileSpecSet m_requested;
+  QcTileSpecSet m_deferred; // missing from the caches, not yet sent to the fetcher
+  QcTileSpecSet m_abandoned; // given up after too many errors, still visible
+  QTimer m_abandoned_timer;
 };
 
 // QC_END_NAMESPACE
@@ -68,11 +68,15 @@
 
 #include <QtDebug>
 
+#include <algorithm>
+
 /**************************************************************************************************/
 
 QcWmtsTileFetcher::QcWmtsTileFetcher()
   : QObject(),
-    m_enabled(true)
+    m_enabled(true),
+    m_maximum_number_of_requests(0),
+    m_request_rate(0)
 {
   // Fixme: useless ?
   // if (!m_queue.isEmpty())
@@ -82,6 +86,40 @@ QcWmtsTileFetcher::QcWmtsTileFetcher()
 QcWmtsTileFetcher::~QcWmtsTileFetcher()
 {}
 
+void
+QcWmtsTileFetcher::set_maximum_number_of_requests(int number_of_requests)
+{
+  QMutexLocker mutex_locker(&m_queue_mutex);
+  m_maximum_number_of_requests = qMax(number_of_requests, 0);
+  start_timer();
+}
+
+void
+QcWmtsTileFetcher::set_request_rate(double request_rate)
+{
+  QMutexLocker mutex_locker(&m_queue_mutex);
+  m_request_rate = qMax(request_rate, .0);
+  if (m_timer.isActive())
+    m_timer.stop();
+  start_timer();
+}
+
+bool
+QcWmtsTileFetcher::can_request() const
+{
+  return !m_maximum_number_of_requests || m_invmap.size() < m_maximum_number_of_requests;
+}
+
+void
+QcWmtsTileFetcher::start_timer()
+{
+  // The timer interval implements the rate limit
+  if (m_enabled && !m_queue.isEmpty() && can_request() && !m_timer.isActive()) {
+    int interval = m_request_rate > 0 ? qRound(1000. / m_request_rate) : 0;
+    m_timer.start(interval, this);
+  }
+}
+
 void
 QcWmtsTileFetcher::update_tile_requests(const QcTileSpecSet & tiles_added,
 					const QcTileSpecSet & tiles_removed)
@@ -96,14 +134,15 @@ QcWmtsTileFetcher::update_tile_requests(const QcTileSpecSet & tiles_added,
   m_queue += tiles_added.toList();
 
   // Start timer to fetch tiles from queue
-  if (m_enabled && !m_queue.isEmpty() && !m_timer.isActive()) {
-    m_timer.start(0, this);
-  }
+  start_timer();
 }
 
 void
 QcWmtsTileFetcher::cancel_tile_requests(const QcTileSpecSet & tiles)
 {
+  if (tiles.isEmpty())
+    return;
+
   // Delete objects and abort requests if they are still running
   for (const QcTileSpec & tile_spec: tiles) {
     QcWmtsReply * reply = m_invmap.value(tile_spec, nullptr);
@@ -113,9 +152,12 @@ QcWmtsTileFetcher::cancel_tile_requests(const QcTileSpecSet & tiles)
       if (reply->is_finished())
 	reply->deleteLater();
     }
-    // Fixme: else ?
-    m_queue.removeAll(tile_spec);
   }
+
+  // A zoom step cancels the whole level the user passed, thus the queue is filtered in one pass
+  auto end = std::remove_if(m_queue.begin(), m_queue.end(),
+                            [&tiles](const QcTileSpec & tile_spec) { return tiles.contains(tile_spec); });
+  m_queue.erase(end, m_queue.end());
 }
 
 void
@@ -128,6 +170,12 @@ QcWmtsTileFetcher::request_next_tile()
   if (!m_enabled || m_queue.isEmpty())
     return;
 
+  // Wait for a running request to finish
+  if (!can_request()) {
+    m_timer.stop();
+    return;
+  }
+
   QcTileSpec tile_spec = m_queue.takeFirst();
 
   // qInfo() << tile_spec;
@@ -169,6 +217,9 @@ QcWmtsTileFetcher::finished()
   m_invmap.remove(tile_spec);
 
   handle_reply(wmts_reply, tile_spec);
+
+  // A request slot is now free
+  start_timer();
 }
 
 void
@@ -103,6 +103,17 @@ class QC_EXPORT QcWmtsTileFetcher : public QObject
   QcWmtsTileFetcher();
   virtual ~QcWmtsTileFetcher();
 
+  // Maximum number of running requests, 0 means unbounded
+  inline int maximum_number_of_requests() const { return m_maximum_number_of_requests; }
+  void set_maximum_number_of_requests(int number_of_requests);
+
+  // Maximum number of requests issued per second, 0 means unlimited
+  inline double request_rate() const { return m_request_rate; }
+  void set_request_rate(double request_rate);
+
+  inline int number_of_running_requests() const { return m_invmap.size(); }
+  inline int number_of_queued_requests() const { return m_queue.size(); }
+
  public slots:
   // void update_tile_requests(const QcTileSpecSet & tiles_added, const QcTileSpecSet & tiles_removed);
   void update_tile_requests(const QSet<QcTileSpec> & tiles_added, const QSet<QcTileSpec> & tiles_removed);
@@ -122,6 +133,8 @@ class QC_EXPORT QcWmtsTileFetcher : public QObject
 
  private:
   virtual QcWmtsReply * get_tile_image(const QcTileSpec & tile_spec) = 0;
+  bool can_request() const;
+  void start_timer();
   void handle_reply(QcWmtsReply * wmts_reply, const QcTileSpec & tile_spec);
 
   // Q_DECLARE_PRIVATE(QcWmtsTileFetcher);
@@ -129,6 +142,8 @@ class QC_EXPORT QcWmtsTileFetcher : public QObject
 
  private:
   bool m_enabled;
+  int m_maximum_number_of_requests;
+  double m_request_rate;
   QBasicTimer m_timer;
   QMutex m_queue_mutex;
   QList<QcTileSpec> m_queue;
@@ -45,6 +45,7 @@ private slots:
 
 void TestQcOfflineCacheDatabase::constructor()
 {
+  QFile::remove("offline_cache.sqlite");
   QcOfflineCacheDatabase database("offline_cache.sqlite");
 
   QcTileSpec tile_spec("foo", 1, 1, 0, 0);
@@ -53,6 +54,18 @@ void TestQcOfflineCacheDatabase::constructor()
   QVERIFY(database.has_tile(tile_spec) == 1);
   database.insert_tile(tile_spec);
   QVERIFY(database.has_tile(tile_spec) == 2);
+
+  // The prepared queries are rebound for each tile
+  QcTileSpec other_tile_spec("foo", 1, 1, 0, 1);
+  QVERIFY(database.has_tile(other_tile_spec) == 0);
+  database.insert_tile(other_tile_spec);
+  QVERIFY(database.has_tile(other_tile_spec) == 1);
+
+  database.delete_tile(tile_spec);
+  QVERIFY(database.has_tile(tile_spec) == 1);
+  database.delete_tile(tile_spec);
+  QVERIFY(database.has_tile(tile_spec) == 0);
+  QVERIFY(database.has_tile(other_tile_spec) == 1);
 }
 
 /***************************************************************************************************/
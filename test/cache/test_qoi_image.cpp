@@ -0,0 +1,121 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+
+/**************************************************************************************************/
+
+#include "cache/qoi_image.h"
+
+/***************************************************************************************************/
+
+class TestQcQoiImage: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void round_trip();
+  void opaque_format();
+  void invalid();
+
+private:
+  static QImage make_image(bool translucent);
+};
+
+// Image exercising all the ops: runs, small and large differences, index hits and alpha changes
+QImage
+TestQcQoiImage::make_image(bool translucent)
+{
+  QImage image(64, 48, translucent ? QImage::Format_RGBA8888 : QImage::Format_RGBX8888);
+  for (int y = 0; y < image.height(); y++)
+    for (int x = 0; x < image.width(); x++) {
+      int alpha = translucent ? (x * 7 + y) % 256 : 255;
+      if (x < 8)
+        image.setPixelColor(x, y, QColor(10, 20, 30, translucent ? 255 : alpha));
+      else if (x < 24)
+        image.setPixelColor(x, y, QColor(x, x + 1, x + 2, alpha));
+      else if (x < 40)
+        image.setPixelColor(x, y, QColor((x * 37 + y * 11) % 256, (x * 13) % 256, (y * 29) % 256, alpha));
+      else
+        image.setPixelColor(x, y, QColor((x % 2) * 200, 50, 100, alpha));
+    }
+  return image;
+}
+
+void TestQcQoiImage::round_trip()
+{
+  for (bool translucent : {false, true}) {
+    QImage image = make_image(translucent);
+    QByteArray bytes = encode_qoi_image(image);
+    QVERIFY(is_qoi_image(bytes));
+    QCOMPARE(bytes.at(12), char(translucent ? 4 : 3)); // channels
+
+    QImage decoded_image = decode_qoi_image(bytes);
+    QCOMPARE(decoded_image.size(), image.size());
+    QCOMPARE(decoded_image.format(), translucent ? QImage::Format_RGBA8888 : QImage::Format_RGBX8888);
+    QCOMPARE(decoded_image, image);
+  }
+}
+
+void TestQcQoiImage::opaque_format()
+{
+  QImage image = make_image(false);
+  QByteArray bytes = encode_qoi_image(image);
+
+  QImage decoded_image = decode_qoi_image(bytes, QImage::Format_RGBA8888_Premultiplied);
+  QCOMPARE(decoded_image.format(), QImage::Format_RGBA8888_Premultiplied);
+  QCOMPARE(decoded_image.convertToFormat(QImage::Format_RGBX8888), image);
+
+  // A translucent image ignores it
+  bytes = encode_qoi_image(make_image(true));
+  QCOMPARE(decode_qoi_image(bytes, QImage::Format_RGBA8888_Premultiplied).format(), QImage::Format_RGBA8888);
+}
+
+void TestQcQoiImage::invalid()
+{
+  QVERIFY(!is_qoi_image(QByteArray("qoif")));
+  QVERIFY(decode_qoi_image(QByteArray("not a QOI image at all")).isNull());
+  QVERIFY(encode_qoi_image(QImage()).isEmpty());
+
+  // Truncated stream
+  QByteArray bytes = encode_qoi_image(make_image(false));
+  bytes.chop(bytes.size() / 2);
+  QVERIFY(decode_qoi_image(bytes).isNull());
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcQoiImage)
+#include "test_qoi_image.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -0,0 +1,243 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+
+#include <QDir>
+#include <QSet>
+#include <QSignalSpy>
+
+/**************************************************************************************************/
+
+#include "cache/file_tile_cache.h"
+#include "cache/tile_buffer_pool.h"
+#include "cache/tile_image.h"
+#include "map/map_view.h"
+#include "wmts/wmts_manager.h"
+
+#include "wmts_test_server.h"
+
+/***************************************************************************************************/
+
+// Count the copies of a payload by recording the address of its data at each stage
+class CopyCounter
+{
+public:
+  void record(const QByteArray & bytes) { m_addresses.insert(bytes.constData()); }
+  int number_of_copies() const { return m_addresses.size() - 1; }
+
+private:
+  QSet<const char *> m_addresses;
+};
+
+/***************************************************************************************************/
+
+class TestQcTileBufferPool: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void init();
+  void preallocation();
+  void clamped_capacity();
+  void reuse();
+  void shared_buffer();
+  void payload_path();
+
+  void receive_payload(const QcTileSpec & tile_spec, const QByteArray & bytes);
+
+private:
+  static void fill(QByteArray & buffer, int size, int chunk_size);
+
+private:
+  QcTileSpec m_received_tile_spec;
+  QByteArray m_received; // first payload emitted by the tile fetcher
+};
+
+void
+TestQcTileBufferPool::fill(QByteArray & buffer, int size, int chunk_size)
+{
+  // Fill the buffer like a network reply does
+  while (buffer.size() < size) {
+    int offset = buffer.size();
+    int number_of_bytes = qMin(chunk_size, size - offset);
+    buffer.resize(offset + number_of_bytes);
+    memset(buffer.data() + offset, offset % 256, number_of_bytes);
+  }
+}
+
+void
+TestQcTileBufferPool::receive_payload(const QcTileSpec & tile_spec, const QByteArray & bytes)
+{
+  if (m_received.isNull()) {
+    m_received_tile_spec = tile_spec;
+    m_received = bytes;
+  }
+}
+
+void TestQcTileBufferPool::init()
+{
+  QcTileBufferPool::instance().clear();
+  m_received_tile_spec = QcTileSpec();
+  m_received = QByteArray();
+}
+
+void TestQcTileBufferPool::preallocation()
+{
+  constexpr int size = 20000;
+  QByteArray buffer = QcTileBufferPool::instance().acquire(size);
+  QVERIFY(buffer.isEmpty());
+  QVERIFY(buffer.capacity() >= size);
+
+  CopyCounter counter;
+  counter.record(buffer);
+  fill(buffer, size, 1500);
+  counter.record(buffer);
+  QCOMPARE(buffer.size(), size);
+  QCOMPARE(counter.number_of_copies(), 0);
+}
+
+void TestQcTileBufferPool::clamped_capacity()
+{
+  // The Content-Length comes from the server, it is not trusted
+  QByteArray buffer = QcTileBufferPool::instance().acquire(qint64(1) << 40);
+  QVERIFY(buffer.isEmpty());
+  QVERIFY(buffer.capacity() >= QcTileBufferPool::MAXIMUM_BUFFER_CAPACITY);
+  QVERIFY(buffer.capacity() < 2 * QcTileBufferPool::MAXIMUM_BUFFER_CAPACITY);
+
+  // a larger payload grows the buffer
+  constexpr int size = 3 * QcTileBufferPool::MAXIMUM_BUFFER_CAPACITY / 2;
+  fill(buffer, size, 64 * 1024);
+  QCOMPARE(buffer.size(), size);
+}
+
+void TestQcTileBufferPool::reuse()
+{
+  QcTileBufferPool & pool = QcTileBufferPool::instance();
+
+  QByteArray buffer = pool.acquire(1000);
+  const char * address = buffer.constData();
+  fill(buffer, 1000, 1000);
+  pool.release(buffer);
+  QVERIFY(buffer.isNull());
+  QCOMPARE(pool.number_of_buffers(), 1);
+
+  // a smaller payload reuses the buffer
+  buffer = pool.acquire(500);
+  QVERIFY(buffer.isEmpty());
+  QCOMPARE(buffer.constData(), address);
+  QCOMPARE(pool.number_of_buffers(), 0);
+  QCOMPARE(pool.number_of_allocations(), 1);
+  QCOMPARE(pool.number_of_reuses(), 1);
+
+  // a larger payload doesn't
+  pool.release(buffer);
+  buffer = pool.acquire(2000);
+  QCOMPARE(pool.number_of_allocations(), 2);
+  QCOMPARE(pool.number_of_buffers(), 1);
+}
+
+void TestQcTileBufferPool::shared_buffer()
+{
+  QcTileBufferPool & pool = QcTileBufferPool::instance();
+
+  QByteArray buffer = pool.acquire(1000);
+  fill(buffer, 1000, 1000);
+  QByteArray holder = buffer;
+  // a buffer still in use is not recycled
+  pool.release(buffer);
+  QCOMPARE(pool.number_of_buffers(), 0);
+  QCOMPARE(holder.size(), 1000);
+}
+
+void TestQcTileBufferPool::payload_path()
+{
+  // A WMTS reply is read in a pooled buffer, then handed over by the fetcher to the manager which
+  // inserts it in the disk and memory tiers
+  constexpr int size = 30000;
+  QcWmtsTestServer server;
+  QVERIFY(server.start());
+  server.set_payload_size(size);
+
+  QcWmtsTestPlugin plugin(server.serverPort());
+  QcWmtsManager * wmts_manager = plugin.wmts_manager();
+  QcFileTileCache * file_tile_cache = wmts_manager->tile_cache();
+  file_tile_cache->clear_all();
+
+  connect(wmts_manager->tile_fetcher(), SIGNAL(tile_finished(const QcTileSpec &, const QByteArray &, const QString &)),
+          this, SLOT(receive_payload(const QcTileSpec &, const QByteArray &)));
+  QSignalSpy tile_received_spy(wmts_manager, SIGNAL(tile_received(const QcTileSpec &, int, bool)));
+
+  // A small map view requests a few tiles
+  QcMapView map_view;
+  map_view.set_zoom_settle_interval(0);
+  map_view.viewport()->set_viewport_size(QSize(256, 256), 1.);
+  map_view.viewport()->set_zoom_level(16);
+  map_view.add_layer(plugin.layers().first());
+  map_view.viewport()->set_center(QcWgsCoordinate(6., 45.));
+
+  QTRY_VERIFY_WITH_TIMEOUT(!m_received.isEmpty(), 10000);
+  auto received = [this, &tile_received_spy]() {
+    for (const auto & arguments : tile_received_spy)
+      if (arguments.at(0).value<QcTileSpec>() == m_received_tile_spec)
+        return true;
+    return false;
+  };
+  QTRY_VERIFY_WITH_TIMEOUT(received(), 10000);
+
+  // The buffer was preallocated from the Content-Length
+  QCOMPARE(m_received.size(), size);
+  QVERIFY(m_received.capacity() >= size);
+  QVERIFY(QcTileBufferPool::instance().number_of_allocations() + QcTileBufferPool::instance().number_of_reuses() > 0);
+
+  // The memory tier holds the buffer emitted by the fetcher
+  CopyCounter counter;
+  counter.record(m_received);
+  QByteArray bytes = file_tile_cache->memory_bytes(m_received_tile_spec);
+  QVERIFY(!bytes.isNull());
+  counter.record(bytes);
+  QCOMPARE(counter.number_of_copies(), 0);
+
+  QString directory = QcFileTileCache::base_cache_directory() + QDir::separator() + QcWmtsTestPlugin::PLUGIN_NAME;
+  QString filename = tile_spec_to_filename(m_received_tile_spec, QStringLiteral("png"), directory);
+  QTRY_VERIFY(QFile::exists(filename));
+  QVERIFY(read_tile_image(filename) == bytes);
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcTileBufferPool)
+#include "test_tile_buffer_pool.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -0,0 +1,90 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+
+/**************************************************************************************************/
+
+#include "geometry/path_pyramid.h"
+
+/***************************************************************************************************/
+
+class TestQcPathPyramid: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void levels();
+  void level_for_tolerance();
+
+private:
+  // A peak with two small bumps on each side
+  QcPathDouble m_path = QcPathDouble(QVector<double>({0, 0,  1, .2,  2, 0,  3, 5,  4, 0,  5, .2,  6, 0}));
+};
+
+void
+TestQcPathPyramid::levels()
+{
+  // Tolerances are 8, 4, 2, 1 and .5
+  QcPathPyramid pyramid(m_path, 8., 5);
+  QCOMPARE(pyramid.number_of_vertexes(), 7);
+  QCOMPARE(pyramid.number_of_levels(), 5);
+  QCOMPARE(pyramid.tolerance(3), 1.);
+
+  QCOMPARE(pyramid.level(0), QVector<int>({0, 6}));
+  QCOMPARE(pyramid.level(1), QVector<int>({0, 3, 6}));
+  QCOMPARE(pyramid.level(2), QVector<int>({0, 3, 6}));
+  QCOMPARE(pyramid.level(3), QVector<int>({0, 2, 3, 4, 6}));
+  // The bumps are lower than the finest tolerance
+  QCOMPARE(pyramid.level(4), QVector<int>({0, 2, 3, 4, 6}));
+}
+
+void
+TestQcPathPyramid::level_for_tolerance()
+{
+  QcPathPyramid pyramid(m_path, 8., 5);
+  QCOMPARE(pyramid.level_for_tolerance(100.), 0);
+  QCOMPARE(pyramid.level_for_tolerance(8.), 0);
+  QCOMPARE(pyramid.level_for_tolerance(5.), 1);
+  QCOMPARE(pyramid.level_for_tolerance(1.), 3);
+  QCOMPARE(pyramid.level_for_tolerance(.5), 4);
+  // Finer than the pyramid
+  QCOMPARE(pyramid.level_for_tolerance(.3), -1);
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcPathPyramid)
+#include "test_path_pyramid.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
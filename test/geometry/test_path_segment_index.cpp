@@ -0,0 +1,113 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+
+/**************************************************************************************************/
+
+#include "geometry/path_segment_index.h"
+
+/***************************************************************************************************/
+
+class TestQcPathSegmentIndex: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void query();
+  void closed_path();
+
+private:
+  // Horizontal line of 100 vertexes, thus 99 segments and 4 chunks
+  QVector<QcVectorDouble> m_vertexes;
+};
+
+void
+TestQcPathSegmentIndex::initTestCase()
+{
+  for (int i = 0; i < 100; i++)
+    m_vertexes << QcVectorDouble(i, 0);
+}
+
+void
+TestQcPathSegmentIndex::query()
+{
+  QcPathSegmentIndex index;
+  index.build(m_vertexes, false);
+  QCOMPARE(index.number_of_segments(), 99);
+  QCOMPARE(index.number_of_chunks(), 4);
+
+  QVector<QcIntervalInt> ranges;
+  index.query(QcInterval2DDouble(40, 50, -1, 1), ranges);
+  QCOMPARE(ranges, QVector<QcIntervalInt>({QcIntervalInt(32, 63)}));
+
+  // Adjacent chunks are merged
+  ranges.clear();
+  index.query(QcInterval2DDouble(60, 70, -1, 1), ranges);
+  QCOMPARE(ranges, QVector<QcIntervalInt>({QcIntervalInt(32, 95)}));
+
+  // The last vertex of a chunk belongs to the next one
+  ranges.clear();
+  index.query(QcInterval2DDouble(96, 200, -1, 1), ranges);
+  QCOMPARE(ranges, QVector<QcIntervalInt>({QcIntervalInt(64, 98)}));
+
+  ranges.clear();
+  index.query(QcInterval2DDouble(40, 50, 10, 20), ranges);
+  QVERIFY(ranges.isEmpty());
+
+  ranges.clear();
+  QVector<QcInterval2DDouble> intervals({QcInterval2DDouble(0, 1, -1, 1), QcInterval2DDouble(98, 99, -1, 1)});
+  index.query(intervals, ranges);
+  QCOMPARE(ranges, QVector<QcIntervalInt>({QcIntervalInt(0, 31), QcIntervalInt(96, 98)}));
+}
+
+void
+TestQcPathSegmentIndex::closed_path()
+{
+  QcPathSegmentIndex index;
+  index.build(m_vertexes, true);
+  QCOMPARE(index.number_of_segments(), 100);
+
+  // The closing segment goes back to the first vertex
+  QVector<QcIntervalInt> ranges;
+  index.query(QcInterval2DDouble(-.5, .5, -1, 1), ranges);
+  QCOMPARE(ranges, QVector<QcIntervalInt>({QcIntervalInt(0, 31), QcIntervalInt(96, 99)}));
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcPathSegmentIndex)
+#include "test_path_segment_index.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -41,6 +41,7 @@ class TestQcPolygon: public QObject
 private slots:
   void contains();
   void intersec_with_grid();
+  void diff();
 };
 
 void
@@ -111,6 +112,42 @@ TestQcPolygon::intersec_with_grid()
   }
 }
 
+void
+TestQcPolygon::diff()
+{
+  QcTiledPolygonRunList old_runs;
+  old_runs << QcTiledPolygonRun(0, QcIntervalInt(0, 3))
+           << QcTiledPolygonRun(1, QcIntervalInt(0, 1))
+           << QcTiledPolygonRun(1, QcIntervalInt(4, 8))
+           << QcTiledPolygonRun(2, QcIntervalInt(2, 5));
+
+  QcTiledPolygonRunList new_runs;
+  new_runs << QcTiledPolygonRun(1, QcIntervalInt(1, 5))
+           << QcTiledPolygonRun(1, QcIntervalInt(7, 7))
+           << QcTiledPolygonRun(2, QcIntervalInt(2, 5))
+           << QcTiledPolygonRun(3, QcIntervalInt(0, 2));
+
+  QcTiledPolygonDiff diff = QcTiledPolygon::diff(new_runs, old_runs);
+
+  QcTiledPolygonRunList new_area;
+  new_area << QcTiledPolygonRun(1, QcIntervalInt(2, 3))
+           << QcTiledPolygonRun(3, QcIntervalInt(0, 2));
+  QcTiledPolygonRunList old_area;
+  old_area << QcTiledPolygonRun(0, QcIntervalInt(0, 3))
+           << QcTiledPolygonRun(1, QcIntervalInt(0, 0))
+           << QcTiledPolygonRun(1, QcIntervalInt(6, 6))
+           << QcTiledPolygonRun(1, QcIntervalInt(8, 8));
+  QcTiledPolygonRunList same_area;
+  same_area << QcTiledPolygonRun(1, QcIntervalInt(1, 1))
+            << QcTiledPolygonRun(1, QcIntervalInt(4, 5))
+            << QcTiledPolygonRun(1, QcIntervalInt(7, 7))
+            << QcTiledPolygonRun(2, QcIntervalInt(2, 5));
+
+  QVERIFY(diff.new_area() == new_area);
+  QVERIFY(diff.old_area() == old_area);
+  QVERIFY(diff.same_area() == same_area);
+}
+
 /***************************************************************************************************/
 
 QTEST_MAIN(TestQcPolygon)
@@ -0,0 +1,142 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+
+/**************************************************************************************************/
+
+#include "geometry/tiled_corridor.h"
+#include "geo_data_format/route.h"
+
+/***************************************************************************************************/
+
+class TestQcTiledCorridor: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void horizontal_segment();
+  void merge_runs();
+  void clip();
+  void ground_radius();
+};
+
+void
+TestQcTiledCorridor::horizontal_segment()
+{
+  QcPathDouble path(QVector<double>({.5, .5, 4.5, .5}));
+  QcTiledCorridor corridor(path, .2, 1.);
+
+  QCOMPARE(corridor.runs().size(), 1);
+  QVERIFY(corridor.runs()[0] == QcTiledPolygonRun(0, QcIntervalInt(0, 4)));
+  QCOMPARE(corridor.number_of_tiles(), qint64(5));
+
+  // radius and vertexes are scaled by the grid step
+  QcPathDouble path_m(QVector<double>({50., 50., 450., 50.}));
+  QcTiledCorridor corridor_m(path_m, 20., 100.);
+  QVERIFY(corridor_m.runs() == corridor.runs());
+}
+
+void
+TestQcTiledCorridor::merge_runs()
+{
+  QcPathDouble path(QVector<double>({.5, .5, 2.5, .5, 2.5, 2.5}));
+  QcTiledCorridor corridor(path, .25, 1.);
+
+  QVector<int> run_data({
+      0, 0, 2,
+      1, 2, 2,
+      2, 2, 2,
+      });
+  QCOMPARE(corridor.runs().size(), run_data.size() / 3);
+  int i = 0;
+  for (const QcTiledPolygonRun & run: corridor.runs()) {
+    int j = 3*i;
+    QVERIFY(run == QcTiledPolygonRun(run_data[j], QcIntervalInt(run_data[j+1], run_data[j+2])));
+    i++;
+  }
+  QCOMPARE(corridor.number_of_tiles(), qint64(5));
+}
+
+void
+TestQcTiledCorridor::clip()
+{
+  QcPathDouble path(QVector<double>({.5, .5, 4.5, .5}));
+  QcTiledCorridor corridor(path, 1., 1.);
+
+  // rows -1 to 1, columns -1 to 5
+  QCOMPARE(corridor.number_of_tiles(), qint64(21));
+
+  corridor.clip(QcInterval2DInt(0, 4, 0, 4));
+  QCOMPARE(corridor.runs().size(), 2);
+  QVERIFY(corridor.runs()[0] == QcTiledPolygonRun(0, QcIntervalInt(0, 4)));
+  QVERIFY(corridor.runs()[1] == QcTiledPolygonRun(1, QcIntervalInt(0, 4)));
+  QCOMPARE(corridor.number_of_tiles(), qint64(10));
+}
+
+void
+TestQcTiledCorridor::ground_radius()
+{
+  // An eastward track at 60°N, where a ground metre is two Web Mercator metres
+  constexpr double latitude = 60.;
+  constexpr double radius = 1000.; // m
+  constexpr int level = 16;
+  QcMercatorTileMatrixSet tile_matrix_set(20, 256);
+  QcWayPointList segment;
+  for (int i = 0; i <= 10; i++) {
+    QcWayPoint waypoint;
+    waypoint.set_coordinate(QcWgsElevationCoordinate(6. + i * .01, latitude, 0));
+    segment << waypoint;
+  }
+  QcTrack track;
+  track.add_segment(segment);
+
+  QcVectorDouble vertex = segment.first().coordinate().transform(tile_matrix_set.projection());
+  QVERIFY(qAbs(QcCorridorTileSet::ground_scale(tile_matrix_set.projection(), vertex) - 2.) < 1e-3);
+
+  // The corridor covers the ground width, with at most a partial tile on each side
+  QcCorridorTileSet corridor_tile_set(tile_matrix_set, track, radius, QcIntervalInt(level, level));
+  QSet<int> rows;
+  for (const QcTiledPolygonRun & run : corridor_tile_set.level(level).runs())
+    rows << run.y();
+  double ground_tile_length = tile_matrix_set[level].tile_length_m() * std::cos(qDegreesToRadians(latitude));
+  double ground_width = rows.size() * ground_tile_length;
+  QVERIFY(ground_width >= 2 * radius);
+  QVERIFY(ground_width <= 2 * (radius + ground_tile_length));
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcTiledCorridor)
+#include "test_tiled_corridor.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
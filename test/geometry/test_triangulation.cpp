@@ -26,11 +26,14 @@
 
 /**************************************************************************************************/
 
+#include <algorithm>
+
 #include <QtDebug>
 #include <QtTest/QtTest>
 
 /**************************************************************************************************/
 
+#include "geometry/path.h"
 #include "geometry/polygon_seidler_triangulation.h"
 
 /***************************************************************************************************/
@@ -41,6 +44,8 @@ class TestQcTriangulation: public QObject
 
 private slots:
   void triangulation();
+  void polygon_triangulation();
+  void degenerated_polygon_triangulation();
 };
 
 void
@@ -70,6 +75,59 @@ TestQcTriangulation::triangulation()
   //   qInfo() << i << triangles[i][0] << triangles[i][1] << triangles[i][2];
 }
 
+static double
+triangles_area(const QcPolygonTriangulation & triangulation)
+{
+  double area = 0;
+  for (const auto & triangle : triangulation.triangle_vertexes())
+    area += .5 * qAbs((triangle.p2 - triangle.p1).cross(triangle.p3 - triangle.p1));
+  return area;
+}
+
+void
+TestQcTriangulation::polygon_triangulation()
+{
+  // Concave polygon, anticlockwise
+  QcPathDouble::VertexListType vertexes;
+  vertexes << QcVectorDouble(0, 0)
+           << QcVectorDouble(20, 0)
+           << QcVectorDouble(20, 20)
+           << QcVectorDouble(10, 5)
+           << QcVectorDouble(0, 20);
+  double area = 20*20 - .5*20*15;
+
+  QcPolygonTriangulation triangulation(QcPathDouble(vertexes, true));
+  QCOMPARE(triangulation.triangle_indexes().size(), 3);
+  QCOMPARE(triangles_area(triangulation), area);
+  QCOMPARE(triangulation.index_buffer().size(), 9);
+
+  // Same polygon, clockwise
+  std::reverse(vertexes.begin(), vertexes.end());
+  QcPolygonTriangulation clockwise_triangulation(QcPathDouble(vertexes, true));
+  QCOMPARE(clockwise_triangulation.triangle_indexes().size(), 3);
+  QCOMPARE(triangles_area(clockwise_triangulation), area);
+  for (quint16 index : clockwise_triangulation.index_buffer())
+    QVERIFY(index < vertexes.size());
+}
+
+void
+TestQcTriangulation::degenerated_polygon_triangulation()
+{
+  // Bow tie
+  QcPathDouble::VertexListType vertexes;
+  vertexes << QcVectorDouble(0, 0)
+           << QcVectorDouble(10, 10)
+           << QcVectorDouble(10, 0)
+           << QcVectorDouble(0, 10);
+  QVERIFY(QcPolygonTriangulation(QcPathDouble(vertexes, true)).is_empty());
+
+  // Segment
+  vertexes.clear();
+  vertexes << QcVectorDouble(0, 0)
+           << QcVectorDouble(10, 0);
+  QVERIFY(QcPolygonTriangulation(QcPathDouble(vertexes, true)).is_empty());
+}
+
 /***************************************************************************************************/
 
 QTEST_MAIN(TestQcTriangulation)
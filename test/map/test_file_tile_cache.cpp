@@ -29,9 +29,13 @@
 #include <QtTest/QtTest>
 #include <QtDebug>
 
+#include <QTemporaryDir>
+
 /**************************************************************************************************/
 
 #include "cache/file_tile_cache.h"
+#include "cache/qoi_image.h"
+#include "cache/tile_image.h"
 
 /***************************************************************************************************/
 
@@ -41,6 +45,8 @@ class TestQcFileTileCache: public QObject
 
 private slots:
   void constructor();
+  void decode_image();
+  void transcoding();
 };
 
 void TestQcFileTileCache::constructor()
@@ -61,6 +67,112 @@ void TestQcFileTileCache::constructor()
   QVERIFY(tile_texture->tile_spec == tile_spec);
 }
 
+static QByteArray
+encode_png(const QImage & image)
+{
+  QByteArray bytes;
+  QBuffer buffer(&bytes);
+  buffer.open(QIODevice::WriteOnly);
+  image.save(&buffer, "PNG");
+  return bytes;
+}
+
+void TestQcFileTileCache::decode_image()
+{
+  QImage opaque_image(16, 16, QImage::Format_RGB32);
+  opaque_image.fill(Qt::darkGreen);
+  QImage translucent_image(16, 16, QImage::Format_ARGB32);
+  translucent_image.fill(QColor(0, 0, 255, 128));
+
+  // Images are decoded to the formats uploaded by the tile atlas
+  QImage image = QcFileTileCache::decode_image(encode_png(opaque_image));
+  QCOMPARE(image.format(), QImage::Format_RGBA8888_Premultiplied);
+  QCOMPARE(image.pixelColor(0, 0), QColor(Qt::darkGreen));
+  QCOMPARE(QcFileTileCache::decode_image(encode_png(opaque_image), true).format(), QImage::Format_RGB16);
+  // The alpha channel is kept
+  QCOMPARE(QcFileTileCache::decode_image(encode_png(translucent_image), true).format(),
+           QImage::Format_RGBA8888_Premultiplied);
+
+  QVERIFY(QcFileTileCache::decode_image(QByteArray("not an image")).isNull());
+
+  // QOI images are decoded to the same formats
+  QCOMPARE(QcFileTileCache::decode_image(encode_qoi_image(opaque_image)).format(),
+           QImage::Format_RGBA8888_Premultiplied);
+  QCOMPARE(QcFileTileCache::decode_image(encode_qoi_image(opaque_image), true).format(), QImage::Format_RGB16);
+  image = QcFileTileCache::decode_image(encode_qoi_image(translucent_image), true);
+  QCOMPARE(image.format(), QImage::Format_RGBA8888_Premultiplied);
+  QCOMPARE(image.pixelColor(0, 0), QColor(0, 0, 255, 128));
+}
+
+void TestQcFileTileCache::transcoding()
+{
+  QTemporaryDir directory;
+  QcTileSpec tile_spec("geoportail", 1, 16, 33885, 23658);
+  QString filename = tile_spec_to_filename(tile_spec, QStringLiteral("qoi"), directory.path());
+
+  QString png_filename = tile_spec_to_filename(tile_spec, QStringLiteral("png"), directory.path());
+
+  QImage image(256, 256, QImage::Format_RGB32);
+  image.fill(Qt::darkGreen);
+  QByteArray png_bytes = encode_png(image);
+
+  {
+    QcFileTileCache file_tile_cache(directory.path());
+    file_tile_cache.set_transcoding_format(QcFileTileCache::QoiTranscoding);
+    // Each get decodes again
+    file_tile_cache.set_extra_texture_usage(0);
+    file_tile_cache.insert(tile_spec, png_bytes, QStringLiteral("png"));
+
+    for (int i = 0; i < QcFileTileCache::TRANSCODING_THRESHOLD - 1; i++)
+      QVERIFY(file_tile_cache.get(tile_spec));
+    QTest::qWait(100);
+    QVERIFY(!QFile::exists(filename));
+
+    // The hot tile is transcoded alongside the original
+    QVERIFY(file_tile_cache.get(tile_spec));
+    QTRY_VERIFY(file_tile_cache.contains_transcoded(tile_spec));
+    QVERIFY(QFile::exists(filename));
+    QVERIFY(QFile::exists(png_filename));
+    QSharedPointer<QcTileTexture> tile_texture = file_tile_cache.get(tile_spec);
+    QCOMPARE(tile_texture->image.pixelColor(0, 0), QColor(Qt::darkGreen));
+
+    // A texture miss reads the transcoded file, though the memory tier holds the original
+    QImage marked_image(256, 256, QImage::Format_RGB32);
+    marked_image.fill(Qt::darkBlue);
+    write_tile_image(filename, encode_qoi_image(marked_image));
+    tile_texture = file_tile_cache.get(tile_spec);
+    QCOMPARE(tile_texture->image.pixelColor(0, 0), QColor(Qt::darkBlue));
+    write_tile_image(filename, encode_qoi_image(image));
+
+    // The memory tier keeps the original bytes and the transcoded file is accounted on disk
+    QCOMPARE(file_tile_cache.memory_bytes(tile_spec), png_bytes);
+    QCOMPARE(file_tile_cache.disk_usage(), int(QFileInfo(png_filename).size() + QFileInfo(filename).size()));
+  }
+
+  // The transcoded file is found on reload and removed on clear
+  QcFileTileCache file_tile_cache(directory.path());
+  QVERIFY(file_tile_cache.contains_transcoded(tile_spec));
+  QSharedPointer<QcTileTexture> tile_texture = file_tile_cache.get(tile_spec);
+  QVERIFY(tile_texture);
+  QCOMPARE(tile_texture->image.format(), QImage::Format_RGBA8888_Premultiplied);
+  QVERIFY(file_tile_cache.memory_bytes(tile_spec).isEmpty());
+  file_tile_cache.clear_all();
+  QVERIFY(!file_tile_cache.contains_transcoded(tile_spec));
+  QVERIFY(!QFile::exists(filename));
+
+  // A transcoded file is removed when it is evicted from the disk tier
+  file_tile_cache.set_transcoding_format(QcFileTileCache::QoiTranscoding);
+  file_tile_cache.set_extra_texture_usage(0);
+  file_tile_cache.insert(tile_spec, png_bytes, QStringLiteral("png"));
+  for (int i = 0; i < QcFileTileCache::TRANSCODING_THRESHOLD; i++)
+    QVERIFY(file_tile_cache.get(tile_spec));
+  QTRY_VERIFY(file_tile_cache.contains_transcoded(tile_spec));
+  file_tile_cache.set_max_disk_usage(0);
+  QVERIFY(!file_tile_cache.contains_transcoded(tile_spec));
+  QVERIFY(!QFile::exists(filename));
+  QVERIFY(QFile::exists(png_filename));
+}
+
 /***************************************************************************************************/
 
 QTEST_MAIN(TestQcFileTileCache)
@@ -0,0 +1,147 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include <algorithm>
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+
+/**************************************************************************************************/
+
+#include "tools/frame_statistics.h"
+
+/***************************************************************************************************/
+
+class TestQcFrameStatistics: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void percentiles();
+  void rolling_window();
+  void layers();
+  void disabled();
+};
+
+void
+TestQcFrameStatistics::percentiles()
+{
+  QcStageStatistics statistics;
+  QCOMPARE(statistics.percentile(50), .0);
+
+  // 1 to 100 ms in random order
+  QVector<qint64> durations;
+  for (int i = 1; i <= 100; i++)
+    durations << i * 1000000;
+  std::reverse(durations.begin(), durations.end());
+  std::rotate(durations.begin(), durations.begin() + 37, durations.end());
+  for (qint64 duration : durations)
+    statistics.add_sample(duration);
+
+  QCOMPARE(statistics.count(), qint64(100));
+  QCOMPARE(statistics.percentile(50), 50.);
+  QCOMPARE(statistics.percentile(90), 90.);
+  QCOMPARE(statistics.percentile(99), 99.);
+  QCOMPARE(statistics.percentile(0), 1.);
+  QCOMPARE(statistics.maximum(), 100.);
+}
+
+void
+TestQcFrameStatistics::rolling_window()
+{
+  QcStageStatistics statistics;
+  for (int i = 0; i < QcStageStatistics::NUMBER_OF_SAMPLES; i++)
+    statistics.add_sample(100000000);
+  for (int i = 0; i < QcStageStatistics::NUMBER_OF_SAMPLES; i++)
+    statistics.add_sample(1000000);
+
+  // The slow samples left the window
+  QCOMPARE(statistics.number_of_samples(), int(QcStageStatistics::NUMBER_OF_SAMPLES));
+  QCOMPARE(statistics.count(), qint64(2 * QcStageStatistics::NUMBER_OF_SAMPLES));
+  QCOMPARE(statistics.maximum(), 1.);
+
+  statistics.clear();
+  QCOMPARE(statistics.number_of_samples(), 0);
+}
+
+void
+TestQcFrameStatistics::layers()
+{
+  QcFrameStatistics frame_statistics;
+  frame_statistics.set_enabled(true);
+
+  frame_statistics.add_sample(QcFrameStatistics::TextureUpload, QStringLiteral("osm"), 2000000);
+  frame_statistics.add_sample(QcFrameStatistics::TextureUpload, QStringLiteral("ortho"), 4000000);
+
+  QCOMPARE(frame_statistics.statistics(QcFrameStatistics::TextureUpload).count(), qint64(2));
+  QCOMPARE(frame_statistics.statistics(QcFrameStatistics::TextureUpload, QStringLiteral("osm")).maximum(), 2.);
+  QCOMPARE(frame_statistics.statistics(QcFrameStatistics::TextureUpload, QStringLiteral("ortho")).maximum(), 4.);
+
+  QVariantMap map = frame_statistics.to_variant_map();
+  QCOMPARE(map.size(), 3);
+  QVariantMap stage_map = map.value(QStringLiteral("texture_upload/ortho")).toMap();
+  QCOMPARE(stage_map.value(QStringLiteral("count")).toLongLong(), qint64(1));
+  QCOMPARE(stage_map.value(QStringLiteral("p50")).toDouble(), 4.);
+
+  frame_statistics.clear();
+  QVERIFY(frame_statistics.to_variant_map().isEmpty());
+}
+
+void
+TestQcFrameStatistics::disabled()
+{
+  QcFrameStatistics frame_statistics;
+  QVERIFY(!frame_statistics.is_enabled());
+
+  {
+    QcStageTimer timer(&frame_statistics, QcFrameStatistics::Frame);
+  }
+  QCOMPARE(frame_statistics.statistics(QcFrameStatistics::Frame).count(), qint64(0));
+
+  {
+    QcStageTimer timer(nullptr, QcFrameStatistics::Frame);
+  }
+
+  frame_statistics.set_enabled(true);
+  {
+    QcStageTimer timer(&frame_statistics, QcFrameStatistics::Frame);
+  }
+  QCOMPARE(frame_statistics.statistics(QcFrameStatistics::Frame).count(), qint64(1));
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcFrameStatistics)
+#include "test_frame_statistics.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -0,0 +1,183 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+
+#include <limits>
+
+/**************************************************************************************************/
+
+#include "map/map_view.h"
+#include "scene/map_scene.h"
+
+#include "wmts_test_server.h"
+
+/***************************************************************************************************/
+
+// The frames of the bit sets depend on the update history, thus the tiles are compared one by one
+static bool
+same_tiles(const QcTileBitSet & tiles1, const QcTileBitSet & tiles2)
+{
+  if (tiles1.level() != tiles2.level() or tiles1.count() != tiles2.count())
+    return false;
+  bool same = true;
+  tiles1.for_each([&tiles2, &same](int x, int y) {
+      if (!tiles2.contains(x, y))
+        same = false;
+    });
+  return same;
+}
+
+class TestQcMapView: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void parallel_preparation();
+  void preparation_benchmark_data();
+  void preparation_benchmark();
+
+private:
+  QcWmtsTestServer m_server;
+};
+
+void
+TestQcMapView::initTestCase()
+{
+  QVERIFY(m_server.start());
+}
+
+void
+TestQcMapView::parallel_preparation()
+{
+  QcWmtsTestPlugin plugin(m_server.serverPort());
+  QList<const QcWmtsPluginLayer *> plugin_layers = plugin.layers();
+  QVERIFY(plugin_layers.size() > 1);
+
+  QcMapView map_view;
+  map_view.set_zoom_settle_interval(0);
+  QcViewport * viewport = map_view.viewport();
+  viewport->set_viewport_size(QSize(1024, 768), 1.);
+  for (const auto * plugin_layer : plugin_layers)
+    map_view.add_layer(plugin_layer);
+
+  // Reference layers updated one after another
+  QList<QcMapLayerScene *> layer_scenes;
+  QList<QcMapViewLayer *> layers;
+  for (const auto * plugin_layer : plugin_layers) {
+    QcMapLayerScene * layer_scene = new QcMapLayerScene(plugin_layer, viewport);
+    layer_scenes << layer_scene;
+    layers << new QcMapViewLayer(plugin_layer, viewport, layer_scene);
+    layers.last()->set_zoom_settle_interval(0);
+  }
+
+  // Pan across the antimeridian, the viewport is then split in parts, and zoom
+  QList<QPair<double, int>> steps = {{6., 10}, {179.9, 10}, {-179.9, 12}, {6., 14}, {6.1, 14}, {6., 8}};
+  for (const auto & step : steps) {
+    viewport->set_zoom_level(step.second);
+    viewport->set_center(QcWgsCoordinate(step.first, 45.));
+    map_view.update_scene();
+    for (auto * layer : layers)
+      layer->update_scene();
+
+    for (int i = 0; i < plugin_layers.size(); i++) {
+      const QcTileBitSet & visible_tiles = map_view.get_layer(plugin_layers[i])->visible_tiles();
+      QCOMPARE(visible_tiles.level(), step.second);
+      QVERIFY(!visible_tiles.is_empty());
+      QVERIFY(same_tiles(visible_tiles, layers[i]->visible_tiles()));
+    }
+  }
+
+  qDeleteAll(layers);
+  qDeleteAll(layer_scenes);
+}
+
+void
+TestQcMapView::preparation_benchmark_data()
+{
+  QTest::addColumn<int>("threshold");
+  QTest::newRow("serial") << std::numeric_limits<int>::max();
+  QTest::newRow("parallel") << int(QcMapView::DEFAULT_PARALLEL_PREPARATION_THRESHOLD);
+}
+
+/* Compare the duration of prepare_layers with the ViewLayerPreparation stage, the duration of each
+ * layer preparation.  The parallel path pays off when the update is shorter than the sum of the
+ * layers.
+ */
+void
+TestQcMapView::preparation_benchmark()
+{
+  QFETCH(int, threshold);
+
+  QcWmtsTestPlugin plugin(m_server.serverPort());
+  QcMapView map_view;
+  QcViewport * viewport = map_view.viewport();
+  viewport->set_viewport_size(QSize(1920, 1080), 1.);
+  viewport->set_zoom_level(14);
+  viewport->set_center(QcWgsCoordinate(6.0, 45.0));
+  for (const auto * plugin_layer : plugin.layers())
+    map_view.add_layer(plugin_layer);
+  map_view.set_parallel_preparation_threshold(threshold);
+  map_view.update_scene();
+
+  QcFrameStatistics * statistics = map_view.frame_statistics();
+  statistics->set_enabled(true);
+  statistics->clear();
+
+  // Pan back and forth over several tiles
+  constexpr int number_of_updates = QcStageStatistics::NUMBER_OF_SAMPLES / 2;
+  QElapsedTimer timer;
+  qint64 elapsed = 0;
+  for (int i = 0; i < number_of_updates; i++) {
+    viewport->pan((i / 20) % 2 ? -64 : 64, 0);
+    timer.start();
+    map_view.prepare_layers();
+    elapsed += timer.nsecsElapsed();
+    map_view.commit_layers(QcViewport::TranslationChange);
+  }
+
+  QcStageStatistics stage = statistics->statistics(QcFrameStatistics::ViewLayerPreparation);
+  QCOMPARE(stage.count(), qint64(number_of_updates * plugin.layers().size()));
+  qInfo() << QTest::currentDataTag()
+          << "prepare_layers mean" << elapsed / number_of_updates / 1e6 << "ms,"
+          << QcFrameStatistics::stage_name(QcFrameStatistics::ViewLayerPreparation)
+          << "p50" << stage.percentile(50) << "ms p90" << stage.percentile(90) << "ms";
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcMapView)
+#include "test_map_view.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -0,0 +1,179 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+
+#include <cstdlib>
+
+/**************************************************************************************************/
+
+#include "map/map_view.h"
+#include "scene/map_scene.h"
+
+#include "wmts_test_server.h"
+
+/***************************************************************************************************/
+
+/* Count the heap allocations of the current thread between begin and end.
+ *
+ * The allocator is interposed using the glibc entry points, thus the count covers the allocations
+ * done by Qt and by the standard library.
+ */
+#if defined(__GLIBC__)
+
+extern "C" {
+  void * __libc_malloc(size_t size);
+  void * __libc_calloc(size_t number, size_t size);
+  void * __libc_realloc(void * pointer, size_t size);
+}
+
+static thread_local bool s_counting = false;
+static thread_local int s_number_of_allocations = 0;
+
+extern "C" void *
+malloc(size_t size)
+{
+  if (s_counting)
+    s_number_of_allocations++;
+  return __libc_malloc(size);
+}
+
+extern "C" void *
+calloc(size_t number, size_t size)
+{
+  if (s_counting)
+    s_number_of_allocations++;
+  return __libc_calloc(number, size);
+}
+
+extern "C" void *
+realloc(void * pointer, size_t size)
+{
+  if (s_counting)
+    s_number_of_allocations++;
+  return __libc_realloc(pointer, size);
+}
+
+class AllocationCounter
+{
+ public:
+  AllocationCounter() { s_number_of_allocations = 0; s_counting = true; }
+  ~AllocationCounter() { s_counting = false; }
+
+  int number_of_allocations() const { return s_number_of_allocations; }
+};
+
+#endif
+
+/***************************************************************************************************/
+
+class TestQcMapViewAllocation: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void steady_pan();
+
+private:
+  QcWmtsTestServer m_server;
+};
+
+void
+TestQcMapViewAllocation::initTestCase()
+{
+  QVERIFY(m_server.start());
+}
+
+void
+TestQcMapViewAllocation::steady_pan()
+{
+#if !defined(__GLIBC__)
+  QSKIP("The allocator can only be interposed on glibc");
+#else
+  QcWmtsTestPlugin plugin(m_server.serverPort());
+  const QcWmtsPluginLayer * plugin_layer = plugin.layers().first();
+
+  QcMapView map_view;
+  QcViewport * viewport = map_view.viewport();
+  viewport->set_viewport_size(QSize(1024, 768), 1.);
+  viewport->set_zoom_level(14);
+  viewport->set_center(QcWgsCoordinate(6.0, 45.0));
+  map_view.add_layer(plugin_layer);
+  QcMapViewLayer * layer = map_view.get_layer(plugin_layer);
+  map_view.update_scene();
+
+  // Sum of the tile columns, it changes when the viewport crosses a tile
+  auto tile_checksum = [layer]() {
+    int checksum = 0;
+    layer->visible_tiles().for_each([&checksum](int x, int y) { checksum += x; Q_UNUSED(y); });
+    return checksum;
+  };
+
+  /* Pan back and forth over four tiles by steps of a quarter tile, the first round trip enlarges the
+   * scratch buffers.  The preparation must then not allocate, even when tiles enter and leave the
+   * viewport, the commit creates the tile specs and updates the requests.
+   */
+  constexpr int number_of_steps = 16;
+  constexpr double step = 64; // px
+  int number_of_changes = 0;
+  for (int round_trip = 0; round_trip < 2; round_trip++) {
+    for (int i = 0; i < 2 * number_of_steps; i++) {
+      int checksum = tile_checksum();
+      viewport->pan(i < number_of_steps ? step : -step, 0);
+      int number_of_allocations = 0;
+      {
+        AllocationCounter counter;
+        map_view.prepare_layers();
+        number_of_allocations = counter.number_of_allocations();
+      }
+      map_view.commit_layers(QcViewport::TranslationChange);
+      if (round_trip) {
+        QCOMPARE(number_of_allocations, 0);
+        if (tile_checksum() != checksum)
+          number_of_changes++;
+      }
+    }
+  }
+  // The viewport crossed several tiles
+  QVERIFY(number_of_changes >= 4);
+#endif
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcMapViewAllocation)
+#include "test_map_view_allocation.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
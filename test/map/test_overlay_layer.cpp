@@ -0,0 +1,209 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+
+/**************************************************************************************************/
+
+#include "map/overlay_layer.h"
+
+/***************************************************************************************************/
+
+static QcPathDouble
+make_path(int number_of_segments, double y = 0)
+{
+  QcPathDouble::VertexListType vertexes;
+  for (int i = 0; i <= number_of_segments; i++)
+    vertexes << QcVectorDouble(i * 10, y);
+  return QcPathDouble(vertexes);
+}
+
+class TestQcOverlayLayer: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void add_path();
+  void remove_path();
+  void split_path();
+  void markers();
+  void style();
+  void clear();
+};
+
+void
+TestQcOverlayLayer::add_path()
+{
+  QcOverlayLayer layer;
+  QSignalSpy spy(&layer, &QcOverlayLayer::changed);
+
+  int path1 = layer.add_path(make_path(2));
+  int path2 = layer.add_path(make_path(1, 100));
+  QVERIFY(path1 != path2);
+  QCOMPARE(layer.number_of_items(), 2);
+  QCOMPARE(spy.count(), 2);
+
+  // Both paths share the same chunk
+  QCOMPARE(layer.path_chunks().size(), 1);
+  const QcOverlayPathChunk & chunk = layer.path_chunks().first();
+  QCOMPARE(chunk.vertexes.size(), 3 * QcOverlayLayer::NUMBER_OF_SEGMENT_VERTEXES);
+  QCOMPARE(chunk.indexes.size(), 3 * QcOverlayLayer::NUMBER_OF_SEGMENT_INDEXES);
+  QCOMPARE(int(chunk.indexes.last()), 3 * QcOverlayLayer::NUMBER_OF_SEGMENT_VERTEXES - 1);
+
+  // Vertexes are relative to the origin, y axis pointing down
+  QCOMPARE(chunk.vertexes[2].x, 10.f);
+  QCOMPARE(chunk.vertexes[8].y, -100.f);
+
+  // A single vertex has no segment
+  QcPathDouble::VertexListType vertexes;
+  vertexes << QcVectorDouble(0, 0);
+  layer.add_path(QcPathDouble(vertexes));
+  QCOMPARE(layer.path_chunks().first().vertexes.size(), 3 * QcOverlayLayer::NUMBER_OF_SEGMENT_VERTEXES);
+}
+
+void
+TestQcOverlayLayer::remove_path()
+{
+  QcOverlayLayer layer;
+  int path1 = layer.add_path(make_path(2));
+  int path2 = layer.add_path(make_path(1));
+  int revision = layer.path_chunks().first().revision;
+
+  // Triangles of the removed path are degenerated
+  layer.remove(path2);
+  QVERIFY(!layer.contains(path2));
+  const QcOverlayPathChunk & chunk = layer.path_chunks().first();
+  QVERIFY(chunk.revision != revision);
+  QCOMPARE(chunk.vertexes.size(), 3 * QcOverlayLayer::NUMBER_OF_SEGMENT_VERTEXES);
+  for (int i = 2 * QcOverlayLayer::NUMBER_OF_SEGMENT_INDEXES; i < chunk.indexes.size(); i++)
+    QCOMPARE(int(chunk.indexes[i]), 0);
+
+  // The chunk is compacted when half of it is free
+  int path3 = layer.add_path(make_path(1));
+  layer.remove(path1);
+  const QcOverlayPathChunk & compacted_chunk = layer.path_chunks().first();
+  QCOMPARE(compacted_chunk.number_of_free_vertexes, 0);
+  QCOMPARE(compacted_chunk.vertexes.size(), QcOverlayLayer::NUMBER_OF_SEGMENT_VERTEXES);
+  QCOMPARE(int(compacted_chunk.indexes.last()), QcOverlayLayer::NUMBER_OF_SEGMENT_VERTEXES - 1);
+  QVERIFY(layer.contains(path3));
+
+  layer.clear();
+  QCOMPARE(layer.number_of_items(), 0);
+  QVERIFY(layer.path_chunks().isEmpty());
+}
+
+void
+TestQcOverlayLayer::split_path()
+{
+  constexpr int number_of_chunk_segments = QcOverlayLayer::CHUNK_SIZE / QcOverlayLayer::NUMBER_OF_SEGMENT_VERTEXES;
+
+  QcOverlayLayer layer;
+  int path = layer.add_path(make_path(number_of_chunk_segments + 10));
+  QCOMPARE(layer.path_chunks().size(), 2);
+  QCOMPARE(layer.path_chunks()[0].vertexes.size(), int(QcOverlayLayer::CHUNK_SIZE));
+  QCOMPARE(layer.path_chunks()[1].vertexes.size(), 10 * QcOverlayLayer::NUMBER_OF_SEGMENT_VERTEXES);
+
+  layer.remove(path);
+  for (const QcOverlayPathChunk & chunk : layer.path_chunks())
+    QVERIFY(chunk.vertexes.isEmpty());
+}
+
+void
+TestQcOverlayLayer::markers()
+{
+  QcOverlayLayer layer;
+  int marker1 = layer.add_marker(QcVectorDouble(100, 100));
+  layer.add_marker(QcVectorDouble(110, 90));
+  QCOMPARE(layer.marker_chunks().size(), 1);
+  const QcOverlayMarkerChunk & chunk = layer.marker_chunks().first();
+  QCOMPARE(chunk.vertexes.size(), 2);
+  QCOMPARE(chunk.vertexes[1].x, 10.f);
+  QCOMPARE(chunk.vertexes[1].y, 10.f);
+
+  // The slot of a removed marker is reused
+  layer.remove(marker1);
+  QCOMPARE(int(layer.marker_chunks().first().vertexes[0].size), 0);
+  layer.add_marker(QcVectorDouble(0, 0));
+  QCOMPARE(layer.marker_chunks().first().vertexes.size(), 2);
+  QVERIFY(layer.marker_chunks().first().vertexes[0].size > 0);
+}
+
+void
+TestQcOverlayLayer::style()
+{
+  QcOverlayLayer layer;
+  int path = layer.add_path(make_path(2));
+  int marker = layer.add_marker(QcVectorDouble(0, 0));
+
+  QcOverlayStyle style(QColor(255, 0, 0), 10, 20);
+  layer.set_style(path, style);
+  layer.set_style(marker, style);
+  QCOMPARE(layer.style(path).colour, QColor(255, 0, 0));
+
+  for (const QcOverlayPathVertex & vertex : layer.path_chunks().first().vertexes) {
+    QCOMPARE(int(vertex.r), 255);
+    QCOMPARE(int(vertex.b), 0);
+    QCOMPARE(int(vertex.half_width), 5 * 16);
+  }
+  // The segment vertexes are kept
+  QCOMPARE(layer.path_chunks().first().vertexes[6].x, 20.f);
+
+  const QcOverlayMarkerVertex & vertex = layer.marker_chunks().first().vertexes.first();
+  QCOMPARE(int(vertex.radius), 20);
+  QCOMPARE(int(vertex.r), 255);
+}
+
+void
+TestQcOverlayLayer::clear()
+{
+  QcOverlayLayer layer;
+  layer.add_path(make_path(2));
+  layer.add_marker(QcVectorDouble(0, 0));
+  int path_revision = layer.path_chunks().first().revision;
+  int marker_revision = layer.marker_chunks().first().revision;
+
+  // The same edits after a clear must give new revisions, else the scene graph keeps the old chunks
+  layer.clear();
+  layer.add_path(make_path(2, 100));
+  layer.add_marker(QcVectorDouble(10, 10));
+  QVERIFY(layer.path_chunks().first().revision != path_revision);
+  QVERIFY(layer.marker_chunks().first().revision != marker_revision);
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcOverlayLayer)
+#include "test_overlay_layer.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
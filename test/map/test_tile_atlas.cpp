@@ -0,0 +1,274 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+
+/**************************************************************************************************/
+
+#include "scene/tile_atlas.h"
+
+/***************************************************************************************************/
+
+static QcTileSpec
+make_tile_spec(int x)
+{
+  return QcTileSpec(QStringLiteral("test"), 1, 10, x, 0);
+}
+
+class TestQcTileAtlas: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void slot_allocation();
+  void eviction();
+  void page_growth();
+  void page_release();
+  void upload_budget();
+  void sixteen_bit_pages();
+  void format_change();
+
+private:
+  // 2 x 2 slots per page, thus 16 slots
+  static constexpr int TILE_SIZE = 30;
+  static constexpr int PAGE_SIZE = 64;
+  static constexpr int NUMBER_OF_SLOTS = 4 * QcTileAtlas::MAXIMUM_NUMBER_OF_PAGES;
+
+  QImage m_image = QImage(TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+};
+
+void
+TestQcTileAtlas::initTestCase()
+{
+  m_image.fill(Qt::darkGreen);
+}
+
+void
+TestQcTileAtlas::slot_allocation()
+{
+  QcTileAtlas atlas(TILE_SIZE, PAGE_SIZE);
+  atlas.begin_frame();
+
+  QVERIFY(atlas.insert(make_tile_spec(0), m_image));
+  QVERIFY(atlas.insert(make_tile_spec(1), m_image));
+  QCOMPARE(atlas.number_of_pages(), 1);
+
+  // Texture coordinates exclude the border of the slot
+  const QcTileAtlasSlot * slot0 = atlas.use(make_tile_spec(0));
+  const QcTileAtlasSlot * slot1 = atlas.use(make_tile_spec(1));
+  QVERIFY(slot0 and slot1);
+  QCOMPARE(slot0->page, slot1->page);
+  QCOMPARE(slot0->texture_rect, QRectF(1. / PAGE_SIZE, 1. / PAGE_SIZE, double(TILE_SIZE) / PAGE_SIZE, double(TILE_SIZE) / PAGE_SIZE));
+  QVERIFY(!slot0->texture_rect.intersects(slot1->texture_rect));
+  QVERIFY(slot1->page->has_pending_uploads());
+
+  // A removed slot is reused
+  atlas.remove(make_tile_spec(1));
+  QVERIFY(!atlas.contains(make_tile_spec(1)));
+  QVERIFY(atlas.insert(make_tile_spec(2), m_image));
+  QCOMPARE(atlas.number_of_tiles(), 2);
+  QCOMPARE(atlas.number_of_pages(), 1);
+}
+
+void
+TestQcTileAtlas::eviction()
+{
+  QcTileAtlas atlas(TILE_SIZE, PAGE_SIZE);
+  atlas.begin_frame();
+
+  for (int i = 0; i < NUMBER_OF_SLOTS; i++)
+    QVERIFY(atlas.insert(make_tile_spec(i), m_image));
+  QCOMPARE(atlas.number_of_pages(), int(QcTileAtlas::MAXIMUM_NUMBER_OF_PAGES));
+
+  // Slots used during the current frame are never evicted
+  QVERIFY(!atlas.insert(make_tile_spec(NUMBER_OF_SLOTS), m_image));
+
+  // Next frame, only the first half of the tiles is still visible
+  atlas.begin_frame();
+  for (int i = 0; i < NUMBER_OF_SLOTS / 2; i++)
+    QVERIFY(atlas.use(make_tile_spec(i)));
+  for (int i = 0; i < NUMBER_OF_SLOTS / 2; i++)
+    QVERIFY(atlas.insert(make_tile_spec(NUMBER_OF_SLOTS + i), m_image));
+  QCOMPARE(atlas.number_of_tiles(), int(NUMBER_OF_SLOTS));
+  for (int i = 0; i < NUMBER_OF_SLOTS / 2; i++) {
+    QVERIFY(atlas.contains(make_tile_spec(i)));
+    QVERIFY(!atlas.contains(make_tile_spec(NUMBER_OF_SLOTS / 2 + i)));
+  }
+}
+
+void
+TestQcTileAtlas::page_growth()
+{
+  QcTileAtlas atlas(TILE_SIZE, PAGE_SIZE);
+
+  // The tiles of a frame fit in a page, the tiles of the previous frames are evicted
+  for (int frame = 0; frame < 4; frame++) {
+    atlas.begin_frame();
+    for (int i = 0; i < 4; i++)
+      QVERIFY(atlas.insert(make_tile_spec(4 * frame + i), m_image));
+    QCOMPARE(atlas.number_of_pages(), 1);
+    QCOMPARE(atlas.number_of_tiles(), 4);
+  }
+
+  // A page is opened when the tiles of a frame don't fit
+  atlas.begin_frame();
+  for (int i = 0; i < 5; i++)
+    QVERIFY(atlas.insert(make_tile_spec(100 + i), m_image));
+  QCOMPARE(atlas.number_of_pages(), 2);
+}
+
+void
+TestQcTileAtlas::page_release()
+{
+  QcTileAtlas atlas(TILE_SIZE, PAGE_SIZE);
+  atlas.begin_frame();
+  for (int i = 0; i < 8; i++)
+    QVERIFY(atlas.insert(make_tile_spec(i), m_image));
+  QCOMPARE(atlas.number_of_pages(), 2);
+  const QcTileAtlasPage * first_page = atlas.use(make_tile_spec(0))->page;
+
+  // Only the tiles of the first page are drawn
+  for (int frame = 0; frame <= QcTileAtlas::PAGE_RELEASE_AGE; frame++) {
+    atlas.begin_frame();
+    for (int i = 0; i < 4; i++)
+      QVERIFY(atlas.use(make_tile_spec(i)));
+    atlas.release_unused_pages();
+  }
+  QCOMPARE(atlas.number_of_pages(), 1);
+  QCOMPARE(atlas.released_pages().size(), 1);
+  QCOMPARE(atlas.number_of_tiles(), 4);
+  QCOMPARE(atlas.use(make_tile_spec(0))->page, first_page);
+  for (int i = 4; i < 8; i++)
+    QVERIFY(!atlas.contains(make_tile_spec(i)));
+  atlas.delete_released_pages();
+  QVERIFY(atlas.released_pages().isEmpty());
+
+  // The free slots of the released page are not reused
+  atlas.begin_frame();
+  for (int i = 0; i < 4; i++)
+    QVERIFY(atlas.insert(make_tile_spec(10 + i), m_image));
+  for (int i = 0; i < 4; i++)
+    QCOMPARE(atlas.use(make_tile_spec(10 + i))->page, first_page);
+}
+
+void
+TestQcTileAtlas::upload_budget()
+{
+  QcTileAtlas atlas(TILE_SIZE, PAGE_SIZE);
+  // A slot image is 32 x 32 RGBA pixels
+  int slot_bytes = (TILE_SIZE + 2) * (TILE_SIZE + 2) * 4;
+  atlas.set_upload_budget(2 * slot_bytes);
+  atlas.begin_frame();
+
+  QVERIFY(atlas.has_upload_budget());
+  QVERIFY(atlas.insert(make_tile_spec(0), m_image));
+  QVERIFY(atlas.has_upload_budget());
+  QVERIFY(atlas.insert(make_tile_spec(1), m_image));
+  QVERIFY(!atlas.has_upload_budget());
+
+  // The budget is renewed on each frame
+  atlas.begin_frame();
+  QVERIFY(atlas.has_upload_budget());
+}
+
+void
+TestQcTileAtlas::sixteen_bit_pages()
+{
+  QImage image_16_bit = m_image.convertToFormat(QImage::Format_RGB16);
+  QCOMPARE(QcTileAtlas::upload_format(image_16_bit), QImage::Format_RGB16);
+  QCOMPARE(QcTileAtlas::upload_format(m_image), QImage::Format_RGBA8888_Premultiplied);
+
+  QcTileAtlas atlas(TILE_SIZE, PAGE_SIZE);
+  // Budget of a 32-bit slot, thus two 16-bit slots
+  int slot_bytes = (TILE_SIZE + 2) * (TILE_SIZE + 2) * 4;
+  atlas.set_upload_budget(slot_bytes);
+  atlas.begin_frame();
+
+  QVERIFY(atlas.insert(make_tile_spec(0), image_16_bit));
+  QVERIFY(atlas.has_upload_budget());
+  QVERIFY(atlas.insert(make_tile_spec(1), image_16_bit));
+  QVERIFY(!atlas.has_upload_budget());
+
+  // A page only stores a format
+  QVERIFY(atlas.insert(make_tile_spec(2), m_image));
+  QCOMPARE(atlas.number_of_pages(), 2);
+  const QcTileAtlasSlot * slot0 = atlas.use(make_tile_spec(0));
+  QCOMPARE(slot0->page->format(), QImage::Format_RGB16);
+  QVERIFY(!slot0->page->hasAlphaChannel());
+  const QcTileAtlasSlot * slot2 = atlas.use(make_tile_spec(2));
+  QCOMPARE(slot2->page->format(), QImage::Format_RGBA8888_Premultiplied);
+  QVERIFY(slot2->page->hasAlphaChannel());
+
+  // A tile inserted again in another format moves to a page of this format
+  QVERIFY(atlas.insert(make_tile_spec(0), m_image));
+  QCOMPARE(atlas.use(make_tile_spec(0))->page->format(), QImage::Format_RGBA8888_Premultiplied);
+  QCOMPARE(atlas.number_of_tiles(), 3);
+  QCOMPARE(atlas.number_of_pages(), 2);
+}
+
+void
+TestQcTileAtlas::format_change()
+{
+  QImage image_16_bit = m_image.convertToFormat(QImage::Format_RGB16);
+  QcTileAtlas atlas(TILE_SIZE, PAGE_SIZE);
+
+  // All the pages store 32-bit tiles
+  atlas.begin_frame();
+  for (int i = 0; i < NUMBER_OF_SLOTS; i++)
+    QVERIFY(atlas.insert(make_tile_spec(i), m_image));
+  QCOMPARE(atlas.number_of_pages(), int(QcTileAtlas::MAXIMUM_NUMBER_OF_PAGES));
+
+  // Pages used during the current frame are never released
+  QVERIFY(!atlas.insert(make_tile_spec(NUMBER_OF_SLOTS), image_16_bit));
+
+  // Next frame, the tiles switch to 16-bit, the least recently used page is released for them
+  atlas.begin_frame();
+  for (int i = 4; i < NUMBER_OF_SLOTS; i++)
+    QVERIFY(atlas.use(make_tile_spec(i)));
+  QVERIFY(atlas.insert(make_tile_spec(NUMBER_OF_SLOTS), image_16_bit));
+  QCOMPARE(atlas.use(make_tile_spec(NUMBER_OF_SLOTS))->page->format(), QImage::Format_RGB16);
+  QCOMPARE(atlas.number_of_pages(), int(QcTileAtlas::MAXIMUM_NUMBER_OF_PAGES));
+  QCOMPARE(atlas.released_pages().size(), 1);
+  for (int i = 0; i < 4; i++)
+    QVERIFY(!atlas.contains(make_tile_spec(i)));
+  atlas.delete_released_pages();
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcTileAtlas)
+#include "test_tile_atlas.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
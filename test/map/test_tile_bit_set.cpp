@@ -0,0 +1,196 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+
+/**************************************************************************************************/
+
+#include "wmts/tile_bit_set.h"
+
+/***************************************************************************************************/
+
+typedef QPair<int, int> Tile;
+
+static QSet<Tile>
+to_set(const QcTileBitSet & tile_set)
+{
+  QSet<Tile> tiles;
+  tile_set.for_each([&tiles](int x, int y) { tiles.insert(Tile(x, y)); });
+  return tiles;
+}
+
+class TestQcTileBitSet: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void insert();
+  void runs();
+  void wrap();
+  void union_and_difference();
+  void different_frames();
+};
+
+void
+TestQcTileBitSet::insert()
+{
+  QcTileBitSet tile_set;
+  QVERIFY(tile_set.is_null());
+  QVERIFY(!tile_set.contains(0, 0));
+
+  tile_set.set_frame(10, 1024, 100, 200, 50, 10);
+  QVERIFY(tile_set.is_empty());
+  tile_set.insert(100, 50);
+  tile_set.insert(299, 59);
+  tile_set.insert(163, 55);
+  tile_set.insert(164, 55);
+  QCOMPARE(tile_set.count(), 4);
+  QVERIFY(tile_set.contains(163, 55));
+  QVERIFY(!tile_set.contains(165, 55));
+  QVERIFY(!tile_set.contains(300, 59)); // out of the frame
+  QVERIFY(tile_set.contains(QcTileSpec(QStringLiteral("test"), 1, 10, 100, 50)));
+  QVERIFY(!tile_set.contains(QcTileSpec(QStringLiteral("test"), 1, 11, 100, 50)));
+
+  QSet<Tile> expected = {Tile(100, 50), Tile(163, 55), Tile(164, 55), Tile(299, 59)};
+  QCOMPARE(to_set(tile_set), expected);
+
+  tile_set.remove(163, 55);
+  QVERIFY(!tile_set.contains(163, 55));
+  QCOMPARE(tile_set.count(), 3);
+
+  tile_set.clear();
+  QVERIFY(tile_set.is_empty());
+}
+
+void
+TestQcTileBitSet::runs()
+{
+  QcTileBitSet tile_set;
+  tile_set.set_frame(10, 1024, 10, 300, 0, 2);
+
+  // Runs spanning several words
+  tile_set.insert(QcTiledPolygonRun(0, QcIntervalInt(20, 200)));
+  tile_set.insert(QcTiledPolygonRun(1, QcIntervalInt(73, 73)));
+  QCOMPARE(tile_set.count(), 182);
+  QVERIFY(!tile_set.contains(19, 0));
+  QVERIFY(tile_set.contains(20, 0));
+  QVERIFY(tile_set.contains(200, 0));
+  QVERIFY(!tile_set.contains(201, 0));
+  QVERIFY(tile_set.contains(73, 1));
+
+  QVERIFY(tile_set.frame_contains(QcTiledPolygonRun(1, QcIntervalInt(10, 309))));
+  QVERIFY(!tile_set.frame_contains(QcTiledPolygonRun(1, QcIntervalInt(10, 310))));
+}
+
+void
+TestQcTileBitSet::wrap()
+{
+  // Frame crossing the antimeridian
+  QcTileBitSet tile_set;
+  tile_set.set_frame(4, 16, 14, 4, 0, 1);
+  QVERIFY(tile_set.frame_contains(15, 0));
+  QVERIFY(tile_set.frame_contains(1, 0));
+  QVERIFY(!tile_set.frame_contains(2, 0));
+  QVERIFY(!tile_set.frame_contains(13, 0));
+  QVERIFY(!tile_set.frame_contains(QcTiledPolygonRun(0, QcIntervalInt(1, 15))));
+
+  tile_set.insert(QcTiledPolygonRun(0, QcIntervalInt(14, 15)));
+  tile_set.insert(QcTiledPolygonRun(0, QcIntervalInt(0, 1)));
+  QSet<Tile> expected = {Tile(14, 0), Tile(15, 0), Tile(0, 0), Tile(1, 0)};
+  QCOMPARE(to_set(tile_set), expected);
+}
+
+void
+TestQcTileBitSet::union_and_difference()
+{
+  QcTileBitSet tile_set1;
+  tile_set1.set_frame(10, 1024, 0, 128, 0, 4);
+  QcTileBitSet tile_set2;
+  tile_set2.set_frame(tile_set1);
+  QVERIFY(tile_set1.has_same_frame(tile_set2));
+  QVERIFY(tile_set1 == tile_set2);
+
+  for (int y = 0; y < 4; y++) {
+    tile_set1.insert(QcTiledPolygonRun(y, QcIntervalInt(0, 99)));
+    tile_set2.insert(QcTiledPolygonRun(y, QcIntervalInt(50, 127)));
+  }
+  QVERIFY(tile_set1 != tile_set2);
+
+  QcTileBitSet tile_set;
+  tile_set.assign(tile_set1);
+  QVERIFY(tile_set == tile_set1);
+  tile_set |= tile_set2;
+  QCOMPARE(tile_set.count(), 4 * 128);
+
+  tile_set.assign(tile_set1);
+  tile_set -= tile_set2;
+  QCOMPARE(tile_set.count(), 4 * 50);
+  QVERIFY(tile_set.contains(49, 3));
+  QVERIFY(!tile_set.contains(50, 3));
+}
+
+void
+TestQcTileBitSet::different_frames()
+{
+  QcTileBitSet tile_set1;
+  tile_set1.set_frame(10, 1024, 0, 100, 0, 1);
+  tile_set1.insert(QcTiledPolygonRun(0, QcIntervalInt(0, 99)));
+  QcTileBitSet tile_set2;
+  tile_set2.set_frame(10, 1024, 50, 100, 0, 1);
+  tile_set2.insert(QcTiledPolygonRun(0, QcIntervalInt(50, 149)));
+
+  QcTileBitSet tile_set;
+  tile_set.assign(tile_set1);
+  tile_set -= tile_set2;
+  QCOMPARE(tile_set.count(), 50);
+  QVERIFY(!tile_set.contains(50, 0));
+
+  // Tiles outside the frame are dropped
+  tile_set |= tile_set2;
+  QCOMPARE(tile_set.count(), 100);
+
+  // Levels don't mix
+  QcTileBitSet tile_set3;
+  tile_set3.set_frame(11, 2048, 0, 100, 0, 1);
+  tile_set3.insert(QcTiledPolygonRun(0, QcIntervalInt(0, 99)));
+  tile_set -= tile_set3;
+  QCOMPARE(tile_set.count(), 100);
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcTileBitSet)
+#include "test_tile_bit_set.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
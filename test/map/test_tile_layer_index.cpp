@@ -0,0 +1,141 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+
+/**************************************************************************************************/
+
+#include "wmts/tile_layer_index.h"
+
+/***************************************************************************************************/
+
+class TestQcTileLayerIndex: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void small_set();
+  void add_remove();
+  void take_tile();
+  void release_layer();
+};
+
+// Layers are only used as keys
+static QcMapViewLayer * layer1 = reinterpret_cast<QcMapViewLayer *>(0x10);
+static QcMapViewLayer * layer2 = reinterpret_cast<QcMapViewLayer *>(0x20);
+static QcMapViewLayer * layer3 = reinterpret_cast<QcMapViewLayer *>(0x30);
+
+void
+TestQcTileLayerIndex::small_set()
+{
+  QcMapViewLayerSmallSet layers;
+  QVERIFY(layers.insert(layer1));
+  QVERIFY(!layers.insert(layer1));
+  QVERIFY(layers.insert(layer2));
+  QVERIFY(layers.insert(layer3)); // spill out of the inline storage
+  QCOMPARE(layers.size(), 3);
+  QVERIFY(layers.remove(layer1));
+  QVERIFY(!layers.remove(layer1));
+  QVERIFY(layers.contains(layer2));
+  QVERIFY(layers.contains(layer3));
+  QCOMPARE(layers.size(), 2);
+}
+
+void
+TestQcTileLayerIndex::add_remove()
+{
+  QcTileLayerIndex index;
+  QcTileSpec tile_spec1("test", 1, 16, 1, 1);
+  QcTileSpec tile_spec2("test", 1, 16, 2, 2);
+
+  QVERIFY(index.add(layer1, tile_spec1)); // new tile
+  QVERIFY(!index.add(layer2, tile_spec1)); // already requested
+  QVERIFY(!index.add(layer1, tile_spec1));
+  QVERIFY(index.add(layer2, tile_spec2));
+  QCOMPARE(index.number_of_tiles(), 2);
+  QCOMPARE(index.layers(tile_spec1).size(), 2);
+  QCOMPARE(index.tiles(layer2), QcTileSpecSet({tile_spec1, tile_spec2}));
+
+  QVERIFY(!index.remove(layer1, tile_spec1)); // still requested by layer2
+  QVERIFY(!index.contains(layer1));
+  QVERIFY(!index.remove(layer1, tile_spec2)); // not requested by layer1
+  QVERIFY(index.remove(layer2, tile_spec1));
+  QVERIFY(!index.contains(tile_spec1));
+  QCOMPARE(index.tiles(layer2), QcTileSpecSet({tile_spec2}));
+}
+
+void
+TestQcTileLayerIndex::take_tile()
+{
+  QcTileLayerIndex index;
+  QcTileSpec tile_spec1("test", 1, 16, 1, 1);
+  QcTileSpec tile_spec2("test", 1, 16, 2, 2);
+  index.add(layer1, tile_spec1);
+  index.add(layer2, tile_spec1);
+  index.add(layer2, tile_spec2);
+
+  QcMapViewLayerSmallSet layers = index.take_tile(tile_spec1);
+  QCOMPARE(layers.size(), 2);
+  QVERIFY(layers.contains(layer1) and layers.contains(layer2));
+  QVERIFY(!index.contains(tile_spec1));
+  QVERIFY(!index.contains(layer1));
+  QCOMPARE(index.tiles(layer2), QcTileSpecSet({tile_spec2}));
+  QVERIFY(index.take_tile(tile_spec1).isEmpty());
+}
+
+void
+TestQcTileLayerIndex::release_layer()
+{
+  QcTileLayerIndex index;
+  QcTileSpec tile_spec1("test", 1, 16, 1, 1);
+  QcTileSpec tile_spec2("test", 1, 16, 2, 2);
+  QcTileSpec tile_spec3("test", 1, 16, 3, 3);
+  index.add(layer1, tile_spec1);
+  index.add(layer1, tile_spec2);
+  index.add(layer2, tile_spec2);
+  index.add(layer2, tile_spec3);
+
+  QcTileSpecSet orphan_tiles = index.release_layer(layer2);
+  QCOMPARE(orphan_tiles, QcTileSpecSet({tile_spec3}));
+  QVERIFY(!index.contains(layer2));
+  QCOMPARE(index.number_of_tiles(), 2);
+  QCOMPARE(index.layers(tile_spec2).size(), 1);
+  QCOMPARE(index.number_of_layers(), 1);
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcTileLayerIndex)
+#include "test_tile_layer_index.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
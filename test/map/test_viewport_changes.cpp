@@ -0,0 +1,135 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+
+/**************************************************************************************************/
+
+#include "coordinate/mercator.h"
+#include "earth.h"
+#include "map/viewport.h"
+
+/***************************************************************************************************/
+
+class TestQcViewportChanges: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void init();
+  void cleanup();
+  void queued_flush();
+  void frame_driven();
+
+private:
+  QcViewport * m_viewport = nullptr;
+  QList<QcViewport::ChangeFlags> m_changes;
+};
+
+void
+TestQcViewportChanges::init()
+{
+  int tile_size = 256;
+  QcTiledZoomLevel tiled_zoom_level(EQUATORIAL_PERIMETER, tile_size, 0);
+  QcViewportState viewport_state(QcWgsCoordinate(0, 0), tiled_zoom_level, 0);
+  m_viewport = new QcViewport(viewport_state, QSize(0, 0));
+  m_viewport->set_projection(&QcWebMercatorCoordinate::cls_projection);
+  m_viewport->set_zoom_level_interval(QcIntervalInt(0, 20), tile_size);
+  m_viewport->set_viewport_size(QSize(1024, 768), 1.);
+  m_viewport->zoom_at(QcWgsCoordinate(2.3491, 48.8533), 10);
+  QCoreApplication::processEvents(); // flush the initial state
+
+  m_changes.clear();
+  connect(m_viewport, &QcViewport::viewport_changed,
+          [this](QcViewport::ChangeFlags changes) { m_changes << changes; });
+}
+
+void
+TestQcViewportChanges::cleanup()
+{
+  delete m_viewport;
+  m_viewport = nullptr;
+}
+
+void
+TestQcViewportChanges::queued_flush()
+{
+  // Several changes between two event loop iterations are notified once
+  for (int i = 0; i < 10; i++)
+    m_viewport->pan(10, 0);
+  m_viewport->set_bearing(10);
+  QVERIFY(m_changes.isEmpty());
+  QCOMPARE(m_viewport->pending_changes(), QcViewport::TranslationChange | QcViewport::BearingChange);
+
+  QCoreApplication::processEvents();
+  QCOMPARE(m_changes.size(), 1);
+  QCOMPARE(m_changes.first(), QcViewport::TranslationChange | QcViewport::BearingChange);
+  QCOMPARE(m_viewport->pending_changes(), QcViewport::ChangeFlags(QcViewport::NoChange));
+
+  m_viewport->set_zoom_level(12);
+  QCoreApplication::processEvents();
+  QCOMPARE(m_changes.size(), 2);
+  QCOMPARE(m_changes.last(), QcViewport::ChangeFlags(QcViewport::ZoomChange));
+}
+
+void
+TestQcViewportChanges::frame_driven()
+{
+  int number_of_frame_requests = 0;
+  connect(m_viewport, &QcViewport::frame_requested,
+          [&number_of_frame_requests]() { number_of_frame_requests++; });
+  m_viewport->set_frame_driven(true);
+
+  // One frame is requested for the first change, the flush is left to the frame
+  for (int i = 0; i < 10; i++)
+    m_viewport->pan(0, 10);
+  m_viewport->set_viewport_size(QSize(800, 600), 1.);
+  QCoreApplication::processEvents();
+  QCOMPARE(number_of_frame_requests, 1);
+  QVERIFY(m_changes.isEmpty());
+
+  m_viewport->flush_changes();
+  QCOMPARE(m_changes.size(), 1);
+  QCOMPARE(m_changes.first(), QcViewport::TranslationChange | QcViewport::SizeChange);
+
+  // Nothing changed during this frame
+  m_viewport->flush_changes();
+  QCOMPARE(m_changes.size(), 1);
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcViewportChanges)
+#include "test_viewport_changes.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
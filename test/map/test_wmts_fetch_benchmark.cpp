@@ -0,0 +1,249 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+
+#include <algorithm>
+
+/**************************************************************************************************/
+
+#include "map/map_view.h"
+#include "wmts/wmts_manager.h"
+
+#include "wmts_test_server.h"
+
+/***************************************************************************************************/
+
+/* Collect fetch statistics from the WMTS manager instrumentation signals.
+ *
+ * The time to visible of a tile is the time between its request to the fetcher and its reception
+ * by the manager, which adds it to the map view layers.  Wasted bytes are the bytes of tiles
+ * received after their cancellation.
+ */
+class FetchStatistics : public QObject
+{
+  Q_OBJECT
+
+ public:
+  FetchStatistics(QcWmtsManager * wmts_manager)
+  {
+    connect(wmts_manager, &QcWmtsManager::tile_requests_updated,
+            this, &FetchStatistics::tile_requests_updated);
+    connect(wmts_manager, &QcWmtsManager::tile_received,
+            this, &FetchStatistics::tile_received);
+    m_clock.start();
+  }
+
+  int number_of_pending_tiles() const { return m_request_time.size(); }
+  const QSet<int> & requested_levels() const { return m_requested_levels; }
+
+  void report(const QString & name) const
+  {
+    QVector<qint64> times = m_time_to_visible;
+    std::sort(times.begin(), times.end());
+    auto percentile = [&times](double p) -> qint64 {
+      return times.isEmpty() ? 0 : times[qRound((times.size() - 1) * p)];
+    };
+    double elapsed = m_last_reception_time / 1000.;
+    double tile_rate = elapsed > 0 ? m_number_of_tiles / elapsed : 0;
+    qInfo().noquote()
+      << name << ":"
+      << QStringLiteral("%1 tiles in %2 s, %3 tiles/s").arg(m_number_of_tiles).arg(elapsed).arg(tile_rate, 0, 'f', 1)
+      << QStringLiteral("time to visible p50 %1 ms p99 %2 ms").arg(percentile(.5)).arg(percentile(.99))
+      << QStringLiteral("wasted %1 tiles %2 bytes").arg(m_number_of_wasted_tiles).arg(m_number_of_wasted_bytes);
+  }
+
+ public slots:
+  void tile_requests_updated(const QcTileSpecSet & requested_tiles, const QcTileSpecSet & canceled_tiles)
+  {
+    qint64 now = m_clock.elapsed();
+    for (const QcTileSpec & tile_spec : requested_tiles) {
+      if (!m_request_time.contains(tile_spec))
+        m_request_time.insert(tile_spec, now);
+      m_requested_levels.insert(tile_spec.level());
+    }
+    for (const QcTileSpec & tile_spec : canceled_tiles)
+      m_request_time.remove(tile_spec);
+  }
+
+  void tile_received(const QcTileSpec & tile_spec, int number_of_bytes, bool requested)
+  {
+    m_last_reception_time = m_clock.elapsed();
+    if (requested) {
+      m_number_of_tiles++;
+      if (m_request_time.contains(tile_spec))
+        m_time_to_visible << m_last_reception_time - m_request_time.take(tile_spec);
+    } else {
+      m_number_of_wasted_tiles++;
+      m_number_of_wasted_bytes += number_of_bytes;
+    }
+  }
+
+ private:
+  QElapsedTimer m_clock;
+  QHash<QcTileSpec, qint64> m_request_time;
+  QSet<int> m_requested_levels;
+  QVector<qint64> m_time_to_visible;
+  qint64 m_last_reception_time = 0;
+  int m_number_of_tiles = 0;
+  int m_number_of_wasted_tiles = 0;
+  qint64 m_number_of_wasted_bytes = 0;
+};
+
+/***************************************************************************************************/
+
+class ViewportStep
+{
+ public:
+  double longitude;
+  double latitude;
+  int zoom_level;
+};
+
+class TestQcWmtsFetchBenchmark: public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void pan_sequence();
+  void zoom_sequence();
+  void zoom_settle_sequence();
+  void lossy_server();
+
+private:
+  void run(const QString & name, const QList<ViewportStep> & steps, int step_interval,
+           int zoom_settle_interval = QcMapViewLayer::DEFAULT_ZOOM_SETTLE_INTERVAL);
+
+private:
+  QcWmtsTestServer m_server;
+  QSet<int> m_requested_levels; // levels requested to the fetcher by the last run
+};
+
+void
+TestQcWmtsFetchBenchmark::initTestCase()
+{
+  QVERIFY(m_server.start());
+  m_server.set_seed(1);
+  m_server.set_latency(50);
+  m_server.set_jitter(20);
+  m_server.set_payload_size(20 * 1024);
+}
+
+void
+TestQcWmtsFetchBenchmark::run(const QString & name, const QList<ViewportStep> & steps, int step_interval,
+                              int zoom_settle_interval)
+{
+  QcWmtsTestPlugin plugin(m_server.serverPort());
+  plugin.wmts_manager()->tile_cache()->clear_all();
+  FetchStatistics statistics(plugin.wmts_manager());
+  m_server.reset_statistics();
+
+  QcMapView map_view;
+  map_view.set_zoom_settle_interval(zoom_settle_interval);
+  map_view.viewport()->set_viewport_size(QSize(1024, 768), 1.);
+  map_view.add_layer(plugin.layers().first());
+
+  for (const ViewportStep & step : steps) {
+    map_view.viewport()->set_zoom_level(step.zoom_level);
+    map_view.viewport()->set_center(QcWgsCoordinate(step.longitude, step.latitude));
+    QTest::qWait(step_interval);
+  }
+
+  QTRY_VERIFY_WITH_TIMEOUT(statistics.number_of_pending_tiles() == 0, 60000);
+
+  statistics.report(name);
+  qInfo() << "server" << m_server.number_of_requests() << "requests"
+          << m_server.number_of_errors() << "errors"
+          << m_server.number_of_bytes_sent() << "bytes";
+
+  m_requested_levels = statistics.requested_levels();
+}
+
+void
+TestQcWmtsFetchBenchmark::pan_sequence()
+{
+  // Pan eastward by about a quarter of the viewport width per step, 233 px at zoom 14
+  QList<ViewportStep> steps;
+  for (int i = 0; i < 20; i++)
+    steps << ViewportStep({6.0 + i * .02, 45.0, 14});
+  run(QStringLiteral("pan"), steps, 50);
+}
+
+void
+TestQcWmtsFetchBenchmark::zoom_sequence()
+{
+  // Zoom in then out, intermediate levels are cancelled before completion
+  QList<ViewportStep> steps;
+  for (int level = 8; level <= 16; level++)
+    steps << ViewportStep({6.0, 45.0, level});
+  for (int level = 15; level >= 10; level--)
+    steps << ViewportStep({6.0, 45.0, level});
+  run(QStringLiteral("zoom"), steps, 30, 0);
+}
+
+void
+TestQcWmtsFetchBenchmark::zoom_settle_sequence()
+{
+  // Same zoom with the fetches deferred until the zoom level is stable
+  QList<ViewportStep> steps;
+  for (int level = 8; level <= 16; level++)
+    steps << ViewportStep({6.0, 45.0, level});
+  for (int level = 15; level >= 10; level--)
+    steps << ViewportStep({6.0, 45.0, level});
+  run(QStringLiteral("zoom settle"), steps, 30);
+
+  // Only the last level is fetched
+  QVERIFY(m_requested_levels.contains(10));
+  for (int level = 8; level <= 16; level++)
+    if (level != 10)
+      QVERIFY(!m_requested_levels.contains(level));
+}
+
+void
+TestQcWmtsFetchBenchmark::lossy_server()
+{
+  m_server.set_error_rate(.1);
+  QList<ViewportStep> steps;
+  for (int i = 0; i < 5; i++)
+    steps << ViewportStep({2.0 + i * .02, 48.8, 15});
+  run(QStringLiteral("lossy"), steps, 100);
+  m_server.set_error_rate(0);
+}
+
+/***************************************************************************************************/
+
+QTEST_MAIN(TestQcWmtsFetchBenchmark)
+#include "test_wmts_fetch_benchmark.moc"
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -0,0 +1,220 @@
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#include "wmts_test_server.h"
+
+#include <QBuffer>
+#include <QImage>
+#include <QTimer>
+#include <QtDebug>
+
+/**************************************************************************************************/
+
+constexpr int TILE_SIZE = 256;
+constexpr int NUMBER_OF_LEVELS = 20;
+
+QcWmtsTestServer::QcWmtsTestServer(QObject * parent)
+  : QTcpServer(parent),
+    m_latency(0),
+    m_jitter(0),
+    m_error_rate(0),
+    m_payload(),
+    m_clock(),
+    m_buffers(),
+    m_last_response_time(),
+    m_number_of_requests(0),
+    m_number_of_errors(0),
+    m_number_of_bytes_sent(0)
+{
+  set_payload_size(0);
+  m_clock.start();
+}
+
+QcWmtsTestServer::~QcWmtsTestServer()
+{}
+
+bool
+QcWmtsTestServer::start()
+{
+  return listen(QHostAddress::LocalHost, 0);
+}
+
+void
+QcWmtsTestServer::set_seed(unsigned int seed)
+{
+  qsrand(seed);
+}
+
+void
+QcWmtsTestServer::set_payload_size(int payload_size)
+{
+  // A valid image, decoders ignore the padding after the PNG end chunk
+  QImage image(TILE_SIZE, TILE_SIZE, QImage::Format_RGB32);
+  image.fill(Qt::darkGreen);
+  m_payload.clear();
+  QBuffer buffer(&m_payload);
+  buffer.open(QIODevice::WriteOnly);
+  image.save(&buffer, "PNG");
+  if (m_payload.size() < payload_size)
+    m_payload.append(QByteArray(payload_size - m_payload.size(), '\0'));
+}
+
+void
+QcWmtsTestServer::reset_statistics()
+{
+  m_number_of_requests = 0;
+  m_number_of_errors = 0;
+  m_number_of_bytes_sent = 0;
+}
+
+void
+QcWmtsTestServer::incomingConnection(qintptr socket_descriptor)
+{
+  QTcpSocket * socket = new QTcpSocket(this);
+  socket->setSocketDescriptor(socket_descriptor);
+  connect(socket, &QTcpSocket::readyRead, this, &QcWmtsTestServer::read_requests);
+  connect(socket, &QTcpSocket::disconnected, this, &QcWmtsTestServer::socket_disconnected);
+}
+
+void
+QcWmtsTestServer::read_requests()
+{
+  QTcpSocket * socket = qobject_cast<QTcpSocket *>(sender());
+  if (!socket)
+    return;
+
+  // GET requests don't have a body, thus a request ends with an empty line
+  QByteArray & buffer = m_buffers[socket];
+  buffer += socket->readAll();
+  int end;
+  while ((end = buffer.indexOf("\r\n\r\n")) != -1) {
+    buffer.remove(0, end + 4);
+    schedule_response(socket);
+  }
+}
+
+void
+QcWmtsTestServer::socket_disconnected()
+{
+  QTcpSocket * socket = qobject_cast<QTcpSocket *>(sender());
+  if (!socket)
+    return;
+
+  m_buffers.remove(socket);
+  m_last_response_time.remove(socket);
+  socket->deleteLater();
+}
+
+void
+QcWmtsTestServer::schedule_response(QTcpSocket * socket)
+{
+  m_number_of_requests++;
+
+  int delay = m_latency;
+  if (m_jitter > 0)
+    delay += qrand() % (2 * m_jitter + 1) - m_jitter;
+  bool error = m_error_rate > 0 and qrand() < m_error_rate * RAND_MAX;
+
+  qint64 now = m_clock.elapsed();
+  qint64 response_time = qMax(now + qMax(delay, 0), m_last_response_time.value(socket, 0));
+  m_last_response_time.insert(socket, response_time);
+
+  QPointer<QTcpSocket> socket_pointer(socket);
+  QTimer::singleShot(response_time - now, this, [this, socket_pointer, error]() {
+      send_response(socket_pointer, error);
+    });
+}
+
+void
+QcWmtsTestServer::send_response(QPointer<QTcpSocket> socket, bool error)
+{
+  if (socket.isNull() or socket->state() != QAbstractSocket::ConnectedState)
+    return;
+
+  QByteArray header;
+  if (error) {
+    m_number_of_errors++;
+    header = "HTTP/1.1 503 Service Unavailable\r\n"
+      "Content-Length: 0\r\n"
+      "Connection: keep-alive\r\n"
+      "\r\n";
+    socket->write(header);
+  } else {
+    header = "HTTP/1.1 200 OK\r\n"
+      "Content-Type: image/png\r\n"
+      "Content-Length: " + QByteArray::number(m_payload.size()) + "\r\n"
+      "Connection: keep-alive\r\n"
+      "\r\n";
+    socket->write(header);
+    socket->write(m_payload);
+    m_number_of_bytes_sent += m_payload.size();
+  }
+}
+
+/**************************************************************************************************/
+
+QcWmtsTestLayer::QcWmtsTestLayer(QcWmtsTestPlugin * plugin, int map_id, const QString & title, int port)
+  : QcWmtsPluginLayer(plugin, map_id, map_id, title, title.toLower(), QLatin1Literal("png")),
+    m_port(port)
+{}
+
+QcWmtsTestLayer::~QcWmtsTestLayer()
+{}
+
+QUrl
+QcWmtsTestLayer::url(const QcTileSpec & tile_spec) const
+{
+  return QUrl(QStringLiteral("http://127.0.0.1:") +
+              QString::number(m_port) + QLatin1Char('/') +
+              QString::number(map_id()) + QLatin1Char('/') +
+              QString::number(tile_spec.level()) + QLatin1Char('/') +
+              QString::number(tile_spec.x()) + QLatin1Char('/') +
+              QString::number(tile_spec.y()) +
+              QLatin1Char('.') + image_format());
+}
+
+/**************************************************************************************************/
+
+const QString QcWmtsTestPlugin::PLUGIN_NAME = "wmts-test";
+
+QcWmtsTestPlugin::QcWmtsTestPlugin(int port)
+  : QcWmtsPlugin(PLUGIN_NAME, QLatin1Literal("WMTS Test"),
+                 new QcMercatorTileMatrixSet(NUMBER_OF_LEVELS, TILE_SIZE))
+{
+  add_layer(new QcWmtsTestLayer(this, 1, QLatin1Literal("Map"), port));
+  add_layer(new QcWmtsTestLayer(this, 2, QLatin1Literal("Overlay"), port));
+}
+
+QcWmtsTestPlugin::~QcWmtsTestPlugin()
+{}
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
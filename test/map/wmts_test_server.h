@@ -0,0 +1,143 @@
+// -*- mode: c++ -*-
+
+/***************************************************************************************************
+**
+** $QTCARTO_BEGIN_LICENSE:GPL3$
+**
+** Copyright (C) 2016 Fabrice Salvaire
+** Contact: http://www.fabrice-salvaire.fr
+**
+** This file is part of the QtCarto library.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+** $QTCARTO_END_LICENSE$
+**
+***************************************************************************************************/
+
+/**************************************************************************************************/
+
+#ifndef __WMTS_TEST_SERVER_H__
+#define __WMTS_TEST_SERVER_H__
+
+/**************************************************************************************************/
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "wmts/wmts_plugin.h"
+
+/**************************************************************************************************/
+
+/*! Localhost HTTP server serving synthetic tiles, a stand-in for a WMTS provider.
+ *
+ * Any GET request is answered by a PNG tile padded to the payload size, after a delay of
+ * latency +/- jitter.  A fraction of the requests given by the error rate is answered by a 503.
+ */
+class QcWmtsTestServer : public QTcpServer
+{
+  Q_OBJECT
+
+ public:
+  QcWmtsTestServer(QObject * parent = nullptr);
+  ~QcWmtsTestServer();
+
+  bool start(); // listen on a free localhost port
+
+  int latency() const { return m_latency; } // ms
+  void set_latency(int latency) { m_latency = latency; }
+
+  int jitter() const { return m_jitter; } // ms
+  void set_jitter(int jitter) { m_jitter = jitter; }
+
+  double error_rate() const { return m_error_rate; }
+  void set_error_rate(double error_rate) { m_error_rate = error_rate; }
+
+  int payload_size() const { return m_payload.size(); }
+  void set_payload_size(int payload_size);
+
+  void set_seed(unsigned int seed);
+
+  int number_of_requests() const { return m_number_of_requests; }
+  int number_of_errors() const { return m_number_of_errors; }
+  qint64 number_of_bytes_sent() const { return m_number_of_bytes_sent; }
+  void reset_statistics();
+
+ protected:
+  void incomingConnection(qintptr socket_descriptor);
+
+ private slots:
+  void read_requests();
+  void socket_disconnected();
+
+ private:
+  void schedule_response(QTcpSocket * socket);
+  void send_response(QPointer<QTcpSocket> socket, bool error);
+
+ private:
+  int m_latency;
+  int m_jitter;
+  double m_error_rate;
+  QByteArray m_payload;
+  QElapsedTimer m_clock;
+  QHash<QTcpSocket *, QByteArray> m_buffers;
+  QHash<QTcpSocket *, qint64> m_last_response_time; // responses are sent in order on a connection
+  int m_number_of_requests;
+  int m_number_of_errors;
+  qint64 m_number_of_bytes_sent;
+};
+
+/**************************************************************************************************/
+
+class QcWmtsTestPlugin;
+
+class QcWmtsTestLayer : public QcWmtsPluginLayer
+{
+ public:
+  QcWmtsTestLayer(QcWmtsTestPlugin * plugin, int map_id, const QString & title, int port);
+  ~QcWmtsTestLayer();
+
+  QUrl url(const QcTileSpec & tile_spec) const;
+
+ private:
+  int m_port;
+};
+
+/*! WMTS plugin pointing to a QcWmtsTestServer.
+ */
+class QcWmtsTestPlugin : public QcWmtsPlugin
+{
+  Q_OBJECT
+
+ public:
+  static const QString PLUGIN_NAME;
+
+ public:
+  QcWmtsTestPlugin(int port);
+  ~QcWmtsTestPlugin();
+};
+
+/**************************************************************************************************/
+
+#endif /* __WMTS_TEST_SERVER_H__ */
+
+/***************************************************************************************************
+ *
+ * End
+ *
+ **************************************************************************************************/
@@ -26,54 +26,455 @@
 
 /**************************************************************************************************/
 
+#include <algorithm>
+#include <cstdlib>
+
+#include <QCommandLineParser>
 #include <QCoreApplication>
-#include <QThread>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
 #include <QTimer>
 #include <QtDebug>
 
 /**************************************************************************************************/
 
 #include "cache/offline_cache.h"
-#include "coordinate/mercator.h"
 #include "coordinate/wgs84.h"
+#include "geo_data_format/gpx.h"
 #include "geometry/polygon.h"
+#include "geometry/tiled_corridor.h"
 #include "geometry/vector.h"
 #include "tools/logger.h"
+#include "wmts/wmts_network_tile_fetcher.h"
 #include "wmts/wmts_plugin_manager.h"
 
-// #include "map/tile_loader.h"
+/***************************************************************************************************/
+
+constexpr int EXIT_DOWNLOAD_ERROR = 1;
+constexpr int EXIT_USAGE_ERROR = 2;
+
+constexpr int CHECKPOINT_INTERVAL = 1000; // ms
+constexpr int MAX_CHECKS_PER_FILL = 1000; // offline cache lookups before returning to the event loop
+constexpr int RETRY_DELAY = 1000; // ms
 
 /***************************************************************************************************/
 
-class TileFetcherHelper : public QObject
+class TileRun
 {
-  Q_OBJECT;
-
  public:
-  TileFetcherHelper(QcOfflineTileCache * offline_cache)
-    : m_offline_cache(offline_cache)
+  TileRun()
+    : level(0), y(0), interval()
+  {}
+
+  TileRun(int level, int y, const QcIntervalInt & interval)
+    : level(level), y(y), interval(interval)
   {}
 
+  int level;
+  int y;
+  QcIntervalInt interval;
+};
+
+typedef QVector<TileRun> TileRunList;
+
+/**************************************************************************************************/
+
+/* Download the tiles of a list of runs using a bounded window of pending requests.
+ *
+ * Runs are issued in order.  The checkpoint is the index of the oldest run having pending or
+ * failed tiles, it is committed in the offline database together with the tiles.
+ */
+class TileLoader : public QObject
+{
+  Q_OBJECT;
+
  public:
-  int number_of_received_tiles() const {
-    return m_finished_tile.size();
-  }
-  bool has_received(const QcTileSpec & tile_spec) const {
-    return m_finished_tile.contains(tile_spec);
-  }
+  TileLoader(QcWmtsPlugin * plugin, QcOfflineTileCache * offline_cache,
+             const TileRunList & runs, int map_id, const QString & job_name,
+             int number_of_requests, double request_rate, int number_of_retries);
+  ~TileLoader();
+
+  qint64 number_of_tiles() const { return m_number_of_tiles; }
 
  public slots:
-  void tile_finished(const QcTileSpec & tile_spec, const QByteArray & bytes, const QString & format) {
-    qInfo() << "Tile finished" << tile_spec;
-    m_finished_tile.push_back(tile_spec);
-    m_offline_cache->insert(tile_spec, bytes, format);
-  }
+  void start();
+
+ signals:
+  void finished(int exit_code);
+
+ private slots:
+  void fill_queue();
+  void tile_finished(const QcTileSpec & tile_spec, const QByteArray & bytes, const QString & format);
+  void tile_error(const QcTileSpec & tile_spec, const QString & error_string);
+  void write_checkpoint();
+
+ private:
+  int checkpoint_run() const;
+  void release_run(int run_position);
+  void report_progress();
+  void check_done();
 
  private:
+  QcWmtsPlugin * m_plugin;
   QcOfflineTileCache * m_offline_cache;
-  QList<QcTileSpec> m_finished_tile;
+  QcWmtsNetworkTileFetcher m_tile_fetcher;
+  TileRunList m_runs;
+  int m_map_id;
+  QString m_job_name;
+  int m_window;
+  int m_number_of_retries;
+  qint64 m_number_of_tiles;
+
+  // Issue position
+  int m_run_position;
+  bool m_run_started;
+  int m_x;
+
+  QHash<QcTileSpec, int> m_pending; // tile -> run position
+  QMap<int, int> m_run_outstanding; // run position -> number of pending or failed tiles
+  QHash<QcTileSpec, int> m_retries;
+
+  QTimer m_checkpoint_timer;
+  QElapsedTimer m_elapsed_timer;
+  qint64 m_last_report_time;
+  qint64 m_last_report_bytes;
+  qint64 m_number_of_downloaded_tiles;
+  qint64 m_number_of_skipped_tiles;
+  qint64 m_number_of_failed_tiles;
+  qint64 m_number_of_bytes;
+  bool m_done;
 };
 
+TileLoader::TileLoader(QcWmtsPlugin * plugin, QcOfflineTileCache * offline_cache,
+                       const TileRunList & runs, int map_id, const QString & job_name,
+                       int number_of_requests, double request_rate, int number_of_retries)
+  : QObject(),
+    m_plugin(plugin),
+    m_offline_cache(offline_cache),
+    m_tile_fetcher(plugin),
+    m_runs(runs),
+    m_map_id(map_id),
+    m_job_name(job_name),
+    m_window(2 * number_of_requests), // keep the fetcher queue busy
+    m_number_of_retries(number_of_retries),
+    m_number_of_tiles(0),
+    m_run_position(0),
+    m_run_started(false),
+    m_x(0),
+    m_pending(),
+    m_run_outstanding(),
+    m_retries(),
+    m_checkpoint_timer(),
+    m_elapsed_timer(),
+    m_last_report_time(0),
+    m_last_report_bytes(0),
+    m_number_of_downloaded_tiles(0),
+    m_number_of_skipped_tiles(0),
+    m_number_of_failed_tiles(0),
+    m_number_of_bytes(0),
+    m_done(false)
+{
+  for (const TileRun & run : m_runs)
+    m_number_of_tiles += run.interval.length();
+
+  // A dedicated fetcher, thus tiles don't go through the online cache
+  m_tile_fetcher.set_maximum_number_of_requests(number_of_requests);
+  m_tile_fetcher.set_request_rate(request_rate);
+
+  // Fetcher holds its mutex when it emits
+  connect(&m_tile_fetcher, &QcWmtsTileFetcher::tile_finished,
+          this, &TileLoader::tile_finished,
+          Qt::QueuedConnection);
+  connect(&m_tile_fetcher, &QcWmtsTileFetcher::tile_error,
+          this, &TileLoader::tile_error,
+          Qt::QueuedConnection);
+
+  m_checkpoint_timer.setInterval(CHECKPOINT_INTERVAL);
+  connect(&m_checkpoint_timer, &QTimer::timeout, this, &TileLoader::write_checkpoint);
+}
+
+TileLoader::~TileLoader()
+{}
+
+void
+TileLoader::start()
+{
+  int checkpoint = m_offline_cache->database()->checkpoint(m_job_name);
+  if (checkpoint > 0 and checkpoint < m_runs.size()) {
+    qInfo() << "Resume job" << m_job_name << "at run" << checkpoint << "/" << m_runs.size();
+    m_run_position = checkpoint;
+  }
+
+  m_elapsed_timer.start();
+  m_offline_cache->begin_batch();
+  m_checkpoint_timer.start();
+  fill_queue();
+}
+
+int
+TileLoader::checkpoint_run() const
+{
+  if (m_run_outstanding.isEmpty())
+    return m_run_position;
+  else
+    return m_run_outstanding.firstKey();
+}
+
+void
+TileLoader::release_run(int run_position)
+{
+  auto it = m_run_outstanding.find(run_position);
+  if (it != m_run_outstanding.end() and --it.value() == 0)
+    m_run_outstanding.erase(it);
+}
+
+void
+TileLoader::fill_queue()
+{
+  if (m_done)
+    return;
+
+  QcTileSpecSet tiles_added;
+  int number_of_checks = 0;
+  while (m_run_position < m_runs.size() and m_pending.size() < m_window) {
+    if (number_of_checks == MAX_CHECKS_PER_FILL) {
+      QTimer::singleShot(0, this, SLOT(fill_queue()));
+      break;
+    }
+
+    const TileRun & run = m_runs[m_run_position];
+    if (!m_run_started) {
+      m_x = run.interval.inf();
+      m_run_outstanding.insert(m_run_position, 1); // released when the run is fully issued
+      m_run_started = true;
+    }
+    if (m_x > run.interval.sup()) {
+      release_run(m_run_position);
+      m_run_position++;
+      m_run_started = false;
+      continue;
+    }
+
+    QcTileSpec tile_spec = m_plugin->create_tile_spec(m_map_id, run.level, m_x++, run.y);
+    number_of_checks++;
+    if (m_offline_cache->contains(tile_spec)) {
+      m_number_of_skipped_tiles++;
+      continue;
+    }
+
+    m_pending.insert(tile_spec, m_run_position);
+    m_run_outstanding[m_run_position]++;
+    tiles_added << tile_spec;
+  }
+
+  if (!tiles_added.isEmpty())
+    m_tile_fetcher.update_tile_requests(tiles_added, QcTileSpecSet());
+
+  check_done();
+}
+
+void
+TileLoader::tile_finished(const QcTileSpec & tile_spec, const QByteArray & bytes, const QString & format)
+{
+  auto it = m_pending.find(tile_spec);
+  if (it == m_pending.end())
+    return;
+
+  m_offline_cache->insert(tile_spec, bytes, format);
+  m_number_of_downloaded_tiles++;
+  m_number_of_bytes += bytes.size();
+
+  release_run(it.value());
+  m_pending.erase(it);
+  m_retries.remove(tile_spec);
+
+  fill_queue();
+}
+
+void
+TileLoader::tile_error(const QcTileSpec & tile_spec, const QString & error_string)
+{
+  if (!m_pending.contains(tile_spec))
+    return;
+
+  int retry = m_retries.value(tile_spec, 0);
+  if (retry < m_number_of_retries) {
+    m_retries.insert(tile_spec, retry + 1);
+    int delay = RETRY_DELAY << retry;
+    QTimer::singleShot(delay, this, [this, tile_spec]() {
+        if (m_pending.contains(tile_spec)) {
+          QcTileSpecSet tiles_added;
+          tiles_added << tile_spec;
+          m_tile_fetcher.update_tile_requests(tiles_added, QcTileSpecSet());
+        }
+      });
+  } else {
+    qWarning() << "Failed to download" << tile_spec << error_string;
+    m_number_of_failed_tiles++;
+    // The run stays outstanding, thus the checkpoint cannot pass the failed tile
+    m_pending.remove(tile_spec);
+    m_retries.remove(tile_spec);
+    fill_queue();
+  }
+}
+
+void
+TileLoader::write_checkpoint()
+{
+  // Tiles and checkpoint are committed in the same transaction
+  m_offline_cache->database()->set_checkpoint(m_job_name, checkpoint_run());
+  m_offline_cache->end_batch();
+  if (!m_done)
+    m_offline_cache->begin_batch();
+
+  report_progress();
+}
+
+void
+TileLoader::report_progress()
+{
+  qint64 elapsed = m_elapsed_timer.elapsed();
+  qint64 interval = elapsed - m_last_report_time;
+  double throughput = interval > 0 ? double(m_number_of_bytes - m_last_report_bytes) / interval : 0; // kB/s
+  double mean_rate = elapsed > 0 ? m_number_of_downloaded_tiles * 1000. / elapsed : 0;
+  m_last_report_time = elapsed;
+  m_last_report_bytes = m_number_of_bytes;
+
+  qint64 number_of_processed_tiles =
+    m_number_of_downloaded_tiles + m_number_of_skipped_tiles + m_number_of_failed_tiles;
+  qInfo().noquote()
+    << QStringLiteral("%1/%2 tiles").arg(number_of_processed_tiles).arg(m_number_of_tiles)
+    << QStringLiteral("downloaded %1 skipped %2 failed %3")
+         .arg(m_number_of_downloaded_tiles).arg(m_number_of_skipped_tiles).arg(m_number_of_failed_tiles)
+    << QStringLiteral("%1 MB").arg(m_number_of_bytes / 1e6, 0, 'f', 1)
+    << QStringLiteral("%1 tiles/s %2 kB/s").arg(mean_rate, 0, 'f', 1).arg(throughput, 0, 'f', 1)
+    << QStringLiteral("running %1").arg(m_tile_fetcher.number_of_running_requests());
+}
+
+void
+TileLoader::check_done()
+{
+  if (m_done or m_run_position < m_runs.size() or !m_pending.isEmpty())
+    return;
+
+  m_done = true;
+  m_checkpoint_timer.stop();
+
+  // Keep the checkpoint if some tiles failed, in order to retry them on the next run
+  if (m_number_of_failed_tiles)
+    m_offline_cache->database()->set_checkpoint(m_job_name, checkpoint_run());
+  else
+    m_offline_cache->database()->delete_checkpoint(m_job_name);
+  m_offline_cache->end_batch();
+
+  report_progress();
+  emit finished(m_number_of_failed_tiles ? EXIT_DOWNLOAD_ERROR : EXIT_SUCCESS);
+}
+
+/**************************************************************************************************/
+
+// Parse a list of comma separated numbers
+static bool
+parse_numbers(const QString & string, QVector<double> & numbers)
+{
+  numbers.clear();
+  for (const QString & item : string.split(',', QString::SkipEmptyParts)) {
+    bool ok;
+    numbers << item.trimmed().toDouble(&ok);
+    if (!ok)
+      return false;
+  }
+  return true;
+}
+
+// Parse "level" or "inf-sup"
+static bool
+parse_level_interval(const QString & string, QcIntervalInt & levels)
+{
+  QStringList items = string.split('-');
+  bool ok_inf;
+  bool ok_sup;
+  int inf = items.first().toInt(&ok_inf);
+  int sup = items.last().toInt(&ok_sup);
+  if (items.size() > 2 or !ok_inf or !ok_sup or inf > sup)
+    return false;
+  levels = QcIntervalInt(inf, sup);
+  return true;
+}
+
+static void
+append_runs(TileRunList & tile_runs, int level, const QcTiledPolygonRunList & runs)
+{
+  for (const QcTiledPolygonRun & run : runs)
+    tile_runs << TileRun(level, run.y(), run.interval());
+}
+
+static TileRunList
+polygon_runs(const QcTileMatrixSet & tile_matrix_set, const QVector<double> & coordinates, const QcIntervalInt & levels)
+{
+  // Map the polygon to the tile matrix referential
+  const QcProjection & projection = tile_matrix_set.projection();
+  QcPolygon::VertexListType vertexes;
+  for (int i = 0; i < coordinates.size(); i += 2) {
+    QcWgsCoordinate coordinate(coordinates[i], coordinates[i+1]);
+    QcVectorDouble vertex = coordinate.transform(projection);
+    vertexes << (vertex - tile_matrix_set.origin()) * tile_matrix_set.scale();
+  }
+
+  // The rasteriser requires a clockwise polygon
+  double signed_area = 0;
+  for (int i = 0; i < vertexes.size(); i++) {
+    const QcVectorDouble & p0 = vertexes[i];
+    const QcVectorDouble & p1 = vertexes[(i + 1) % vertexes.size()];
+    signed_area += p0.x() * p1.y() - p1.x() * p0.y();
+  }
+  if (signed_area > 0)
+    std::reverse(vertexes.begin(), vertexes.end());
+  QcPolygon polygon(vertexes);
+
+  TileRunList tile_runs;
+  for (int level = levels.inf(); level <= levels.sup(); level++) {
+    const QcTileMatrix & tile_matrix = tile_matrix_set[level];
+    QcTiledPolygon tiled_polygon = polygon.intersec_with_grid(tile_matrix.tile_length_m());
+    int last_index = tile_matrix.mosaic_size() - 1;
+    QcIntervalInt valid_interval(0, last_index);
+    QcTiledPolygonRunList runs;
+    for (const QcTiledPolygonRun & run : tiled_polygon.runs()) {
+      if (!valid_interval.contains(run.y()) or !run.interval().intersect(valid_interval))
+        continue;
+      runs << QcTiledPolygonRun(run.y(), run.interval() & valid_interval);
+    }
+    append_runs(tile_runs, level, runs);
+  }
+
+  return tile_runs;
+}
+
+static TileRunList
+gpx_runs(const QcTileMatrixSet & tile_matrix_set, const QString & gpx_path, double radius, const QcIntervalInt & levels)
+{
+  QcGpx gpx = QcGpxReader().read(gpx_path);
+  const QcProjection & projection = tile_matrix_set.projection();
+
+  QcPathDoubleList paths;
+  for (const QcTrack & track : gpx.tracks())
+    paths << QcCorridorTileSet::track_to_paths(track, projection);
+  for (const QcRoute & route : gpx.routes()) {
+    QcPathDouble path;
+    for (const QcWayPoint & waypoint : route.waypoints())
+      path.add_vertex(waypoint.coordinate().transform(projection));
+    paths << path;
+  }
+
+  QcCorridorTileSet corridor_tile_set(tile_matrix_set, paths, radius, levels);
+  TileRunList tile_runs;
+  for (int level = levels.inf(); level <= levels.sup(); level++)
+    append_runs(tile_runs, level, corridor_tile_set.level(level).runs());
+
+  return tile_runs;
+}
+
 /**************************************************************************************************/
 
 class Application : public QCoreApplication
@@ -82,125 +483,130 @@ class Application : public QCoreApplication
 
 public:
   Application(int & argc, char ** argv);
+  ~Application();
 
 public slots:
   void main_task();
+
+private:
+  TileLoader * m_tile_loader;
 };
 
 Application::Application(int & argc, char ** argv)
-  : QCoreApplication(argc, argv)
+  : QCoreApplication(argc, argv),
+    m_tile_loader(nullptr)
 {
+  setApplicationName(QStringLiteral("tile-loader"));
   QTimer::singleShot(0, this, SLOT(main_task()));
 }
 
+Application::~Application()
+{
+  delete m_tile_loader;
+}
+
 void
 Application::main_task()
 {
-  QcWmtsPluginManager & plugin_manager = QcWmtsPluginManager::instance();
-
-  QcWmtsPlugin * geoportail_plugin = plugin_manager["geoportail"];
-
-  const QcTileMatrixSet & tile_matrix_set = geoportail_plugin->tile_matrix_set();
-
-  // QcTileLoader tile_loader(geoportail_plugin);
-
-  // Annecy
-  // double longitude = 6.311331853277862;
-  // double latitude = 45.956298260767284;
-
-  // Bezons
-  // double longitude = 2.206142;
-  // double latitude = 48.924482;
-
-  // Bérarde
-  // double longitude = 6.2914;
-  // double latitude = 44.9328;
-
-  // Vallouise
-  // double longitude = 6.4895;
-  // double latitude = 44.8461;
-
-  // Centre
-  // double longitude = 3;
-  // double latitude = 46.5;
-
-  // Freissinieres
-  double longitude = 6.5383;
-  double latitude = 44.7523;
-
-  QcWgsCoordinate center_wsg84(longitude, latitude);
-  QcPseudoWebMercatorCoordinate center_mercator = center_wsg84.pseudo_web_mercator();
-  QcVectorDouble center = center_mercator.vector();;
-  double radius_m = 40 * 1000;
-  QcVectorDouble half_diagonal_m(radius_m, radius_m);
-
-  QcVectorDouble point1 = center + half_diagonal_m;
-  QcVectorDouble point2 = center + half_diagonal_m.mirror_x();
-  QcVectorDouble point3 = center + half_diagonal_m.rotate_180();
-  QcVectorDouble point4 = center + half_diagonal_m.mirror_y();
-  QcPolygon polygon;
-  polygon.add_vertex(point3);
-  polygon.add_vertex(point2);
-  polygon.add_vertex(point1);
-  polygon.add_vertex(point4);
-
-  const QcInterval2DDouble & interval = polygon.interval();
-  qInfo() << "polygon interval"
-          << "[" << interval.x().inf() << ", " << interval.x().sup() << "]"
-          << "x"
-          << "[" << interval.y().inf() << ", " << interval.y().sup() << "]";
-
-  QcWmtsNetworkTileFetcher * tile_fetcher = geoportail_plugin->tile_fetcher(); // subclass QcGeoportailPlugin ???
-
-  QcOfflineTileCache * offline_cache = geoportail_plugin->wmts_manager()->tile_cache()->offline_cache();
-  TileFetcherHelper tile_fetcher_helper(offline_cache);
-  QObject::connect(tile_fetcher, &QcWmtsNetworkTileFetcher::tile_finished,
-                   &tile_fetcher_helper, &TileFetcherHelper::tile_finished);
-
-  QString layer_title = "Carte topographique";
-  // QString layer_title = "Carte"; // error
-  // QString layer_title = "Vue aérienne";
-  int map_id = geoportail_plugin->layer(layer_title)->map_id();
-
-  QSet<QcTileSpec> tiles_added;
-  QSet<QcTileSpec> tiles_removed;
-
-  // Fixme: level <= 10 : any tiles
-  for (int level = 0; level <= 16; level++) {
-    double tile_length_m = tile_matrix_set[level].tile_length_m();
-    QcTiledPolygon tiled_polygon = polygon.intersec_with_grid(tile_length_m);
-    for (const QcTiledPolygonRun & run:  tiled_polygon.runs()) {
-      const QcIntervalInt & run_interval = run.interval();
-      qInfo() << "Run " << run.y() << " [" << run_interval.inf() << ", " << run_interval.sup() << "]";
-      for (int x = run_interval.inf(); x <= run_interval.sup(); x++) {
-        QcTileSpec tile_spec = geoportail_plugin->create_tile_spec(map_id, level, x, run.y());
-        if (offline_cache->contains(tile_spec)) {
-          qInfo() << "Ok" << tile_spec;
-        }
-        else {
-          qInfo() << "Missing" << tile_spec;
-          tiles_added << tile_spec;
-        }
-      }
-    }
-  }
-  int number_of_tiles = tiles_added.size();
-
-  // Add tiles to disk
-  //  tile_fetcher::tile_finished -> QcWmtsManager::fetcher_tile_finished -> tile_cache()->insert
-  //
-  // Fixme:
-  //   check if on disk
-  //   just save
-  //   don't count in online cache
-
-  tile_fetcher->update_tile_requests(tiles_added, tiles_removed);
-  while (tile_fetcher_helper.number_of_received_tiles() != number_of_tiles) {
-    processEvents();
-    // QThread::msleep(10);
-  }
-
-  exit(0);
+  QCommandLineParser parser;
+  parser.setApplicationDescription(QStringLiteral("Download tiles in the offline cache"));
+  parser.addHelpOption();
+
+  QCommandLineOption provider_option(QStringLiteral("provider"), QStringLiteral("WMTS provider"),
+                                     QStringLiteral("name"), QStringLiteral("geoportail"));
+  QCommandLineOption layer_option(QStringLiteral("layer"), QStringLiteral("Layer title"),
+                                  QStringLiteral("title"), QStringLiteral("Carte topographique"));
+  QCommandLineOption bbox_option(QStringLiteral("bbox"), QStringLiteral("WGS84 bounding box"),
+                                 QStringLiteral("lon_min,lat_min,lon_max,lat_max"));
+  QCommandLineOption polygon_option(QStringLiteral("polygon"), QStringLiteral("WGS84 polygon"),
+                                    QStringLiteral("lon,lat,lon,lat,..."));
+  QCommandLineOption gpx_option(QStringLiteral("gpx"), QStringLiteral("Download a corridor along the GPX tracks and routes"),
+                                QStringLiteral("path"));
+  QCommandLineOption radius_option(QStringLiteral("radius"), QStringLiteral("Corridor radius [m]"),
+                                   QStringLiteral("radius"), QStringLiteral("1000"));
+  QCommandLineOption levels_option(QStringLiteral("levels"), QStringLiteral("Level or level interval"),
+                                   QStringLiteral("inf-sup"), QStringLiteral("0-16"));
+  QCommandLineOption requests_option(QStringLiteral("requests"), QStringLiteral("Maximum number of concurrent requests"),
+                                     QStringLiteral("number"), QStringLiteral("6"));
+  QCommandLineOption rate_option(QStringLiteral("rate"), QStringLiteral("Maximum number of requests per second, 0 is unlimited"),
+                                 QStringLiteral("rate"), QStringLiteral("0"));
+  QCommandLineOption retries_option(QStringLiteral("retries"), QStringLiteral("Number of retries on error"),
+                                    QStringLiteral("number"), QStringLiteral("3"));
+  QCommandLineOption job_option(QStringLiteral("job"), QStringLiteral("Checkpoint name, default is derived from the input"),
+                                QStringLiteral("name"));
+  QCommandLineOption mean_tile_size_option(QStringLiteral("mean-tile-size"), QStringLiteral("Mean tile size used for estimation [bytes]"),
+                                           QStringLiteral("bytes"), QStringLiteral("20000"));
+  QCommandLineOption dry_run_option(QStringLiteral("dry-run"), QStringLiteral("Only report the number of tiles"));
+  parser.addOptions({provider_option, layer_option,
+        bbox_option, polygon_option, gpx_option, radius_option, levels_option,
+        requests_option, rate_option, retries_option, job_option,
+        mean_tile_size_option, dry_run_option});
+  parser.process(*this);
+
+  auto usage_error = [this](const QString & message) {
+    qCritical().noquote() << message;
+    exit(EXIT_USAGE_ERROR);
+  };
+
+  QcWmtsPlugin * plugin = QcWmtsPluginManager::instance()[parser.value(provider_option)];
+  if (!plugin)
+    return usage_error(QStringLiteral("Unknown provider"));
+  const QcWmtsPluginLayer * layer = plugin->layer(parser.value(layer_option));
+  if (!layer)
+    return usage_error(QStringLiteral("Unknown layer"));
+  const QcTileMatrixSet & tile_matrix_set = plugin->tile_matrix_set();
+
+  QcIntervalInt levels;
+  if (!parse_level_interval(parser.value(levels_option), levels) or
+      levels.inf() < 0 or levels.sup() >= tile_matrix_set.number_of_levels())
+    return usage_error(QStringLiteral("Invalid level interval"));
+
+  TileRunList runs;
+  QString input;
+  QVector<double> numbers;
+  if (parser.isSet(gpx_option)) {
+    bool ok;
+    double radius = parser.value(radius_option).toDouble(&ok);
+    if (!ok or radius <= 0)
+      return usage_error(QStringLiteral("Invalid radius"));
+    input = parser.value(gpx_option) + '@' + parser.value(radius_option);
+    runs = gpx_runs(tile_matrix_set, parser.value(gpx_option), radius, levels);
+  } else if (parser.isSet(bbox_option)) {
+    input = parser.value(bbox_option);
+    if (!parse_numbers(input, numbers) or numbers.size() != 4)
+      return usage_error(QStringLiteral("Invalid bounding box"));
+    double lon_min = numbers[0], lat_min = numbers[1], lon_max = numbers[2], lat_max = numbers[3];
+    QVector<double> coordinates({lon_min, lat_min, lon_min, lat_max, lon_max, lat_max, lon_max, lat_min});
+    runs = polygon_runs(tile_matrix_set, coordinates, levels);
+  } else if (parser.isSet(polygon_option)) {
+    input = parser.value(polygon_option);
+    if (!parse_numbers(input, numbers) or numbers.size() < 6 or numbers.size() % 2)
+      return usage_error(QStringLiteral("Invalid polygon"));
+    runs = polygon_runs(tile_matrix_set, numbers, levels);
+  } else
+    return usage_error(QStringLiteral("An input --bbox, --polygon or --gpx is required"));
+
+  QString job_name = parser.value(job_option);
+  if (job_name.isEmpty())
+    job_name = QStringList({plugin->name(), QString::number(layer->map_id()), input,
+          parser.value(levels_option)}).join('/');
+
+  QcOfflineTileCache * offline_cache = plugin->wmts_manager()->tile_cache()->offline_cache();
+  m_tile_loader = new TileLoader(plugin, offline_cache, runs, layer->map_id(), job_name,
+                                 qMax(parser.value(requests_option).toInt(), 1),
+                                 parser.value(rate_option).toDouble(),
+                                 parser.value(retries_option).toInt());
+
+  qint64 number_of_tiles = m_tile_loader->number_of_tiles();
+  qint64 estimated_bytes = number_of_tiles * parser.value(mean_tile_size_option).toLongLong();
+  qInfo().noquote() << QStringLiteral("%1 tiles in %2 runs, estimated size %3 MB")
+    .arg(number_of_tiles).arg(runs.size()).arg(estimated_bytes / 1e6, 0, 'f', 1);
+
+  if (parser.isSet(dry_run_option))
+    return exit(EXIT_SUCCESS);
+
+  connect(m_tile_loader, &TileLoader::finished, this, &QCoreApplication::exit);
+  m_tile_loader->start();
 }
 
 /**************************************************************************************************/